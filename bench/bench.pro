@@ -0,0 +1,22 @@
+######################################################################
+# Benchmark suite for the mcellGUI models and MDL writer
+######################################################################
+
+CONFIG += c++11 -Wall -Wextra -pedantic
+QT += core gui widgets concurrent testlib
+TEMPLATE = app
+TARGET = mcellBench
+INCLUDEPATH += . ..
+
+# Input
+HEADERS += syntheticModel.hpp ../io.hpp ../molModel.hpp ../keywordModel.hpp \
+           ../paramModel.hpp ../noteWarnModel.hpp ../reactionModel.hpp \
+           ../memoryReport.hpp ../reactionExpansion.hpp ../sweep.hpp \
+           ../symbolModel.hpp ../molSortProxy.hpp
+SOURCES += modelBench.cpp syntheticModel.cpp ../io.cpp ../molModel.cpp \
+           ../keywordModel.cpp ../paramModel.cpp ../noteWarnModel.cpp \
+           ../reactionModel.cpp ../memoryReport.cpp \
+           ../reactionExpansion.cpp ../sweep.cpp ../symbolModel.cpp \
+           ../molSortProxy.cpp
+
+include(../core/core.pri)
@@ -0,0 +1,512 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <QDebug>
+
+#include <algorithm>
+#include <numeric>
+
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "io.hpp"
+#include "memoryReport.hpp"
+#include "molModel.hpp"
+#include "molSortProxy.hpp"
+#include "noteWarnModel.hpp"
+#include "paramModel.hpp"
+#include "reactionExpansion.hpp"
+#include "reactionModel.hpp"
+#include "sweep.hpp"
+#include "syntheticModel.hpp"
+
+
+// ModelBench measures the model and MDL export hot paths for synthetic
+// models of increasing size. The largest model size can be limited via
+// the MCELLGUI_BENCH_MAX environment variable (default 1000000).
+class ModelBench : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void addMol_data();
+  void addMol();
+  void haveMol_data();
+  void haveMol();
+  void sortByD_data();
+  void sortByD();
+  void editMols_data();
+  void editMols();
+  void addReaction_data();
+  void addReaction();
+  void expandTemplates_data();
+  void expandTemplates();
+  void traverse_data();
+  void traverse();
+  void parentLookup_data();
+  void parentLookup();
+  void writeMDL_data();
+  void writeMDL();
+  void sweep_data();
+  void sweep();
+  void stoichiometry_data();
+  void stoichiometry();
+  void snapshot_data();
+  void snapshot();
+  void memory_data();
+  void memory();
+};
+
+
+// addSizes adds the model sizes shared by all benchmarks. Molecule benchmarks
+// use count as the number of species, reaction benchmarks use count as the
+// number of reactions over a tenth as many species.
+static void addSizes() {
+  QTest::addColumn<int>("count");
+  QTest::addColumn<int>("species");
+  QTest::addColumn<int>("reactions");
+
+  int maxCount = 1000000;
+  QByteArray env = qgetenv("MCELLGUI_BENCH_MAX");
+  if (!env.isEmpty()) {
+    maxCount = env.toInt();
+  }
+  for (int count = 1000; count <= maxCount; count *= 10) {
+    int species = std::max(1000, count / 10);
+    QTest::newRow(QString::number(count).toLatin1().data()) << count << species
+      << count;
+  }
+}
+
+
+// report prints the throughput and peak memory usage of a benchmark
+static void report(const QString& what, double items, qint64 nsecs) {
+  double perSec = (nsecs > 0) ? items / (nsecs * 1e-9) : 0.0;
+  qDebug().noquote() << QString("%1: %2 items/s, peak RSS %3 kB")
+    .arg(what).arg(perSec, 0, 'g', 4).arg(peakMemoryKB());
+}
+
+
+// walk visits all items underneath parent via index() and returns the number
+// of visited items
+static long walk(const QAbstractItemModel& model, const QModelIndex& parent) {
+  long count = 0;
+  int rows = model.rowCount(parent);
+  for (int r = 0; r < rows; ++r) {
+    QModelIndex child = model.index(r, 0, parent);
+    count += 1 + walk(model, child);
+  }
+  return count;
+}
+
+
+void ModelBench::addMol_data() {
+  addSizes();
+}
+
+
+// addMol measures the insertion of molecules into an empty MolModel
+void ModelBench::addMol() {
+  QFETCH(int, count);
+  int iters = 0;
+  QElapsedTimer timer;
+  timer.start();
+  QBENCHMARK {
+    MolModel molModel;
+    populateMolecules(&molModel, count);
+    ++iters;
+  }
+  report("addMol", double(count) * iters, timer.nsecsElapsed());
+}
+
+
+void ModelBench::haveMol_data() {
+  addSizes();
+}
+
+
+// haveMol measures a successful lookup of the last molecule and an
+// unsuccessful lookup
+void ModelBench::haveMol() {
+  QFETCH(int, count);
+  MolModel molModel;
+  populateMolecules(&molModel, count);
+  QString last = synthMolName(count - 1);
+  QString missing("missing");
+
+  int iters = 0;
+  QElapsedTimer timer;
+  timer.start();
+  QBENCHMARK {
+    QVERIFY(molModel.haveMol(last));
+    QVERIFY(!molModel.haveMol(missing));
+    ++iters;
+  }
+  report("haveMol", 2.0 * iters, timer.nsecsElapsed());
+}
+
+
+void ModelBench::sortByD_data() {
+  addSizes();
+}
+
+
+// sortByD measures sorting the molecule table by diffusion constant through
+// the numeric MolSortProxy and, for comparison, through a plain
+// QSortFilterProxyModel comparing the displayed strings
+void ModelBench::sortByD() {
+  QFETCH(int, count);
+  MolModel molModel;
+  populateMolecules(&molModel, count);
+  MolSortProxy proxy;
+  proxy.setMolModel(&molModel);
+  QSortFilterProxyModel stringProxy;
+  stringProxy.setSourceModel(&molModel);
+
+  int iters = 0;
+  QElapsedTimer timer;
+  timer.start();
+  QBENCHMARK {
+    proxy.sort(Col::D, iters % 2 == 0 ? Qt::AscendingOrder
+      : Qt::DescendingOrder);
+    ++iters;
+  }
+  report("sortByD", double(count) * iters, timer.nsecsElapsed());
+
+  timer.restart();
+  stringProxy.sort(Col::D, Qt::AscendingOrder);
+  report("sortByD (string compare)", count, timer.nsecsElapsed());
+}
+
+
+void ModelBench::editMols_data() {
+  addSizes();
+}
+
+
+// editMols measures scaling D of all molecules in one bulk edit while a
+// sorted proxy is attached to the model
+void ModelBench::editMols() {
+  QFETCH(int, count);
+  MolModel molModel;
+  populateMolecules(&molModel, count);
+  MolSortProxy proxy;
+  proxy.setMolModel(&molModel);
+  proxy.sort(Col::D, Qt::AscendingOrder);
+  std::vector<int> rows(count);
+  std::iota(rows.begin(), rows.end(), 0);
+  MolEdit edit;
+  QString error;
+  QVERIFY(parseMolEdit("D * 0.5", edit, error));
+
+  int iters = 0;
+  QElapsedTimer timer;
+  timer.start();
+  QBENCHMARK {
+    QCOMPARE(molModel.editMols(rows, edit), count);
+    ++iters;
+  }
+  report("editMols", double(count) * iters, timer.nsecsElapsed());
+}
+
+
+void ModelBench::addReaction_data() {
+  addSizes();
+}
+
+
+// addReaction measures the insertion of reactions into an empty
+// ReactTreeModel connected to the molecule reference counts, followed by
+// the bulk removal of all reactions
+void ModelBench::addReaction() {
+  QFETCH(int, species);
+  QFETCH(int, reactions);
+  MolModel molModel;
+  populateMolecules(&molModel, species);
+
+  int iters = 0;
+  QElapsedTimer timer;
+  timer.start();
+  QBENCHMARK {
+    ReactTreeModel reactModel(&molModel);
+    connect(&reactModel, SIGNAL(molUseChanged(const MolUseDeltas&)),
+      &molModel, SLOT(updateMoleculeUse(const MolUseDeltas&)));
+    populateReactions(&reactModel, &molModel, reactions);
+    reactModel.removeRows(0, reactModel.numReactions());
+    ++iters;
+  }
+  report("addReaction", double(reactions) * iters, timer.nsecsElapsed());
+}
+
+
+void ModelBench::expandTemplates_data() {
+  QTest::addColumn<int>("species");
+  QTest::newRow("100") << 100;
+  QTest::newRow("1000") << 1000;
+}
+
+
+// expandTemplates measures expanding a bimolecular template over all pairs
+// of species, i.e. species^2 reaction combinations, and inserting the
+// resulting reactions with duplicate detection in bulk
+void ModelBench::expandTemplates() {
+  QFETCH(int, species);
+  MolModel molModel;
+  populateMolecules(&molModel, species);
+  QList<ReactionTemplate> templates;
+  QString error;
+  QVERIFY(parseReactionTemplates(
+    "mol_(\\d+) + mol_(\\d+) -> mol_\\1 [1e6] : r_\\1_\\2", templates,
+    error));
+
+  int iters = 0;
+  qint64 expandTime = 0;
+  QElapsedTimer timer;
+  timer.start();
+  QBENCHMARK {
+    QElapsedTimer expandTimer;
+    expandTimer.start();
+    ExpansionResult result = ::expandTemplates(templates, &molModel);
+    expandTime += expandTimer.nsecsElapsed();
+    QCOMPARE(result.reactions.size(), size_t(species) * species);
+    ReactTreeModel reactModel(&molModel);
+    reactModel.addReactions(result.reactions, true);
+    ++iters;
+  }
+  report("expandTemplates (expansion only)",
+    double(species) * species * iters, expandTime);
+  report("expandTemplates", double(species) * species * iters,
+    timer.nsecsElapsed());
+}
+
+
+void ModelBench::traverse_data() {
+  addSizes();
+}
+
+
+// traverse measures a full walk of the reaction tree via index()
+void ModelBench::traverse() {
+  QFETCH(int, species);
+  QFETCH(int, reactions);
+  MolModel molModel;
+  populateMolecules(&molModel, species);
+  ReactTreeModel reactModel(&molModel);
+  populateReactions(&reactModel, &molModel, reactions);
+
+  long visited = 0;
+  QElapsedTimer timer;
+  timer.start();
+  QBENCHMARK {
+    visited += walk(reactModel, QModelIndex());
+  }
+  report("traverse", double(visited), timer.nsecsElapsed());
+}
+
+
+void ModelBench::parentLookup_data() {
+  addSizes();
+}
+
+
+// parentLookup measures parent() for a fixed sample of reactant items spread
+// evenly across the reaction tree
+void ModelBench::parentLookup() {
+  QFETCH(int, species);
+  QFETCH(int, reactions);
+  MolModel molModel;
+  populateMolecules(&molModel, species);
+  ReactTreeModel reactModel(&molModel);
+  populateReactions(&reactModel, &molModel, reactions);
+
+  const int numSamples = 1000;
+  QList<QModelIndex> samples;
+  for (int i = 0; i < numSamples; ++i) {
+    QModelIndex reaction = reactModel.index(i * (reactions / numSamples), 0,
+      QModelIndex());
+    QModelIndex tag = reactModel.index(0, 0, reaction);
+    samples << reactModel.index(0, 0, tag);
+  }
+
+  int iters = 0;
+  QElapsedTimer timer;
+  timer.start();
+  QBENCHMARK {
+    for (const auto& s : samples) {
+      QModelIndex tag = reactModel.parent(s);
+      reactModel.parent(tag);
+    }
+    ++iters;
+  }
+  report("parentLookup", 2.0 * numSamples * iters, timer.nsecsElapsed());
+}
+
+
+void ModelBench::writeMDL_data() {
+  addSizes();
+}
+
+
+// writeMDL measures the export of a complete model to an MDL file
+void ModelBench::writeMDL() {
+  QFETCH(int, species);
+  QFETCH(int, reactions);
+  MolModel molModel;
+  populateMolecules(&molModel, species);
+  ReactTreeModel reactModel(&molModel);
+  populateReactions(&reactModel, &molModel, reactions);
+  ParamModel paramModel;
+  NotificationsModel noteModel;
+  WarningsModel warnModel;
+
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QString fileName = dir.path() + "/bench.mdl";
+
+  int iters = 0;
+  QElapsedTimer timer;
+  timer.start();
+  QBENCHMARK {
+    QVERIFY(::writeMDL(fileName, &molModel, &paramModel, &noteModel,
+      &warnModel, &reactModel));
+    ++iters;
+  }
+  report("writeMDL", double(species + reactions) * iters,
+    timer.nsecsElapsed());
+}
+
+
+
+void ModelBench::sweep_data() {
+  QTest::addColumn<int>("variants");
+  QTest::newRow("100") << 100;
+  QTest::newRow("1000") << 1000;
+}
+
+
+// sweep measures writing all variants of an ITERATIONS x rate sweep of a
+// model with 1000 species and 1000 reactions in parallel
+void ModelBench::sweep() {
+  QFETCH(int, variants);
+  const int size = 1000;
+  MolModel molModel;
+  populateMolecules(&molModel, size);
+  ReactTreeModel reactModel(&molModel);
+  populateReactions(&reactModel, &molModel, size);
+  ParamModel paramModel;
+  NotificationsModel noteModel;
+  WarningsModel warnModel;
+
+  SweepDefinition def;
+  QString error;
+  QString text = QString("ITERATIONS = 1000:100000:%1\nrate:#1 = 1e6, 1e7")
+    .arg(variants / 2);
+  QVERIFY(parseSweepDefinition(text, SweepMode::Cartesian, def, error));
+  QCOMPARE(def.numVariants(), variants);
+
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  int iters = 0;
+  QElapsedTimer timer;
+  timer.start();
+  QBENCHMARK {
+    auto snapshot = std::make_shared<const ModelSnapshot>(&molModel,
+      &paramModel, &noteModel, &warnModel, &reactModel);
+    QFuture<QString> future = writeSweep(snapshot, def, dir.path(), "bench");
+    future.waitForFinished();
+    QVERIFY(future.results().count(QString()) == variants);
+    ++iters;
+  }
+  report("sweep", double(variants) * iters, timer.nsecsElapsed());
+}
+
+
+void ModelBench::stoichiometry_data() {
+  addSizes();
+}
+
+
+// stoichiometry measures building the sparse stoichiometry matrix
+void ModelBench::stoichiometry() {
+  QFETCH(int, species);
+  QFETCH(int, reactions);
+  MolModel molModel;
+  populateMolecules(&molModel, species);
+  ReactTreeModel reactModel(&molModel);
+  populateReactions(&reactModel, &molModel, reactions);
+
+  int iters = 0;
+  QElapsedTimer timer;
+  timer.start();
+  QBENCHMARK {
+    CSRMatrix m = reactModel.stoichiometryMatrix(&molModel);
+    QCOMPARE(m.numCols, reactions);
+    ++iters;
+  }
+  report("stoichiometry", double(reactions) * iters, timer.nsecsElapsed());
+}
+
+
+void ModelBench::snapshot_data() {
+  addSizes();
+}
+
+
+// snapshot measures publishing molecule and reaction snapshots after a
+// single molecule edit; all but one molecule chunk should be shared with the
+// previous snapshot
+void ModelBench::snapshot() {
+  QFETCH(int, species);
+  QFETCH(int, reactions);
+  MolModel molModel;
+  populateMolecules(&molModel, species);
+  ReactTreeModel reactModel(&molModel);
+  populateReactions(&reactModel, &molModel, reactions);
+  MolSnapshot mols = molModel.snapshot();
+  ReactionSnapshot reacts = reactModel.snapshot();
+
+  QModelIndex dIndex = molModel.index(species / 2, Col::D);
+  int iters = 0;
+  QElapsedTimer timer;
+  timer.start();
+  QBENCHMARK {
+    molModel.setData(dIndex, QString::number(iters + 1));
+    MolSnapshot next = molModel.snapshot();
+    QCOMPARE(next.numSharedChunks(mols) + 1, mols.numChunks());
+    QCOMPARE(reactModel.snapshot().numSharedChunks(reacts),
+      reacts.numChunks());
+    ++iters;
+  }
+  report("snapshot", double(species) * iters, timer.nsecsElapsed());
+}
+
+
+void ModelBench::memory_data() {
+  addSizes();
+}
+
+
+// memory prints the estimated memory usage of the molecule and reaction
+// models in bytes per molecule and per reaction
+void ModelBench::memory() {
+  QFETCH(int, species);
+  QFETCH(int, reactions);
+  MolModel molModel;
+  populateMolecules(&molModel, species);
+  ReactTreeModel reactModel(&molModel);
+  populateReactions(&reactModel, &molModel, reactions);
+
+  MemoryReport memReport = collectMemoryReport(&molModel, &reactModel,
+    QList<const QAbstractProxyModel*>());
+  qDebug().noquote() << memReport.toText();
+  qDebug().noquote() << QString("peak RSS %1 kB").arg(peakMemoryKB());
+}
+
+
+QTEST_GUILESS_MAIN(ModelBench)
+#include "modelBench.moc"
@@ -0,0 +1,72 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <cstdint>
+
+#include <QtGlobal>
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include "molModel.hpp"
+#include "reactionModel.hpp"
+#include "syntheticModel.hpp"
+
+
+// synthMolName returns the name of the i-th synthetic molecule
+QString synthMolName(int i) {
+  return QString("mol_%1").arg(i);
+}
+
+
+// populateMolecules adds numMols synthetic molecules to molModel. Every
+// fourth molecule is a surface molecule. Diffusion constants are scattered
+// between 1e-9 and 1e-6 so that sorting by D is not trivial.
+void populateMolecules(MolModel* molModel, int numMols) {
+  for (int i = 0; i < numMols; ++i) {
+    MolType type = (i % 4 == 0) ? MolType::SURF : MolType::VOL;
+    QString D = QString("%1e-9").arg((i * 7919) % 1000 + 1);
+    molModel->addMol(synthMolName(i), D, type);
+  }
+}
+
+
+// populateReactions adds numReacts synthetic reactions to reactModel using a
+// simple linear congruential generator to pick reactants and products.
+void populateReactions(ReactTreeModel* reactModel, const MolModel* molModel,
+  int numReacts) {
+  const MolList& mols = molModel->getMols();
+  if (mols.empty()) {
+    return;
+  }
+  uint32_t state = 12345;
+  auto next = [&state, &mols]() {
+    state = state * 1664525u + 1013904223u;
+    return mols[(state >> 8) % mols.size()]->handle;
+  };
+  for (int i = 0; i < numReacts; ++i) {
+    MolHandle r1 = next();
+    MolHandle r2 = next();
+    MolHandle p1 = next();
+    reactModel->addReaction(QString("reac_%1").arg(i), "1e6", r1, r2, p1);
+  }
+}
+
+
+// peakMemoryKB returns the peak resident set size of the process in kB
+long peakMemoryKB() {
+#ifdef Q_OS_UNIX
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef Q_OS_MAC
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+  }
+#endif
+  return -1;
+}
@@ -0,0 +1,31 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef SYNTHETIC_MODEL_HPP
+#define SYNTHETIC_MODEL_HPP
+
+#include <QString>
+
+class MolModel;
+class ReactTreeModel;
+
+// synthMolName returns the name of the i-th synthetic molecule
+QString synthMolName(int i);
+
+// populateMolecules adds numMols synthetic molecules to molModel
+void populateMolecules(MolModel* molModel, int numMols);
+
+// populateReactions adds numReacts synthetic reactions between the molecules
+// present in molModel to reactModel. Reactants and products are picked with
+// a fixed seed so runs are reproducible.
+void populateReactions(ReactTreeModel* reactModel, const MolModel* molModel,
+  int numReacts);
+
+// peakMemoryKB returns the peak resident set size of the process in kB or
+// -1 if it is not available on this platform
+long peakMemoryKB();
+
+#endif
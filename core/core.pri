@@ -0,0 +1,24 @@
+######################################################################
+# Qt independent core of mcellGUI: molecule storage, reaction specs and index,
+# expressions, keyword tables, MDL writing, reaction networks,
+# stoichiometry and the simulation previews.
+# Include this file to compile the core into another qmake project or
+# build core.pro for a standalone static library.
+######################################################################
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+HEADERS += $$PWD/expression.hpp $$PWD/keywordTable.hpp \
+           $$PWD/massAction.hpp $$PWD/mdlWriter.hpp $$PWD/modelState.hpp \
+           $$PWD/molStore.hpp $$PWD/odeSolver.hpp $$PWD/persistentVector.hpp \
+           $$PWD/reactionCheck.hpp $$PWD/reactionIndex.hpp \
+           $$PWD/reactionNetwork.hpp $$PWD/reactionSpec.hpp \
+           $$PWD/ssaSolver.hpp $$PWD/stepAnalysis.hpp $$PWD/stringPool.hpp \
+           $$PWD/stoichMatrix.hpp $$PWD/trace.hpp
+SOURCES += $$PWD/expression.cpp $$PWD/keywordTable.cpp \
+           $$PWD/massAction.cpp $$PWD/mdlWriter.cpp $$PWD/modelState.cpp \
+           $$PWD/molStore.cpp $$PWD/odeSolver.cpp $$PWD/reactionCheck.cpp \
+           $$PWD/reactionIndex.cpp $$PWD/reactionNetwork.cpp \
+           $$PWD/ssaSolver.cpp $$PWD/stepAnalysis.cpp \
+           $$PWD/stoichMatrix.cpp $$PWD/trace.cpp
@@ -0,0 +1,10 @@
+######################################################################
+# Standalone static library of the Qt independent mcellGUI core
+######################################################################
+
+CONFIG += c++11 staticlib -Wall -Wextra -pedantic
+CONFIG -= qt
+TEMPLATE = lib
+TARGET = mcellcore
+
+include(core.pri)
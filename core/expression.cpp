@@ -0,0 +1,699 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <locale>
+#include <sstream>
+
+#include "expression.hpp"
+
+namespace {
+
+// isDigit returns true if c is a decimal digit
+bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+
+// scanNumber returns the end of the decimal literal starting at pos in text,
+// i.e. digits with an optional fraction and exponent as in 1.5e-6, or pos
+// if there is none. Unlike strtod no hex, inf or nan literals are accepted.
+size_t scanNumber(const std::string& text, size_t pos) {
+  size_t i = pos;
+  size_t numDigits = 0;
+  for (; i < text.size() && isDigit(text[i]); ++i) {
+    ++numDigits;
+  }
+  if (i < text.size() && text[i] == '.') {
+    for (++i; i < text.size() && isDigit(text[i]); ++i) {
+      ++numDigits;
+    }
+  }
+  if (numDigits == 0) {
+    return pos;
+  }
+  if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+    size_t j = i + 1;
+    if (j < text.size() && (text[j] == '+' || text[j] == '-')) {
+      ++j;
+    }
+    if (j < text.size() && isDigit(text[j])) {
+      for (i = j; i < text.size() && isDigit(text[i]); ++i) {}
+    }
+  }
+  return i;
+}
+
+
+// parseDecimal converts a literal found by scanNumber independent of the
+// current locale
+double parseDecimal(const std::string& literal) {
+  std::istringstream in(literal);
+  in.imbue(std::locale::classic());
+  double value = 0.0;
+  in >> value;
+  return value;
+}
+
+// Function describes a builtin MDL function
+struct Function {
+  const char* name;
+  int numArgs;
+  int op;
+};
+
+}
+
+
+// evaluate computes the value of the expression given the current values of
+// all symbols indexed by symbol id
+double Expression::evaluate(const double* symbolValues) const {
+  double stack[maxDepth];
+  int top = -1;
+  for (const auto& instr : code_) {
+    switch (instr.op) {
+      case Op::Const:
+        stack[++top] = instr.value;
+        break;
+      case Op::Symbol:
+        stack[++top] = symbolValues[instr.symbol];
+        break;
+      case Op::Neg:
+        stack[top] = -stack[top];
+        break;
+      case Op::Add:
+        --top;
+        stack[top] += stack[top + 1];
+        break;
+      case Op::Sub:
+        --top;
+        stack[top] -= stack[top + 1];
+        break;
+      case Op::Mul:
+        --top;
+        stack[top] *= stack[top + 1];
+        break;
+      case Op::Div:
+        --top;
+        stack[top] /= stack[top + 1];
+        break;
+      case Op::Pow:
+        --top;
+        stack[top] = std::pow(stack[top], stack[top + 1]);
+        break;
+      case Op::Sqrt:
+        stack[top] = std::sqrt(stack[top]);
+        break;
+      case Op::Exp:
+        stack[top] = std::exp(stack[top]);
+        break;
+      case Op::Log:
+        stack[top] = std::log(stack[top]);
+        break;
+      case Op::Log10:
+        stack[top] = std::log10(stack[top]);
+        break;
+      case Op::Sin:
+        stack[top] = std::sin(stack[top]);
+        break;
+      case Op::Cos:
+        stack[top] = std::cos(stack[top]);
+        break;
+      case Op::Tan:
+        stack[top] = std::tan(stack[top]);
+        break;
+      case Op::Abs:
+        stack[top] = std::fabs(stack[top]);
+        break;
+      case Op::Floor:
+        stack[top] = std::floor(stack[top]);
+        break;
+      case Op::Ceil:
+        stack[top] = std::ceil(stack[top]);
+        break;
+      case Op::Min:
+        --top;
+        stack[top] = std::min(stack[top], stack[top + 1]);
+        break;
+      case Op::Max:
+        --top;
+        stack[top] = std::max(stack[top], stack[top + 1]);
+        break;
+    }
+  }
+  assert(top == 0);
+  return stack[0];
+}
+
+
+// symbols returns the ids of all symbols referenced by the expression
+const std::vector<int>& Expression::symbols() const {
+  return symbols_;
+}
+
+
+// empty returns true if the expression has not been compiled successfully
+bool Expression::empty() const {
+  return code_.empty();
+}
+
+
+// constructor
+ExprParser::ExprParser(const std::string& text, Expression& expr) :
+  text_(text), expr_(expr) {}
+
+
+// next_ advances to the next token
+ExprParser::Token ExprParser::next_() {
+  while (pos_ < text_.size() &&
+    std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+    ++pos_;
+  }
+  tokenText_.clear();
+  if (pos_ >= text_.size()) {
+    return token_ = Token::End;
+  }
+  char c = text_[pos_];
+  unsigned char uc = static_cast<unsigned char>(c);
+  if (isDigit(c) || c == '.') {
+    size_t end = scanNumber(text_, pos_);
+    if (end == pos_) {
+      tokenText_ = c;
+      ++pos_;
+      return token_ = Token::Invalid;
+    }
+    tokenText_ = text_.substr(pos_, end - pos_);
+    tokenValue_ = parseDecimal(tokenText_);
+    pos_ = end;
+    return token_ = Token::Number;
+  }
+  if (std::isalpha(uc) || c == '_') {
+    size_t start = pos_;
+    while (pos_ < text_.size() &&
+      (std::isalnum(static_cast<unsigned char>(text_[pos_])) ||
+      text_[pos_] == '_')) {
+      ++pos_;
+    }
+    tokenText_ = text_.substr(start, pos_ - start);
+    return token_ = Token::Ident;
+  }
+  tokenText_ = c;
+  ++pos_;
+  if (std::string("+-*/^(),").find(c) != std::string::npos) {
+    return token_ = Token::Op;
+  }
+  return token_ = Token::Invalid;
+}
+
+
+// emit_ appends an instruction and keeps track of the stack depth
+void ExprParser::emit_(Expression::Op op, int symbol, double value) {
+  using Op = Expression::Op;
+  switch (op) {
+    case Op::Const:
+    case Op::Symbol:
+      ++depth_;
+      break;
+    case Op::Add:
+    case Op::Sub:
+    case Op::Mul:
+    case Op::Div:
+    case Op::Pow:
+    case Op::Min:
+    case Op::Max:
+      --depth_;
+      break;
+    default:
+      break;
+  }
+  maxDepth_ = std::max(maxDepth_, depth_);
+  expr_.code_.push_back(Expression::Instr{op, symbol, value});
+}
+
+
+// sum_ parses a sum of terms
+bool ExprParser::sum_(std::string& error) {
+  if (!term_(error)) {
+    return false;
+  }
+  while (token_ == Token::Op && (tokenText_ == "+" || tokenText_ == "-")) {
+    bool add = (tokenText_ == "+");
+    next_();
+    if (!term_(error)) {
+      return false;
+    }
+    emit_(add ? Expression::Op::Add : Expression::Op::Sub);
+  }
+  return true;
+}
+
+
+// term_ parses a product of unary expressions
+bool ExprParser::term_(std::string& error) {
+  if (!unary_(error)) {
+    return false;
+  }
+  while (token_ == Token::Op && (tokenText_ == "*" || tokenText_ == "/")) {
+    bool mul = (tokenText_ == "*");
+    next_();
+    if (!unary_(error)) {
+      return false;
+    }
+    emit_(mul ? Expression::Op::Mul : Expression::Op::Div);
+  }
+  return true;
+}
+
+
+// unary_ parses an optionally negated power. Every recursion of the parser,
+// i.e. signs, exponents, parentheses and function arguments, passes through
+// unary_, so limiting its nesting bounds the stack depth of the parser for
+// arbitrary input.
+bool ExprParser::unary_(std::string& error) {
+  if (nesting_ >= Expression::maxDepth) {
+    error = "expression is nested too deeply";
+    return false;
+  }
+  ++nesting_;
+  bool ok = true;
+  if (token_ == Token::Op && (tokenText_ == "-" || tokenText_ == "+")) {
+    bool neg = (tokenText_ == "-");
+    next_();
+    ok = unary_(error);
+    if (ok && neg) {
+      emit_(Expression::Op::Neg);
+    }
+  } else {
+    ok = power_(error);
+  }
+  --nesting_;
+  return ok;
+}
+
+
+// power_ parses a right associative power which binds tighter than unary
+// minus, i.e. -2^2 = -4
+bool ExprParser::power_(std::string& error) {
+  if (!primary_(error)) {
+    return false;
+  }
+  if (token_ == Token::Op && tokenText_ == "^") {
+    next_();
+    if (!unary_(error)) {
+      return false;
+    }
+    emit_(Expression::Op::Pow);
+  }
+  return true;
+}
+
+
+// primary_ parses numbers, symbols, function calls and parenthesized
+// expressions
+bool ExprParser::primary_(std::string& error) {
+  switch (token_) {
+    case Token::Number:
+      emit_(Expression::Op::Const, -1, tokenValue_);
+      next_();
+      return true;
+    case Token::Ident: {
+      std::string name = tokenText_;
+      next_();
+      if (token_ == Token::Op && tokenText_ == "(") {
+        return function_(name, error);
+      }
+      emit_(Expression::Op::Symbol);
+      idents_.push_back(name);
+      return true;
+    }
+    case Token::Op:
+      if (tokenText_ == "(") {
+        next_();
+        if (!sum_(error)) {
+          return false;
+        }
+        if (token_ != Token::Op || tokenText_ != ")") {
+          error = "missing ')'";
+          return false;
+        }
+        next_();
+        return true;
+      }
+      error = "unexpected '" + tokenText_ + "'";
+      return false;
+    case Token::End:
+      error = "unexpected end of expression";
+      return false;
+    default:
+      error = "invalid character '" + tokenText_ + "'";
+      return false;
+  }
+}
+
+
+// function_ parses the argument list of a builtin function call. The
+// opening parenthesis is the current token.
+bool ExprParser::function_(const std::string& name, std::string& error) {
+  using Op = Expression::Op;
+  static const Function functions[] = {
+    {"SQRT", 1, int(Op::Sqrt)}, {"EXP", 1, int(Op::Exp)},
+    {"LOG", 1, int(Op::Log)}, {"LOG10", 1, int(Op::Log10)},
+    {"SIN", 1, int(Op::Sin)}, {"COS", 1, int(Op::Cos)},
+    {"TAN", 1, int(Op::Tan)}, {"ABS", 1, int(Op::Abs)},
+    {"FLOOR", 1, int(Op::Floor)}, {"CEIL", 1, int(Op::Ceil)},
+    {"MIN", 2, int(Op::Min)}, {"MAX", 2, int(Op::Max)}};
+
+  const Function* func = nullptr;
+  for (const auto& f : functions) {
+    if (name == f.name) {
+      func = &f;
+    }
+  }
+  if (func == nullptr) {
+    error = "unknown function " + name;
+    return false;
+  }
+  next_();
+  for (int i = 0; i < func->numArgs; ++i) {
+    if (i > 0) {
+      if (token_ != Token::Op || tokenText_ != ",") {
+        error = name + " expects " + std::to_string(func->numArgs)
+          + " arguments";
+        return false;
+      }
+      next_();
+    }
+    if (!sum_(error)) {
+      return false;
+    }
+  }
+  if (token_ != Token::Op || tokenText_ != ")") {
+    error = "missing ')' after arguments of " + name;
+    return false;
+  }
+  next_();
+  emit_(Op(func->op));
+  return true;
+}
+
+
+// newNode_ returns an unused node, recycling removed fields if possible
+int ExpressionEngine::newNode_() {
+  if (!freeNodes_.empty()) {
+    int node = freeNodes_.back();
+    freeNodes_.pop_back();
+    nodes_[node] = Node();
+    values_[node] = 0.0;
+    return node;
+  }
+  nodes_.push_back(Node());
+  values_.push_back(0.0);
+  return nodes_.size() - 1;
+}
+
+
+// addField creates a new anonymous field without expression
+int ExpressionEngine::addField() {
+  return newNode_();
+}
+
+
+// removeField releases a field created via addField
+void ExpressionEngine::removeField(int node) {
+  assert(nodes_[node].name.empty());
+  unlink_(node);
+  nodes_[node].alive = false;
+  freeNodes_.push_back(node);
+}
+
+
+// symbol returns the id of the symbol with the given name. Symbols which do
+// not exist yet are created as undefined.
+int ExpressionEngine::symbol(const std::string& name) {
+  auto it = symbolIDs_.find(name);
+  if (it != symbolIDs_.end()) {
+    return it->second;
+  }
+  int node = newNode_();
+  nodes_[node].name = name;
+  nodes_[node].error = "undefined symbol " + name;
+  symbolIDs_[name] = node;
+  return node;
+}
+
+
+// findSymbol returns the id of the symbol with the given name or -1 if no
+// such symbol exists
+int ExpressionEngine::findSymbol(const std::string& name) const {
+  auto it = symbolIDs_.find(name);
+  return (it == symbolIDs_.end()) ? -1 : it->second;
+}
+
+
+// undefine removes the definition of a symbol. Expressions referring to the
+// symbol become invalid.
+void ExpressionEngine::undefine(int node, std::vector<int>& changed) {
+  Node& n = nodes_[node];
+  unlink_(node);
+  n.expr = Expression();
+  n.text.clear();
+  n.defined = false;
+  n.valid = false;
+  n.error = "undefined symbol " + n.name;
+  propagate_(node, changed);
+}
+
+
+// isDefined returns true if the node has a successfully compiled expression
+bool ExpressionEngine::isDefined(int node) const {
+  return nodes_[node].defined;
+}
+
+
+// unlink_ removes node from the dependents of all symbols it refers to
+void ExpressionEngine::unlink_(int node) {
+  for (auto s : nodes_[node].expr.symbols()) {
+    auto& deps = nodes_[s].dependents;
+    deps.erase(std::remove(deps.begin(), deps.end(), node), deps.end());
+  }
+}
+
+
+// nextEpoch_ starts a new graph traversal and returns its epoch. Nodes are
+// visited in this traversal if their visited_ entry equals the epoch.
+unsigned ExpressionEngine::nextEpoch_() const {
+  visited_.resize(nodes_.size(), 0);
+  if (++epoch_ == 0) {
+    std::fill(visited_.begin(), visited_.end(), 0);
+    epoch_ = 1;
+  }
+  return epoch_;
+}
+
+
+// reaches_ checks if target depends on from, i.e. is reachable via the
+// dependents of from
+bool ExpressionEngine::reaches_(int from, int target) const {
+  if (nodes_[from].dependents.empty()) {
+    return from == target;
+  }
+  unsigned epoch = nextEpoch_();
+  std::vector<int> stack(1, from);
+  while (!stack.empty()) {
+    int n = stack.back();
+    stack.pop_back();
+    if (n == target) {
+      return true;
+    }
+    if (visited_[n] == epoch) {
+      continue;
+    }
+    visited_[n] = epoch;
+    for (auto d : nodes_[n].dependents) {
+      stack.push_back(d);
+    }
+  }
+  return false;
+}
+
+
+// setExpression compiles text and assigns it to node. Expressions containing
+// syntax errors or creating cyclic symbol definitions are rejected and leave
+// the node unchanged. On success the ids of all nodes whose value or
+// validity changed are appended to changed.
+bool ExpressionEngine::setExpression(int node, const std::string& text,
+  std::string& error, std::vector<int>& changed) {
+  Expression expr;
+  if (!expr.compile(text, [this](const std::string& s) { return symbol(s); },
+      error)) {
+    return false;
+  }
+  const std::vector<int>& refs = expr.symbols();
+  for (auto s : refs) {
+    if (reaches_(node, s)) {
+      error = "cyclic definition via " + nodes_[s].name;
+      return false;
+    }
+  }
+
+  unlink_(node);
+  Node& n = nodes_[node];
+  n.expr = expr;
+  n.text = text;
+  n.defined = true;
+  for (auto s : refs) {
+    nodes_[s].dependents.push_back(node);
+  }
+  propagate_(node, changed);
+  return true;
+}
+
+
+// propagate_ re-evaluates node and everything depending on it in
+// topological order and records the nodes whose state changed
+void ExpressionEngine::propagate_(int node, std::vector<int>& changed) {
+  // nodes nothing depends on yet, e.g. freshly created fields, only need to
+  // be evaluated themselves
+  if (nodes_[node].dependents.empty()) {
+    evaluate_(node);
+    changed.push_back(node);
+    return;
+  }
+
+  // iterative post-order DFS over dependents; reversed it is a topological
+  // order of the affected subgraph
+  unsigned epoch = nextEpoch_();
+  std::vector<int> order;
+  std::vector<std::pair<int, size_t>> stack;
+  stack.push_back(std::make_pair(node, size_t(0)));
+  visited_[node] = epoch;
+  while (!stack.empty()) {
+    auto& top = stack.back();
+    const auto& deps = nodes_[top.first].dependents;
+    if (top.second < deps.size()) {
+      int d = deps[top.second++];
+      if (visited_[d] != epoch) {
+        visited_[d] = epoch;
+        stack.push_back(std::make_pair(d, size_t(0)));
+      }
+    } else {
+      order.push_back(top.first);
+      stack.pop_back();
+    }
+  }
+
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    double oldValue = values_[*it];
+    bool oldValid = nodes_[*it].valid;
+    evaluate_(*it);
+    if (*it == node || oldValid != nodes_[*it].valid
+        || oldValue != values_[*it]) {
+      changed.push_back(*it);
+    }
+  }
+}
+
+
+// evaluate_ recomputes the value of a single node from the cached values of
+// the symbols it refers to
+void ExpressionEngine::evaluate_(int node) {
+  Node& n = nodes_[node];
+  if (!n.defined) {
+    return;
+  }
+  for (auto s : n.expr.symbols()) {
+    if (!nodes_[s].valid) {
+      n.valid = false;
+      n.error = nodes_[s].defined ? nodes_[s].name + " is invalid"
+        : "undefined symbol " + nodes_[s].name;
+      return;
+    }
+  }
+  ++numEvaluations_;
+  double v = n.expr.evaluate(values_.data());
+  if (!std::isfinite(v)) {
+    n.valid = false;
+    n.error = "expression is not a finite number";
+    return;
+  }
+  values_[node] = v;
+  n.valid = true;
+  n.error.clear();
+}
+
+
+// name returns the name of a symbol or an empty string for fields
+const std::string& ExpressionEngine::name(int node) const {
+  return nodes_[node].name;
+}
+
+
+// text returns the source text of the node's expression
+const std::string& ExpressionEngine::text(int node) const {
+  return nodes_[node].text;
+}
+
+
+// value returns the cached value of a node. The value is only meaningful
+// if isValid returns true.
+double ExpressionEngine::value(int node) const {
+  return values_[node];
+}
+
+
+// isValid returns true if the node is defined and evaluates to a finite
+// number
+bool ExpressionEngine::isValid(int node) const {
+  return nodes_[node].valid;
+}
+
+
+// error describes why a node is not valid
+const std::string& ExpressionEngine::error(int node) const {
+  return nodes_[node].error;
+}
+
+
+// definedSymbols returns all defined symbols ordered such that each symbol
+// comes after the symbols it refers to
+std::vector<int> ExpressionEngine::definedSymbols() const {
+  std::vector<int> order;
+  std::vector<int> state(nodes_.size(), 0);
+  std::vector<std::pair<int, size_t>> stack;
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    if (!nodes_[i].alive || nodes_[i].name.empty() || !nodes_[i].defined
+        || state[i] != 0) {
+      continue;
+    }
+    stack.push_back(std::make_pair(int(i), size_t(0)));
+    state[i] = 1;
+    while (!stack.empty()) {
+      auto& top = stack.back();
+      const auto& refs = nodes_[top.first].expr.symbols();
+      if (top.second < refs.size()) {
+        int s = refs[top.second++];
+        if (state[s] == 0 && nodes_[s].defined) {
+          state[s] = 1;
+          stack.push_back(std::make_pair(s, size_t(0)));
+        }
+      } else {
+        order.push_back(top.first);
+        stack.pop_back();
+      }
+    }
+  }
+  return order;
+}
+
+
+// numEvaluations returns the total number of expression evaluations which
+// is useful to verify that updates are incremental
+size_t ExpressionEngine::numEvaluations() const {
+  return numEvaluations_;
+}
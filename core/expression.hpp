@@ -0,0 +1,208 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef EXPRESSION_HPP
+#define EXPRESSION_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+// Expression is an arithmetic expression compiled into postfix bytecode.
+// Expressions support numbers, symbols, + - * / ^, parentheses and the MDL
+// functions SQRT, EXP, LOG, LOG10, SIN, COS, TAN, ABS, FLOOR, CEIL, MIN and
+// MAX. Symbols are referred to by the ids handed out by the symbol lookup.
+class Expression {
+
+public:
+
+  // maximum evaluation stack depth of a compiled expression
+  static const int maxDepth = 64;
+
+  template<typename Lookup>
+  bool compile(const std::string& text, Lookup lookup, std::string& error);
+
+  double evaluate(const double* symbolValues) const;
+  const std::vector<int>& symbols() const;
+  bool empty() const;
+
+
+private:
+
+  enum class Op : uint8_t {Const, Symbol, Neg, Add, Sub, Mul, Div, Pow, Sqrt,
+    Exp, Log, Log10, Sin, Cos, Tan, Abs, Floor, Ceil, Min, Max};
+
+  struct Instr {
+    Op op;
+    int symbol;
+    double value;
+  };
+
+  friend class ExprParser;
+
+  std::vector<Instr> code_;
+  std::vector<int> symbols_;
+};
+
+
+// ExpressionEngine keeps the values of named symbols and of anonymous fields
+// (e.g. diffusion constants and reaction rates) which are defined by
+// expressions over these symbols. Each expression is compiled once when it is
+// set. Changing a symbol only re-evaluates the symbols and fields which
+// depend on it, in dependency order.
+class ExpressionEngine {
+
+public:
+
+  int addField();
+  void removeField(int node);
+
+  int symbol(const std::string& name);
+  int findSymbol(const std::string& name) const;
+  void undefine(int node, std::vector<int>& changed);
+  bool isDefined(int node) const;
+
+  bool setExpression(int node, const std::string& text, std::string& error,
+    std::vector<int>& changed);
+
+  const std::string& name(int node) const;
+  const std::string& text(int node) const;
+  double value(int node) const;
+  bool isValid(int node) const;
+  const std::string& error(int node) const;
+  std::vector<int> definedSymbols() const;
+  size_t numEvaluations() const;
+
+
+private:
+
+  struct Node {
+    std::string name;
+    std::string text;
+    std::string error;
+    Expression expr;
+    std::vector<int> dependents;
+    bool defined = false;
+    bool valid = false;
+    bool alive = true;
+  };
+
+  int newNode_();
+  void unlink_(int node);
+  unsigned nextEpoch_() const;
+  bool reaches_(int from, int target) const;
+  void propagate_(int node, std::vector<int>& changed);
+  void evaluate_(int node);
+
+  std::vector<Node> nodes_;
+  std::vector<double> values_;
+  std::vector<int> freeNodes_;
+  std::unordered_map<std::string, int> symbolIDs_;
+  size_t numEvaluations_ = 0;
+
+  // visited_ marks the nodes seen by the current graph traversal with its
+  // epoch, so traversals do not have to clear a per call visited array
+  mutable std::vector<unsigned> visited_;
+  mutable unsigned epoch_ = 0;
+};
+
+
+// ExprParser is a recursive descent parser for Expression
+class ExprParser {
+
+public:
+
+  ExprParser(const std::string& text, Expression& expr);
+
+  template<typename Lookup>
+  bool parse(Lookup lookup, std::string& error);
+
+
+private:
+
+  enum class Token {Number, Ident, Op, End, Invalid};
+
+  Token next_();
+  bool sum_(std::string& error);
+  bool term_(std::string& error);
+  bool unary_(std::string& error);
+  bool power_(std::string& error);
+  bool primary_(std::string& error);
+  bool function_(const std::string& name, std::string& error);
+  void emit_(Expression::Op op, int symbol = -1, double value = 0.0);
+
+  const std::string& text_;
+  Expression& expr_;
+  size_t pos_ = 0;
+  Token token_ = Token::End;
+  std::string tokenText_;
+  double tokenValue_ = 0.0;
+  int depth_ = 0;
+  int maxDepth_ = 0;
+  int nesting_ = 0;
+  std::vector<std::string> idents_;
+};
+
+
+// compile translates text into bytecode. lookup maps symbol names to ids.
+// This function returns true on success and false otherwise in which case
+// error describes the problem.
+template<typename Lookup>
+bool Expression::compile(const std::string& text, Lookup lookup,
+  std::string& error) {
+  code_.clear();
+  symbols_.clear();
+  ExprParser parser(text, *this);
+  if (!parser.parse(lookup, error)) {
+    code_.clear();
+    symbols_.clear();
+    return false;
+  }
+  return true;
+}
+
+
+// parse parses the complete expression and resolves all symbol names via
+// lookup once parsing succeeded
+template<typename Lookup>
+bool ExprParser::parse(Lookup lookup, std::string& error) {
+  next_();
+  if (token_ == Token::End) {
+    error = "empty expression";
+    return false;
+  }
+  if (!sum_(error)) {
+    return false;
+  }
+  if (token_ != Token::End) {
+    error = "unexpected '" + tokenText_ + "'";
+    return false;
+  }
+  if (maxDepth_ > Expression::maxDepth) {
+    error = "expression is nested too deeply";
+    return false;
+  }
+  std::vector<int> ids;
+  for (const auto& name : idents_) {
+    ids.push_back(lookup(name));
+  }
+  size_t n = 0;
+  for (auto& instr : expr_.code_) {
+    if (instr.op == Expression::Op::Symbol) {
+      instr.symbol = ids[n++];
+      expr_.symbols_.push_back(instr.symbol);
+    }
+  }
+  std::sort(expr_.symbols_.begin(), expr_.symbols_.end());
+  expr_.symbols_.erase(std::unique(expr_.symbols_.begin(),
+    expr_.symbols_.end()), expr_.symbols_.end());
+  return true;
+}
+
+#endif
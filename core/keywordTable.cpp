@@ -0,0 +1,280 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <locale>
+#include <sstream>
+
+#include "keywordTable.hpp"
+
+namespace {
+
+// sameString compares two C strings at compile time
+constexpr bool sameString(const char* a, const char* b) {
+  return (*a == *b) && (*a == '\0' || sameString(a + 1, b + 1));
+}
+
+// choiceIndex returns the index of name among choices or -1
+constexpr int choiceIndex(const char* const* choices, int numChoices,
+  const char* name, int i = 0) {
+  return (i == numChoices) ? -1
+    : sameString(choices[i], name) ? i
+    : choiceIndex(choices, numChoices, name, i + 1);
+}
+
+// number describes an Integer or Real keyword which is always set
+constexpr Keyword number(const char* name, KeywordKind kind, double value,
+  bool advanced) {
+  return Keyword{name, kind, nullptr, 0, nullptr, KeywordValue{true, 0, value},
+    advanced};
+}
+
+// optionalNumber describes an Integer or Real keyword with a default value
+// which may be cleared to leave it to MCell
+constexpr Keyword optionalNumber(const char* name, KeywordKind kind,
+  double value, bool advanced) {
+  return Keyword{name, kind, nullptr, 0, "", KeywordValue{true, 0, value},
+    advanced};
+}
+
+// unsetNumber describes an Integer or Real keyword which is unset by default
+constexpr Keyword unsetNumber(const char* name, KeywordKind kind,
+  bool advanced) {
+  return Keyword{name, kind, nullptr, 0, "", KeywordValue{false, 0, 0.0},
+    advanced};
+}
+
+// choice describes a keyword taking one of choices with the given default
+template<size_t N>
+constexpr Keyword choice(const char* name, const char* const (&choices)[N],
+  const char* value, bool advanced) {
+  return Keyword{name, KeywordKind::Choice, choices, N, nullptr,
+    KeywordValue{true, choiceIndex(choices, N, value), 0.0}, advanced};
+}
+
+// unsetChoice describes a keyword taking one of choices which is UNSET by
+// default
+template<size_t N>
+constexpr Keyword unsetChoice(const char* name,
+  const char* const (&choices)[N], bool advanced) {
+  return Keyword{name, KeywordKind::Choice, choices, N, "UNSET",
+    KeywordValue{false, 0, 0.0}, advanced};
+}
+
+// validDefaults checks that the default of every choice keyword is one of
+// its choices
+template<size_t N>
+constexpr bool validDefaults(const Keyword (&keywords)[N], size_t i = 0) {
+  return (i == N) || ((keywords[i].kind != KeywordKind::Choice
+    || !keywords[i].defaultValue.set || keywords[i].defaultValue.choice >= 0)
+    && validDefaults(keywords, i + 1));
+}
+
+constexpr const char* onOff[] = {"ON", "OFF"};
+constexpr const char* onBrief[] = {"ON", "BRIEF"};
+constexpr const char* trueFalse[] = {"TRUE", "FALSE"};
+constexpr const char* warnLevels[] = {"IGNORED", "WARNING", "ERROR"};
+
+constexpr KeywordKind Integer = KeywordKind::Integer;
+constexpr KeywordKind Real = KeywordKind::Real;
+
+// parameterKeywords are the main and advanced model parameters
+constexpr Keyword parameterKeywords[] = {
+  number("ITERATIONS", Integer, 0, false),
+  number("TIME_STEP", Real, 0.0, false),
+  unsetNumber("TIME_STEP_MAX", Real, true),
+  unsetNumber("SPACE_STEP", Real, true),
+  optionalNumber("SURFACE_GRID_DENSITY", Integer, 10000, true),
+  unsetNumber("INTERACTION_RADIUS", Real, true),
+  choice("ACCURATE_3D_REACTIONS", trueFalse, "TRUE", true),
+  choice("CENTER_MOLECULES_ON_GRID", trueFalse, "FALSE", true),
+  optionalNumber("VACANCY_SEARCH_DISTANCE", Real, 0.1, true),
+  choice("MICROSCOPIC_REVERSIBILITY", onOff, "OFF", true)};
+static_assert(validDefaults(parameterKeywords), "invalid parameter default");
+
+// notificationKeywords make up the NOTIFICATIONS block
+constexpr Keyword notificationKeywords[] = {
+  choice("BOX_TRIANGULATION_REPORT", onOff, "OFF", false),
+  choice("DIFFUSION_CONSTANT_REPORT", onBrief, "BRIEF", false),
+  choice("FILE_OUTPUT_REPORT", onOff, "OFF", false),
+  choice("FINAL_SUMMARY", onOff, "ON", false),
+  choice("ITERATION_REPORT", onOff, "ON", false),
+  choice("PARTITION_LOCATION_REPORT", onOff, "OFF", false),
+  choice("PROBABILITY_REPORT", onOff, "ON", false),
+  number("PROBABILITY_REPORT_THRESHOLD", Integer, 1, false),
+  choice("VARYING_PROBABILITY_REPORT", onOff, "ON", false),
+  choice("PROGRESS_REPORT", onOff, "ON", false),
+  choice("RELEASE_EVENT_REPORT", onOff, "ON", false),
+  choice("MOLECULE_COLLISION_REPORT", onOff, "OFF", false),
+  unsetChoice("ALL_NOTIFICATIONS", onOff, false)};
+static_assert(validDefaults(notificationKeywords),
+  "invalid notification default");
+
+// warningKeywords make up the WARNINGS block
+constexpr Keyword warningKeywords[] = {
+  choice("DEGENERATE_POLYGONS", warnLevels, "WARNING", false),
+  choice("HIGH_REACTION_PROBABILITY", warnLevels, "IGNORED", false),
+  number("HIGH_PROBABILITY_THRESHOLD", Real, 1.0, false),
+  choice("LIFETIME_TOO_SHORT", warnLevels, "WARNING", false),
+  number("LIFETIME_THRESHOLD", Integer, 50, false),
+  choice("MISSED_REACTIONS", warnLevels, "WARNING", false),
+  number("MISSED_REACTION_THRESHOLD", Real, 1e-3, false),
+  choice("NEGATIVE_DIFFUSION_CONSTANT", warnLevels, "WARNING", false),
+  choice("MISSING_SURFACE_ORIENTATION", warnLevels, "ERROR", false),
+  choice("NEGATIVE_REACTION_RATE", warnLevels, "WARNING", false),
+  choice("USELESS_VOLUME_ORIENTATION", warnLevels, "WARNING", false),
+  unsetChoice("ALL_WARNINGS", warnLevels, false)};
+static_assert(validDefaults(warningKeywords), "invalid warning default");
+
+
+// parseNumber parses text as a number of the given kind independent of the
+// current locale. The whole text has to be consumed.
+bool parseNumber(const std::string& text, KeywordKind kind, double* value) {
+  std::istringstream in(text);
+  in.imbue(std::locale::classic());
+  if (kind == KeywordKind::Integer) {
+    long long i;
+    in >> i;
+    *value = i;
+  } else {
+    in >> *value;
+  }
+  return !in.fail() && in.peek() == std::char_traits<char>::eof();
+}
+
+}
+
+
+// size returns the number of keywords
+int KeywordTable::size() const {
+  return size_;
+}
+
+
+// find returns the index of the keyword with the given name or -1 if there
+// is none. The tables hold at most a few dozen keywords, so a scan is
+// cheaper than hashing the name.
+int KeywordTable::find(const std::string& name) const {
+  for (int i = 0; i < size_; ++i) {
+    if (name == keywords_[i].name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+
+// keyword returns the description of the i-th keyword
+const Keyword& KeywordTable::keyword(int i) const {
+  return keywords_[i];
+}
+
+
+// typedValue returns the current value of the i-th keyword
+const KeywordValue& KeywordTable::typedValue(int i) const {
+  return values_[i];
+}
+
+
+// value returns the text of the current value of the i-th keyword
+std::string KeywordTable::value(int i) const {
+  std::ostringstream out;
+  writeValue(out, i);
+  return out.str();
+}
+
+
+// writeValue writes the text of the current value of the i-th keyword to
+// out without going through an intermediate string. Numbers are written
+// independent of the locale of out.
+void KeywordTable::writeValue(std::ostream& out, int i) const {
+  const Keyword& k = keywords_[i];
+  const KeywordValue& v = values_[i];
+  if (!v.set) {
+    out << ((k.unsetName == nullptr) ? "" : k.unsetName);
+    return;
+  }
+  if (k.kind == KeywordKind::Choice) {
+    out << k.choices[v.choice];
+    return;
+  }
+  std::locale previous = out.imbue(std::locale::classic());
+  if (k.kind == KeywordKind::Integer) {
+    out << static_cast<long long>(v.number);
+  } else {
+    std::streamsize precision = out.precision(15);
+    out << v.number;
+    out.precision(precision);
+  }
+  out.imbue(previous);
+}
+
+
+// value returns the text of the current value of the named keyword or an
+// empty string if there is no such keyword
+std::string KeywordTable::value(const std::string& name) const {
+  int i = find(name);
+  return (i < 0) ? "" : value(i);
+}
+
+
+// setValue parses value according to the kind of the i-th keyword and sets
+// it. This function returns false if i is out of range or the value is not
+// valid for the keyword.
+bool KeywordTable::setValue(int i, const std::string& value) {
+  if (i < 0 || i >= size_) {
+    return false;
+  }
+  const Keyword& k = keywords_[i];
+  KeywordValue& v = values_[i];
+  if (k.unsetName != nullptr && value == k.unsetName) {
+    v.set = false;
+    return true;
+  }
+  if (k.kind == KeywordKind::Choice) {
+    for (int c = 0; c < k.numChoices; ++c) {
+      if (value == k.choices[c]) {
+        v.set = true;
+        v.choice = c;
+        return true;
+      }
+    }
+    return false;
+  }
+  double number;
+  if (!parseNumber(value, k.kind, &number)) {
+    return false;
+  }
+  v.set = true;
+  v.number = number;
+  return true;
+}
+
+
+// setValue sets the value of the named keyword. This function returns false
+// if there is no such keyword or the value is invalid.
+bool KeywordTable::setValue(const std::string& name,
+  const std::string& value) {
+  return setValue(find(name), value);
+}
+
+
+// makeParameterTable returns the table of the main and advanced model
+// parameters
+KeywordTable makeParameterTable() {
+  return KeywordTable(parameterKeywords);
+}
+
+
+// makeNotificationTable returns the table of the NOTIFICATIONS block
+KeywordTable makeNotificationTable() {
+  return KeywordTable(notificationKeywords);
+}
+
+
+// makeWarningTable returns the table of the WARNINGS block
+KeywordTable makeWarningTable() {
+  return KeywordTable(warningKeywords);
+}
@@ -0,0 +1,87 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef KEYWORD_TABLE_HPP
+#define KEYWORD_TABLE_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+// KeywordKind is the type of value an MDL keyword takes
+enum class KeywordKind {Integer, Real, Choice};
+
+
+// KeywordValue is the typed value of a keyword. Integer and Real keywords
+// use number, Choice keywords the index of the choice. Unset values are not
+// written to the MDL.
+struct KeywordValue {
+  bool set;
+  int choice;
+  double number;
+};
+
+
+// Keyword describes a single MDL keyword. Choice keywords take one of
+// numChoices fixed values. Keywords with an unsetName may be left unset;
+// the GUI shows the unset value as unsetName. Advanced keywords are hidden
+// in the GUI by default. Keywords are literal types so that the keyword
+// tables are built and checked at compile time.
+struct Keyword {
+  const char* name;
+  KeywordKind kind;
+  const char* const* choices;
+  int numChoices;
+  const char* unsetName;
+  KeywordValue defaultValue;
+  bool advanced;
+};
+
+
+// KeywordTable stores the typed values of a fixed, ordered set of MDL
+// keywords such as the model parameters, notifications or warnings. The
+// keyword descriptions are static and never copied. Values are set from
+// and returned as the text shown in the GUI and written to the MDL.
+class KeywordTable {
+
+public:
+
+  template<size_t N>
+  explicit KeywordTable(const Keyword (&keywords)[N]) :
+    keywords_(keywords), size_(N) {
+    values_.reserve(N);
+    for (size_t i = 0; i < N; ++i) {
+      values_.push_back(keywords[i].defaultValue);
+    }
+  }
+
+  int size() const;
+  int find(const std::string& name) const;
+  const Keyword& keyword(int i) const;
+  const KeywordValue& typedValue(int i) const;
+  std::string value(int i) const;
+  std::string value(const std::string& name) const;
+  void writeValue(std::ostream& out, int i) const;
+
+  bool setValue(int i, const std::string& value);
+  bool setValue(const std::string& name, const std::string& value);
+
+
+private:
+
+  const Keyword* keywords_;
+  int size_;
+  std::vector<KeywordValue> values_;
+};
+
+
+KeywordTable makeParameterTable();
+KeywordTable makeNotificationTable();
+KeywordTable makeWarningTable();
+
+#endif
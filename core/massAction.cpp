@@ -0,0 +1,177 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <cassert>
+
+#include "massAction.hpp"
+
+namespace {
+const int numSlots = ReactionNetwork::maxReactants;
+}
+
+
+// multiply computes y = A * x
+void SparseMatrix::multiply(const double* x, double* y) const {
+  for (int i = 0; i < n; ++i) {
+    double sum = 0.0;
+    for (int64_t k = rowPtr[i]; k < rowPtr[i + 1]; ++k) {
+      sum += values[k] * x[colIdx[k]];
+    }
+    y[i] = sum;
+  }
+}
+
+
+// constructor compiles the network into flat arrays
+MassActionKernel::MassActionKernel(const ReactionNetwork& network) :
+  numSpecies_(network.numSpecies), reactants_(network.reactants),
+  rates_(network.rates) {
+
+  CSRMatrix s = network.stoichiometry();
+  stoichRowPtr_ = s.rowPtr;
+  stoichCol_ = s.colIdx;
+  stoichVal_.assign(s.values.begin(), s.values.end());
+  buildJacobianPattern_();
+}
+
+
+int MassActionKernel::numSpecies() const {
+  return numSpecies_;
+}
+
+
+int MassActionKernel::numReactions() const {
+  return rates_.size();
+}
+
+
+// initWorkspace sizes the scratch buffers of ws for this kernel. The extra
+// species slot holds the constant one used for unused reactant slots.
+void MassActionKernel::initWorkspace(KernelWorkspace& ws) const {
+  ws.x.assign(numSpecies_ + 1, 1.0);
+  ws.flux.assign(rates_.size(), 0.0);
+  ws.partials.assign(numSlots * rates_.size(), 0.0);
+}
+
+
+// computeFluxes evaluates the mass action flux of every reaction at x
+void MassActionKernel::computeFluxes_(const double* x,
+  KernelWorkspace& ws) const {
+  std::copy(x, x + numSpecies_, ws.x.begin());
+  ws.x[numSpecies_] = 1.0;
+  const double* xe = ws.x.data();
+  const int* r = reactants_.data();
+  const double* k = rates_.data();
+  double* flux = ws.flux.data();
+  int numReacts = rates_.size();
+  for (int i = 0; i < numReacts; ++i) {
+    flux[i] = k[i] * xe[r[numSlots*i]] * xe[r[numSlots*i + 1]] * xe[r[numSlots*i + 2]];
+  }
+}
+
+
+// rhs evaluates dx = S * flux(x)
+void MassActionKernel::rhs(const double* x, double* dx,
+  KernelWorkspace& ws) const {
+  computeFluxes_(x, ws);
+  const double* flux = ws.flux.data();
+  for (int i = 0; i < numSpecies_; ++i) {
+    double sum = 0.0;
+    for (int64_t k = stoichRowPtr_[i]; k < stoichRowPtr_[i + 1]; ++k) {
+      sum += stoichVal_[k] * flux[stoichCol_[k]];
+    }
+    dx[i] = sum;
+  }
+}
+
+
+// jacobian evaluates the Jacobian of rhs at x into jac which has to have the
+// structure returned by jacobianPattern
+void MassActionKernel::jacobian(const double* x, SparseMatrix& jac,
+  KernelWorkspace& ws) const {
+  std::copy(x, x + numSpecies_, ws.x.begin());
+  ws.x[numSpecies_] = 1.0;
+  const double* xe = ws.x.data();
+  const int* r = reactants_.data();
+  double* d = ws.partials.data();
+  int numReacts = rates_.size();
+  for (int i = 0; i < numReacts; ++i) {
+    double a = xe[r[numSlots*i]];
+    double b = xe[r[numSlots*i + 1]];
+    double c = xe[r[numSlots*i + 2]];
+    d[numSlots*i] = rates_[i] * b * c;
+    d[numSlots*i + 1] = rates_[i] * a * c;
+    d[numSlots*i + 2] = rates_[i] * a * b;
+  }
+
+  std::fill(jac.values.begin(), jac.values.end(), 0.0);
+  for (size_t c = 0; c < jacPos_.size(); ++c) {
+    jac.values[jacPos_[c]] += stoichVal_[jacStoich_[c]] * d[jacPartial_[c]];
+  }
+}
+
+
+// jacobianPattern returns the (zero valued) sparsity structure of the
+// Jacobian
+const SparseMatrix& MassActionKernel::jacobianPattern() const {
+  return pattern_;
+}
+
+
+// buildJacobianPattern determines the sparsity structure of the Jacobian.
+// Entry (i, j) is structurally non-zero if species i takes part in a
+// reaction which has j as a reactant. The diagonal is always present.
+void MassActionKernel::buildJacobianPattern_() {
+  pattern_.n = numSpecies_;
+  pattern_.rowPtr.assign(1, 0);
+  std::vector<int> cols;
+  for (int i = 0; i < numSpecies_; ++i) {
+    cols.clear();
+    cols.push_back(i);
+    for (int64_t k = stoichRowPtr_[i]; k < stoichRowPtr_[i + 1]; ++k) {
+      int reaction = stoichCol_[k];
+      for (int p = 0; p < numSlots; ++p) {
+        int j = reactants_[numSlots*reaction + p];
+        if (j != numSpecies_) {
+          cols.push_back(j);
+        }
+      }
+    }
+    std::sort(cols.begin(), cols.end());
+    cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+    pattern_.colIdx.insert(pattern_.colIdx.end(), cols.begin(), cols.end());
+    pattern_.rowPtr.push_back(pattern_.colIdx.size());
+  }
+  pattern_.values.assign(pattern_.colIdx.size(), 0.0);
+
+  pattern_.diag.resize(numSpecies_);
+  for (int i = 0; i < numSpecies_; ++i) {
+    auto begin = pattern_.colIdx.begin() + pattern_.rowPtr[i];
+    auto end = pattern_.colIdx.begin() + pattern_.rowPtr[i + 1];
+    pattern_.diag[i] = std::lower_bound(begin, end, i) -
+      pattern_.colIdx.begin();
+  }
+
+  for (int i = 0; i < numSpecies_; ++i) {
+    auto begin = pattern_.colIdx.begin() + pattern_.rowPtr[i];
+    auto end = pattern_.colIdx.begin() + pattern_.rowPtr[i + 1];
+    for (int64_t k = stoichRowPtr_[i]; k < stoichRowPtr_[i + 1]; ++k) {
+      int reaction = stoichCol_[k];
+      for (int p = 0; p < numSlots; ++p) {
+        int j = reactants_[numSlots*reaction + p];
+        if (j == numSpecies_) {
+          continue;
+        }
+        auto pos = std::lower_bound(begin, end, j);
+        assert(pos != end && *pos == j);
+        jacPos_.push_back(pos - pattern_.colIdx.begin());
+        jacStoich_.push_back(k);
+        jacPartial_.push_back(numSlots*reaction + p);
+      }
+    }
+  }
+}
@@ -0,0 +1,78 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef MASS_ACTION_HPP
+#define MASS_ACTION_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "reactionNetwork.hpp"
+
+
+// SparseMatrix is a square matrix in compressed sparse row format which
+// always stores its diagonal
+struct SparseMatrix {
+  int n = 0;
+  std::vector<int64_t> rowPtr;
+  std::vector<int> colIdx;
+  std::vector<int64_t> diag;
+  std::vector<double> values;
+
+  void multiply(const double* x, double* y) const;
+};
+
+
+// KernelWorkspace holds the scratch buffers of MassActionKernel so a single
+// kernel can be evaluated concurrently from several threads
+struct KernelWorkspace {
+  std::vector<double> x;
+  std::vector<double> flux;
+  std::vector<double> partials;
+};
+
+
+// MassActionKernel is the right hand side dx/dt = S * flux(x) of the mass
+// action ODEs of a ReactionNetwork compiled into flat arrays. Fluxes are
+// computed by a branch free loop over the reactant slots and accumulated
+// per species via the CSR stoichiometry matrix so there are no scattered
+// writes.
+class MassActionKernel {
+
+public:
+
+  explicit MassActionKernel(const ReactionNetwork& network);
+
+  int numSpecies() const;
+  int numReactions() const;
+
+  void initWorkspace(KernelWorkspace& ws) const;
+  void rhs(const double* x, double* dx, KernelWorkspace& ws) const;
+  void jacobian(const double* x, SparseMatrix& jac, KernelWorkspace& ws) const;
+  const SparseMatrix& jacobianPattern() const;
+
+
+private:
+
+  void computeFluxes_(const double* x, KernelWorkspace& ws) const;
+  void buildJacobianPattern_();
+
+  int numSpecies_;
+  std::vector<int> reactants_;
+  std::vector<double> rates_;
+  std::vector<int64_t> stoichRowPtr_;
+  std::vector<int> stoichCol_;
+  std::vector<double> stoichVal_;
+
+  // each Jacobian contribution adds stoichiometry entry jacStoich_ times
+  // rate partial jacPartial_ to Jacobian entry jacPos_
+  SparseMatrix pattern_;
+  std::vector<int64_t> jacPos_;
+  std::vector<int64_t> jacStoich_;
+  std::vector<int> jacPartial_;
+};
+
+#endif
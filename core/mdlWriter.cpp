@@ -0,0 +1,106 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include "mdlWriter.hpp"
+
+
+// writeKeywords writes one "KEYWORD = value" line per keyword of table
+// which is set
+void writeKeywords(std::ostream& out, const KeywordTable& table) {
+  for (int i = 0; i < table.size(); ++i) {
+    if (!table.typedValue(i).set) {
+      continue;
+    }
+    out << table.keyword(i).name << " = ";
+    table.writeValue(out, i);
+    out << "\n";
+  }
+}
+
+
+// writeKeywordBlock writes the keywords of table as an MDL block such as
+// NOTIFICATIONS { ... }
+void writeKeywordBlock(std::ostream& out, const std::string& block,
+  const KeywordTable& table) {
+  out << block << " {\n";
+  writeKeywords(out, table);
+  out << "}\n";
+}
+
+
+// writeMoleculeBlock writes the DEFINE_MOLECULES block for mols
+void writeMoleculeBlock(std::ostream& out, const MolStore& mols) {
+  out << "DEFINE_MOLECULES {\n";
+  for (const auto& m : mols.mols()) {
+    out << "  " << m->name.str() << " {\n";
+    if (m->type == MolType::VOL) {
+      out << "    DIFFUSION_CONSTANT_3D";
+    } else {
+      out << "    DIFFUSION_CONSTANT_2D";
+    }
+    out << " = " << m->D << "\n";
+    out << "  }\n";
+  }
+  out << "}\n";
+}
+
+
+// mdlReaction converts spec into its MDL text fragments. If any molecule of
+// the reaction lives on a surface all reactants and products are given the
+// same orientation as required by MCell.
+MdlReaction mdlReaction(const ReactionSpec& spec, const MolStore& mols) {
+  bool isSurfReaction = false;
+  for (const auto* handles : {&spec.reactants, &spec.products}) {
+    for (auto h : *handles) {
+      const Molecule* mol = mols.resolve(h);
+      if (mol != nullptr && mol->type == MolType::SURF) {
+        isSurfReaction = true;
+      }
+    }
+  }
+
+  auto join = [&mols, isSurfReaction](const std::vector<MolHandle>& handles) {
+    std::string text;
+    for (auto h : handles) {
+      if (!text.empty()) {
+        text += " + ";
+      }
+      const Molecule* mol = mols.resolve(h);
+      if (mol == nullptr) {
+        text += "NULL";
+        continue;
+      }
+      text += mol->name.str();
+      if (isSurfReaction) {
+        text += "'";
+      }
+    }
+    return text;
+  };
+
+  MdlReaction mdl;
+  mdl.reactants = join(spec.reactants);
+  mdl.products = join(spec.products);
+  mdl.rate = spec.rate;
+  mdl.name = spec.name;
+  return mdl;
+}
+
+
+// writeReactionBlock writes the DEFINE_REACTIONS block for reactions
+void writeReactionBlock(std::ostream& out,
+  const std::vector<MdlReaction>& reactions) {
+  out << "DEFINE_REACTIONS {\n";
+  for (const auto& r : reactions) {
+    out << "  " << r.reactants << " -> " << r.products << " [" << r.rate
+        << "]";
+    if (!r.name.empty()) {
+      out << " : " << r.name;
+    }
+    out << "\n";
+  }
+  out << "}\n";
+}
@@ -0,0 +1,36 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef MDL_WRITER_HPP
+#define MDL_WRITER_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "keywordTable.hpp"
+#include "molStore.hpp"
+#include "reactionSpec.hpp"
+
+
+// MdlReaction holds the MDL text fragments of a single reaction
+struct MdlReaction {
+  std::string reactants;
+  std::string products;
+  std::string rate;
+  std::string name;
+};
+
+void writeKeywords(std::ostream& out, const KeywordTable& table);
+void writeKeywordBlock(std::ostream& out, const std::string& block,
+  const KeywordTable& table);
+void writeMoleculeBlock(std::ostream& out, const MolStore& mols);
+
+MdlReaction mdlReaction(const ReactionSpec& spec, const MolStore& mols);
+void writeReactionBlock(std::ostream& out,
+  const std::vector<MdlReaction>& reactions);
+
+#endif
@@ -0,0 +1,66 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+
+#include "modelState.hpp"
+#include "trace.hpp"
+
+
+// compileNetwork translates snapshots of the molecules and reactions into a
+// flat ReactionNetwork. Species are ordered as the molecules. Reactions with
+// invalid rates get rate zero and are counted in numInvalidRates. Reactions
+// the network can not represent (more than maxReactants reactants) are
+// replaced by an inert placeholder without reactants, products and rate so
+// that network reaction r remains snapshot reaction r; their indices are
+// returned in rejected. Since the snapshots are immutable this can run on
+// any thread.
+ReactionNetwork compileNetwork(const MolSnapshot& mols,
+  const ReactionSnapshot& reactions, int* numInvalidRates,
+  std::vector<int>* rejected) {
+  TRACE_SCOPE("compileNetwork", "model");
+  long long maxID = -1;
+  for (size_t i = 0; i < mols.size(); ++i) {
+    maxID = std::max(maxID, mols[i].id);
+  }
+  std::vector<int> rowOfID(maxID + 1, -1);
+  ReactionNetwork network;
+  network.numSpecies = mols.size();
+  for (size_t i = 0; i < mols.size(); ++i) {
+    rowOfID[mols[i].id] = i;
+    network.speciesNames.push_back(mols[i].name);
+  }
+
+  int invalid = 0;
+  std::vector<int> reacts;
+  std::vector<int> prods;
+  for (size_t r = 0; r < reactions.size(); ++r) {
+    const ReactionRecord& rec = reactions[r];
+    reacts.clear();
+    prods.clear();
+    for (auto id : rec.reactants) {
+      reacts.push_back(rowOfID[id]);
+    }
+    for (auto id : rec.products) {
+      prods.push_back(rowOfID[id]);
+    }
+    double rate = rec.rateValue;
+    if (!rec.rateValid) {
+      rate = 0.0;
+      ++invalid;
+    }
+    if (!network.addReaction(reacts, prods, rate)) {
+      network.addReaction({}, {}, 0.0);
+      if (rejected != nullptr) {
+        rejected->push_back(r);
+      }
+    }
+  }
+  if (numInvalidRates != nullptr) {
+    *numInvalidRates = invalid;
+  }
+  return network;
+}
@@ -0,0 +1,47 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef MODEL_STATE_HPP
+#define MODEL_STATE_HPP
+
+#include <string>
+#include <vector>
+
+#include "persistentVector.hpp"
+#include "reactionNetwork.hpp"
+
+
+// MolRecord is the immutable snapshot of a single molecule. DValue is NaN if
+// the D expression is invalid.
+struct MolRecord {
+  long long id;
+  std::string name;
+  std::string D;
+  double DValue;
+  bool surface;
+};
+
+
+// ReactionRecord is the immutable snapshot of a single reaction. Reactants
+// and products are given as molecule ids; NULL products are omitted.
+struct ReactionRecord {
+  std::vector<long long> reactants;
+  std::vector<long long> products;
+  std::string rate;
+  double rateValue;
+  bool rateValid;
+  std::string name;
+};
+
+
+using MolSnapshot = PersistentVector<MolRecord>;
+using ReactionSnapshot = PersistentVector<ReactionRecord>;
+
+ReactionNetwork compileNetwork(const MolSnapshot& mols,
+  const ReactionSnapshot& reactions, int* numInvalidRates = nullptr,
+  std::vector<int>* rejected = nullptr);
+
+#endif
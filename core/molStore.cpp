@@ -0,0 +1,171 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <utility>
+
+#include "molStore.hpp"
+
+
+// constructor
+MolStore::MolStore() : molCount_(0) {}
+
+
+// size returns the number of molecules
+int MolStore::size() const {
+  return mols_.size();
+}
+
+
+// mols returns the molecules in row order
+const MolList& MolStore::mols() const {
+  return mols_;
+}
+
+
+// at returns the molecule in row
+Molecule* MolStore::at(int row) {
+  return mols_[row].get();
+}
+
+
+// at returns the molecule in row
+const Molecule* MolStore::at(int row) const {
+  return mols_[row].get();
+}
+
+
+// rowOf returns the row of the molecule with the given id or -1 if there is
+// none
+int MolStore::rowOf(long long id) const {
+  auto it = std::find_if(mols_.begin(), mols_.end(),
+    [&id](const std::unique_ptr<Molecule>& m) { return m->id == id; });
+  return (it == mols_.end()) ? -1 : it - mols_.begin();
+}
+
+
+// find returns the molecule of given name or nullptr if there is none. The
+// name is hashed once to find its handle in the name pool, the molecule is
+// then looked up by handle.
+const Molecule* MolStore::find(const std::string& name) const {
+  return find(names_.find(name));
+}
+
+
+// find returns the molecule with the given interned name or nullptr if
+// there is none
+const Molecule* MolStore::find(const MolName& name) const {
+  auto it = byName_.find(name);
+  return (it == byName_.end()) ? nullptr : it->second;
+}
+
+
+// resolve returns the molecule referenced by handle in O(1) or nullptr if
+// the handle is null or its molecule has been deleted
+const Molecule* MolStore::resolve(MolHandle handle) const {
+  if (handle.index >= slots_.size()) {
+    return nullptr;
+  }
+  const MolSlot& slot = slots_[handle.index];
+  return (slot.generation == handle.generation) ? slot.mol : nullptr;
+}
+
+
+// names returns the pool of interned molecule names. It only holds the
+// names of current molecules.
+const MolNamePool& MolStore::names() const {
+  return names_;
+}
+
+
+// slotBytes returns the memory used by the slot map
+size_t MolStore::slotBytes() const {
+  return slots_.capacity() * sizeof(MolSlot) +
+    freeSlots_.capacity() * sizeof(uint32_t);
+}
+
+
+// create returns a new molecule with a fresh id and handle. Its name is
+// registered right away so later names of the same batch see it as taken.
+// The molecule has to be added via append. name must not be taken yet.
+std::unique_ptr<Molecule> MolStore::create(const std::string& name) {
+  assert(find(name) == nullptr);
+  auto m = std::unique_ptr<Molecule>(new Molecule());
+  m->id = molCount_++;
+  m->name = names_.intern(name);
+  m->type = MolType::VOL;
+  m->handle = allocateHandle_(m.get());
+  byName_[m->name] = m.get();
+  return m;
+}
+
+
+// append adds a molecule returned by create as the last row
+void MolStore::append(std::unique_ptr<Molecule> mol) {
+  mols_.push_back(std::move(mol));
+}
+
+
+// append adds molecules returned by create as the last rows
+void MolStore::append(MolList& mols) {
+  mols_.reserve(mols_.size() + mols.size());
+  std::move(mols.begin(), mols.end(), std::back_inserter(mols_));
+  mols.clear();
+}
+
+
+// rename changes the name of mol. This function returns false if name is
+// empty or already taken.
+bool MolStore::rename(Molecule* mol, const std::string& name) {
+  if (name.empty() || find(name) != nullptr) {
+    return false;
+  }
+  byName_.erase(mol->name);
+  names_.release(mol->name);
+  mol->name = names_.intern(name);
+  byName_[mol->name] = mol;
+  return true;
+}
+
+
+// remove deletes the molecule in row and invalidates all handles to it
+void MolStore::remove(int row) {
+  auto it = mols_.begin() + row;
+  byName_.erase((*it)->name);
+  names_.release((*it)->name);
+  releaseHandle_((*it)->handle);
+  mols_.erase(it);
+}
+
+
+// allocateHandle_ assigns a slot to m, reusing the slot of a deleted
+// molecule if possible, and returns the handle of m
+MolHandle MolStore::allocateHandle_(Molecule* m) {
+  uint32_t index;
+  if (freeSlots_.empty()) {
+    index = slots_.size();
+    slots_.push_back(MolSlot{nullptr, 1});
+  } else {
+    index = freeSlots_.back();
+    freeSlots_.pop_back();
+  }
+  slots_[index].mol = m;
+  return MolHandle(index, slots_[index].generation);
+}
+
+
+// releaseHandle_ frees the slot of a deleted molecule. Bumping the
+// generation invalidates all outstanding handles to it. A slot whose
+// generation would wrap around is retired instead of being reused.
+void MolStore::releaseHandle_(MolHandle handle) {
+  MolSlot& slot = slots_[handle.index];
+  slot.mol = nullptr;
+  if (++slot.generation != 0) {
+    freeSlots_.push_back(handle.index);
+  }
+}
@@ -0,0 +1,126 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef MOL_STORE_HPP
+#define MOL_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "stringPool.hpp"
+
+
+// MolType classifies 2D (SURF) or 3D (VOL) molecules
+enum class MolType {SURF, VOL};
+
+using MolNamePool = StringPool<std::string>;
+using MolName = Interned<std::string>;
+
+
+// MolHandle is a stable reference to a molecule of a MolStore. It indexes
+// the slot map of the store and carries the generation of the slot so that
+// handles of deleted molecules are detected instead of dangling. Slot
+// generations start at 1, the default constructed handle is null.
+struct MolHandle {
+  MolHandle() : index(0), generation(0) {}
+  MolHandle(uint32_t i, uint32_t g) : index(i), generation(g) {}
+
+  bool isNull() const {
+    return generation == 0;
+  }
+
+  uint64_t key() const {
+    return (static_cast<uint64_t>(generation) << 32) | index;
+  }
+
+  bool operator==(const MolHandle& other) const {
+    return key() == other.key();
+  }
+
+  bool operator!=(const MolHandle& other) const {
+    return key() != other.key();
+  }
+
+  bool operator<(const MolHandle& other) const {
+    return key() < other.key();
+  }
+
+  uint32_t index;
+  uint32_t generation;
+};
+
+
+// Molecule stores the data for a single molecule. The name is interned in
+// the MolNamePool of the owning MolStore. dField refers to the compiled
+// expression of D in the symbol table of the GUI and DValue caches its
+// value (NaN if the expression is invalid).
+struct Molecule {
+  long long id;
+  MolHandle handle;
+  MolName name;
+  std::string D;
+  MolType type;
+  int dField = -1;
+  double DValue = 0.0;
+};
+using MolList = std::vector<std::unique_ptr<Molecule>>;
+
+
+// MolStore owns the molecules of a model in row order together with the
+// name index and the slot map behind MolHandles. Molecules are created with
+// a unique id, name and handle and become rows once they are appended, so
+// that callers can announce bulk insertions before the rows appear.
+class MolStore {
+
+public:
+
+  MolStore();
+
+  int size() const;
+  const MolList& mols() const;
+  Molecule* at(int row);
+  const Molecule* at(int row) const;
+  int rowOf(long long id) const;
+  const Molecule* find(const std::string& name) const;
+  const Molecule* find(const MolName& name) const;
+  const Molecule* resolve(MolHandle handle) const;
+  const MolNamePool& names() const;
+  size_t slotBytes() const;
+
+  std::unique_ptr<Molecule> create(const std::string& name);
+  void append(std::unique_ptr<Molecule> mol);
+  void append(MolList& mols);
+  bool rename(Molecule* mol, const std::string& name);
+  void remove(int row);
+
+
+private:
+
+  MolHandle allocateHandle_(Molecule* m);
+  void releaseHandle_(MolHandle handle);
+
+  long long molCount_;
+  MolList mols_;
+
+  // slots_ is the slot map behind MolHandles. Slots of deleted molecules
+  // keep their bumped generation and are reused via freeSlots_. Moving
+  // molecules in mols_ only requires updating their slots.
+  struct MolSlot {
+    Molecule* mol;
+    uint32_t generation;
+  };
+  std::vector<MolSlot> slots_;
+  std::vector<uint32_t> freeSlots_;
+
+  MolNamePool names_;
+  std::unordered_map<MolName, Molecule*> byName_;
+};
+
+#endif
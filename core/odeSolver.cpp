@@ -0,0 +1,233 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <cmath>
+
+#include "odeSolver.hpp"
+
+namespace {
+
+double dot(const std::vector<double>& a, const std::vector<double>& b) {
+  double sum = 0.0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+// wrmsNorm returns the weighted root mean square norm of v using the error
+// weights derived from the reference solution x
+double wrmsNorm(const std::vector<double>& v, const std::vector<double>& x,
+  const OdeOptions& opts) {
+  if (v.empty()) {
+    return 0.0;
+  }
+  double sum = 0.0;
+  for (size_t i = 0; i < v.size(); ++i) {
+    double w = v[i] / (opts.atol + opts.rtol * std::fabs(x[i]));
+    sum += w * w;
+  }
+  return std::sqrt(sum / v.size());
+}
+
+}
+
+
+// solveBiCGSTAB solves A x = b with a Jacobi preconditioned BiCGSTAB
+// iteration using x as the initial guess
+bool solveBiCGSTAB(const SparseMatrix& A, const std::vector<double>& b,
+  std::vector<double>& x, double tol, int maxIter) {
+  int n = A.n;
+  std::vector<double> invDiag(n);
+  for (int i = 0; i < n; ++i) {
+    double d = A.values[A.diag[i]];
+    invDiag[i] = (d != 0.0) ? 1.0 / d : 1.0;
+  }
+
+  std::vector<double> r(n), rHat(n), p(n, 0.0), v(n, 0.0), s(n), t(n);
+  std::vector<double> y(n), z(n);
+  A.multiply(x.data(), r.data());
+  for (int i = 0; i < n; ++i) {
+    r[i] = b[i] - r[i];
+  }
+  rHat = r;
+  double bNorm = std::sqrt(dot(b, b));
+  if (bNorm == 0.0) {
+    bNorm = 1.0;
+  }
+  if (std::sqrt(dot(r, r)) / bNorm < tol) {
+    return true;
+  }
+
+  double rho = 1.0, alpha = 1.0, omega = 1.0;
+  for (int iter = 0; iter < maxIter; ++iter) {
+    double rhoNew = dot(rHat, r);
+    if (rhoNew == 0.0) {
+      return false;
+    }
+    double beta = (rhoNew / rho) * (alpha / omega);
+    rho = rhoNew;
+    for (int i = 0; i < n; ++i) {
+      p[i] = r[i] + beta * (p[i] - omega * v[i]);
+      y[i] = invDiag[i] * p[i];
+    }
+    A.multiply(y.data(), v.data());
+    double rHatV = dot(rHat, v);
+    if (rHatV == 0.0) {
+      return false;
+    }
+    alpha = rho / rHatV;
+    for (int i = 0; i < n; ++i) {
+      s[i] = r[i] - alpha * v[i];
+    }
+    if (std::sqrt(dot(s, s)) / bNorm < tol) {
+      for (int i = 0; i < n; ++i) {
+        x[i] += alpha * y[i];
+      }
+      return true;
+    }
+    for (int i = 0; i < n; ++i) {
+      z[i] = invDiag[i] * s[i];
+    }
+    A.multiply(z.data(), t.data());
+    double tt = dot(t, t);
+    omega = (tt != 0.0) ? dot(t, s) / tt : 0.0;
+    for (int i = 0; i < n; ++i) {
+      x[i] += alpha * y[i] + omega * z[i];
+      r[i] = s[i] - omega * t[i];
+    }
+    if (std::sqrt(dot(r, r)) / bNorm < tol) {
+      return true;
+    }
+    if (omega == 0.0) {
+      return false;
+    }
+  }
+  return false;
+}
+
+
+// integrateODE integrates the mass action ODEs with the two stage Rosenbrock
+// method ROS2 (Verwer et al., SIAM J. Sci. Comput. 20, 1999):
+//   (I - g h J) k1 = f(x)
+//   (I - g h J) k2 = f(x + h k1) - 2 k1
+//   x' = x + 3/2 h k1 + 1/2 h k2
+// with g = 1 + 1/sqrt(2). The embedded first order solution x + h k1 yields
+// the local error estimate used for step size control.
+bool integrateODE(const MassActionKernel& kernel, const std::vector<double>& x0,
+  const OdeOptions& opts, Trajectory& traj, const std::atomic<bool>* cancel,
+  std::string& error) {
+
+  int n = kernel.numSpecies();
+  if (int(x0.size()) != n) {
+    error = "initial values do not match the number of species";
+    return false;
+  }
+  if (opts.tEnd <= 0.0 || opts.numOutputs < 2) {
+    error = "invalid integration interval";
+    return false;
+  }
+
+  KernelWorkspace ws;
+  kernel.initWorkspace(ws);
+  SparseMatrix jac = kernel.jacobianPattern();
+  SparseMatrix m = jac;
+
+  traj.numSpecies = n;
+  traj.times.clear();
+  traj.values.clear();
+  traj.times.reserve(opts.numOutputs);
+  traj.values.reserve(size_t(opts.numOutputs) * n);
+  double outDt = opts.tEnd / (opts.numOutputs - 1);
+  traj.times.push_back(0.0);
+  traj.values.insert(traj.values.end(), x0.begin(), x0.end());
+  int nextOut = 1;
+
+  const double gamma = 1.0 + 1.0 / std::sqrt(2.0);
+  std::vector<double> x(x0), y(n), f(n), k1(n), k2(n), b(n), diff(n);
+  double t = 0.0;
+  double h = std::min(outDt, opts.tEnd * 1e-6);
+  double hMin = opts.tEnd * 1e-15;
+  bool newJacobian = true;
+
+  for (int step = 0; nextOut < opts.numOutputs; ++step) {
+    if (cancel != nullptr && cancel->load()) {
+      error = "cancelled";
+      return false;
+    }
+    if (step >= opts.maxSteps) {
+      error = "maximum number of steps exceeded";
+      return false;
+    }
+    if (h < hMin) {
+      error = "step size too small";
+      return false;
+    }
+    h = std::min(h, opts.tEnd - t);
+
+    // the rhs and Jacobian at x only change after an accepted step
+    if (newJacobian) {
+      kernel.rhs(x.data(), f.data(), ws);
+      kernel.jacobian(x.data(), jac, ws);
+      newJacobian = false;
+    }
+    for (size_t k = 0; k < m.values.size(); ++k) {
+      m.values[k] = -gamma * h * jac.values[k];
+    }
+    for (int i = 0; i < n; ++i) {
+      m.values[m.diag[i]] += 1.0;
+    }
+
+    k1 = f;
+    bool solved = solveBiCGSTAB(m, f, k1, 1e-10, 200);
+    if (solved) {
+      for (int i = 0; i < n; ++i) {
+        y[i] = x[i] + h * k1[i];
+      }
+      kernel.rhs(y.data(), b.data(), ws);
+      for (int i = 0; i < n; ++i) {
+        b[i] -= 2.0 * k1[i];
+      }
+      k2 = k1;
+      solved = solveBiCGSTAB(m, b, k2, 1e-10, 200);
+    }
+    if (!solved) {
+      h *= 0.25;
+      continue;
+    }
+
+    for (int i = 0; i < n; ++i) {
+      y[i] = x[i] + 1.5 * h * k1[i] + 0.5 * h * k2[i];
+      diff[i] = 0.5 * h * (k1[i] + k2[i]);
+    }
+    double err = wrmsNorm(diff, y, opts);
+    if (err > 1.0) {
+      h *= std::max(0.2, 0.9 / std::sqrt(err));
+      continue;
+    }
+
+    // accept the step and emit all output times it covers by linear
+    // interpolation
+    double tNew = (opts.tEnd - t - h <= hMin) ? opts.tEnd : t + h;
+    while (nextOut < opts.numOutputs && nextOut * outDt <= tNew + hMin) {
+      double tOut = std::min(nextOut * outDt, opts.tEnd);
+      double theta = (tOut - t) / (tNew - t);
+      traj.times.push_back(tOut);
+      for (int i = 0; i < n; ++i) {
+        traj.values.push_back(std::max(0.0, x[i] + theta * (y[i] - x[i])));
+      }
+      ++nextOut;
+    }
+    for (int i = 0; i < n; ++i) {
+      x[i] = std::max(y[i], 0.0);
+    }
+    t = tNew;
+    newJacobian = true;
+    h *= std::min(5.0, 0.9 / std::sqrt(std::max(err, 1e-4)));
+  }
+  return true;
+}
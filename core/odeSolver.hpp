@@ -0,0 +1,45 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef ODE_SOLVER_HPP
+#define ODE_SOLVER_HPP
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "massAction.hpp"
+
+
+// OdeOptions controls the implicit ODE integrator
+struct OdeOptions {
+  double tEnd = 1.0;
+  int numOutputs = 101;
+  double rtol = 1e-3;
+  double atol = 1e-12;
+  int maxSteps = 1000000;
+};
+
+
+// integrateODE integrates the mass action ODEs of kernel from the initial
+// values x0 up to opts.tEnd and stores the solution at numOutputs equally
+// spaced times in traj. The integrator is the L-stable, linearly implicit
+// Rosenbrock method ROS2 with adaptive step size. Its sparse linear systems
+// (I - g h J) are solved with Jacobi preconditioned BiCGSTAB, which makes it
+// suitable for stiff networks. The integration stops early if cancel is set.
+// This function returns true if it succeeds and false otherwise, in which
+// case error describes the problem.
+bool integrateODE(const MassActionKernel& kernel, const std::vector<double>& x0,
+  const OdeOptions& opts, Trajectory& traj, const std::atomic<bool>* cancel,
+  std::string& error);
+
+// solveBiCGSTAB solves A x = b with a Jacobi preconditioned BiCGSTAB
+// iteration using x as the initial guess. This function returns true if the
+// relative residual dropped below tol within maxIter iterations.
+bool solveBiCGSTAB(const SparseMatrix& A, const std::vector<double>& b,
+  std::vector<double>& x, double tol, int maxIter);
+
+#endif
@@ -0,0 +1,132 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef PERSISTENT_VECTOR_HPP
+#define PERSISTENT_VECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+// PersistentVector is an immutable vector stored as fixed size chunks which
+// are shared between successive versions. Copies are cheap (one shared
+// pointer per chunk) and can be read from any thread without locking since
+// published chunks are never modified.
+template<typename T>
+class PersistentVector {
+
+public:
+
+  static const size_t chunkSize = 256;
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  const T& operator[](size_t i) const {
+    return (*chunks_[i / chunkSize])[i % chunkSize];
+  }
+
+  // numChunks returns the number of chunks holding the elements
+  size_t numChunks() const {
+    return chunks_.size();
+  }
+
+  // numSharedChunks returns the number of chunks shared with other
+  size_t numSharedChunks(const PersistentVector& other) const {
+    size_t shared = 0;
+    for (size_t c = 0; c < chunks_.size() && c < other.chunks_.size(); ++c) {
+      shared += (chunks_[c] == other.chunks_[c]) ? 1 : 0;
+    }
+    return shared;
+  }
+
+
+private:
+
+  template<typename U> friend class PersistentVectorBuilder;
+
+  std::vector<std::shared_ptr<const std::vector<T>>> chunks_;
+  size_t size_ = 0;
+};
+
+
+// PersistentVectorBuilder is owned by a live, mutable container and
+// publishes PersistentVector versions of it. The owner reports which
+// elements changed; publish then only rebuilds the affected chunks and
+// shares all others with the previous version.
+template<typename T>
+class PersistentVectorBuilder {
+
+public:
+
+  // invalidate marks element i as changed
+  void invalidate(size_t i) {
+    size_t c = i / PersistentVector<T>::chunkSize;
+    if (c >= dirty_.size()) {
+      dirty_.resize(c + 1, false);
+    }
+    dirty_[c] = true;
+  }
+
+  // invalidateFrom marks element i and all following elements as changed,
+  // e.g. after an insertion or removal at i
+  void invalidateFrom(size_t i) {
+    dirtyFrom_ = std::min(dirtyFrom_, i / PersistentVector<T>::chunkSize);
+  }
+
+  // invalidateAll marks all elements as changed
+  void invalidateAll() {
+    dirtyFrom_ = 0;
+  }
+
+  // publish returns a version of the container with size elements. Changed
+  // chunks are rebuilt via make(i) which returns the i-th element.
+  template<typename Make>
+  const PersistentVector<T>& publish(size_t size, Make make) {
+    const size_t chunkSize = PersistentVector<T>::chunkSize;
+    size_t numChunks = (size + chunkSize - 1) / chunkSize;
+    const auto& old = current_.chunks_;
+    std::vector<std::shared_ptr<const std::vector<T>>> chunks(numChunks);
+    for (size_t c = 0; c < numChunks; ++c) {
+      size_t begin = c * chunkSize;
+      size_t end = std::min(size, begin + chunkSize);
+      bool clean = c < old.size() && c < dirtyFrom_
+        && (c >= dirty_.size() || !dirty_[c])
+        && old[c]->size() == end - begin;
+      if (clean) {
+        chunks[c] = old[c];
+        continue;
+      }
+      auto chunk = std::make_shared<std::vector<T>>();
+      chunk->reserve(end - begin);
+      for (size_t i = begin; i < end; ++i) {
+        chunk->push_back(make(i));
+      }
+      chunks[c] = std::move(chunk);
+    }
+    current_.chunks_ = std::move(chunks);
+    current_.size_ = size;
+    dirty_.clear();
+    dirtyFrom_ = static_cast<size_t>(-1);
+    return current_;
+  }
+
+
+private:
+
+  PersistentVector<T> current_;
+  std::vector<bool> dirty_;
+  size_t dirtyFrom_ = static_cast<size_t>(-1);
+};
+
+#endif
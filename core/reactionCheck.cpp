@@ -0,0 +1,130 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <cmath>
+#include <limits>
+
+#include "reactionCheck.hpp"
+#include "trace.hpp"
+
+namespace {
+
+const double pi = 3.14159265358979323846;
+const double avogadro = 6.0221415e23;
+
+// converts M^-1 s^-1 rates, um^2 areas and cm^2/s diffusion constants into
+// probabilities
+const double unitFactor = 1.0e11;
+
+const double notEstimated = std::numeric_limits<double>::quiet_NaN();
+
+}
+
+
+// checkReactions estimates the reaction probabilities of network. D and
+// surface give the diffusion constant [cm^2/s] and type of every species.
+// The first pass classifies each reaction and computes the factor which
+// converts its rate into a probability; the second pass applies it to all
+// rates at once. Bimolecular probabilities follow MCell:
+//
+//   p = k * 1e11 * sqrt(pi * dt / D_vol) / (2 * N_A * A)
+//
+// where D_vol is the sum of the diffusion constants of the volume reactants
+// and A the interaction area (pi * r_int^2 for volume-volume reactions and
+// the area of a surface grid tile for volume-surface reactions).
+ReactionCheck checkReactions(const ReactionNetwork& network,
+  const std::vector<double>& D, const std::vector<uint8_t>& surface,
+  const ProbabilityParams& params) {
+  TRACE_SCOPE("checkReactions", "model");
+  const int maxR = ReactionNetwork::maxReactants;
+  int numReacts = network.numReactions();
+  double radius = params.interactionRadius;
+  if (radius <= 0 && params.gridDensity > 0) {
+    radius = 1.0 / std::sqrt(pi * params.gridDensity);
+  }
+  double volArea = pi * radius * radius;
+  double tileArea = (params.gridDensity > 0) ? 1.0 / params.gridDensity : 0.0;
+  double dt = params.timeStep;
+
+  ReactionCheck check;
+  check.kinds.resize(numReacts);
+  std::vector<double> factors(numReacts);
+  for (int r = 0; r < numReacts; ++r) {
+    const int* reacts = &network.reactants[r * maxR];
+    int numVol = 0;
+    int numSurf = 0;
+    double dVol = 0.0;
+    for (int p = 0; p < maxR; ++p) {
+      int s = reacts[p];
+      if (s == network.numSpecies) {
+        continue;
+      }
+      if (surface[s]) {
+        ++numSurf;
+      } else {
+        ++numVol;
+        dVol += D[s];
+      }
+    }
+
+    ReactionKind kind = ReactionKind::Unsupported;
+    double area = 0.0;
+    if (numVol + numSurf == 1) {
+      kind = ReactionKind::Unimolecular;
+    } else if (numVol == 2 && numSurf == 0) {
+      kind = ReactionKind::VolVol;
+      area = volArea;
+    } else if (numVol == 1 && numSurf == 1) {
+      kind = ReactionKind::VolSurf;
+      area = tileArea;
+    }
+    check.kinds[r] = kind;
+
+    if (kind == ReactionKind::Unimolecular) {
+      factors[r] = dt;
+    } else if (kind != ReactionKind::Unsupported && dVol > 0 && area > 0) {
+      factors[r] = unitFactor * std::sqrt(pi * dt / dVol)
+        / (2.0 * avogadro * area);
+    } else {
+      factors[r] = notEstimated;
+    }
+  }
+
+  check.probabilities.resize(numReacts);
+  check.lifetimes.resize(numReacts);
+  const double* rates = network.rates.data();
+  const double* f = factors.data();
+  double* prob = check.probabilities.data();
+  for (int r = 0; r < numReacts; ++r) {
+    prob[r] = rates[r] * f[r];
+  }
+  for (int r = 0; r < numReacts; ++r) {
+    check.lifetimes[r] = (check.kinds[r] == ReactionKind::Unimolecular)
+      ? 1.0 / prob[r] : notEstimated;
+  }
+  return check;
+}
+
+
+// findReactionIssues returns the reactions whose probability exceeds
+// probabilityThreshold or whose lifetime is shorter than lifetimeThreshold
+// time steps, i.e. the reactions for which MCell would report
+// HIGH_REACTION_PROBABILITY or LIFETIME_TOO_SHORT
+std::vector<ReactionIssue> findReactionIssues(const ReactionCheck& check,
+  double probabilityThreshold, double lifetimeThreshold) {
+  std::vector<ReactionIssue> issues;
+  for (size_t r = 0; r < check.kinds.size(); ++r) {
+    double p = check.probabilities[r];
+    double lifetime = check.lifetimes[r];
+    bool high = check.kinds[r] != ReactionKind::Unimolecular
+      && p > probabilityThreshold;
+    bool shortLived = lifetime < lifetimeThreshold;
+    if (high || shortLived) {
+      issues.push_back(ReactionIssue{int(r), p, lifetime, high, shortLived});
+    }
+  }
+  return issues;
+}
@@ -0,0 +1,61 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef REACTION_CHECK_HPP
+#define REACTION_CHECK_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "reactionNetwork.hpp"
+
+
+// ReactionKind classifies reactions by the dimensionality of their
+// reactants which determines how MCell converts rates into probabilities.
+// Surface-surface and trimolecular reactions are not estimated.
+enum class ReactionKind : uint8_t {Unimolecular, VolVol, VolSurf,
+  Unsupported};
+
+
+// ProbabilityParams holds the simulation parameters entering the reaction
+// probabilities. Lengths are in um, the grid density in 1/um^2.
+struct ProbabilityParams {
+  double timeStep = 0.0;
+  double interactionRadius = 0.0;
+  double gridDensity = 10000.0;
+};
+
+
+// ReactionCheck holds the estimated probability per time step of every
+// reaction (for unimolecular reactions the expected number of events per
+// time step) and the lifetime in time steps of unimolecular reactions.
+// Values which cannot be estimated are NaN.
+struct ReactionCheck {
+  std::vector<ReactionKind> kinds;
+  std::vector<double> probabilities;
+  std::vector<double> lifetimes;
+};
+
+
+// ReactionIssue flags a reaction whose probability or lifetime exceeds the
+// MCell warning thresholds
+struct ReactionIssue {
+  int reaction;
+  double probability;
+  double lifetime;
+  bool highProbability;
+  bool shortLifetime;
+};
+
+
+ReactionCheck checkReactions(const ReactionNetwork& network,
+  const std::vector<double>& D, const std::vector<uint8_t>& surface,
+  const ProbabilityParams& params);
+
+std::vector<ReactionIssue> findReactionIssues(const ReactionCheck& check,
+  double probabilityThreshold, double lifetimeThreshold);
+
+#endif
@@ -0,0 +1,40 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include "reactionIndex.hpp"
+
+
+// canonicalReaction brings reactants and products into canonical form: NULL
+// products are dropped and both lists are sorted by molecule handle
+void canonicalReaction(std::vector<MolHandle>& reactants,
+  std::vector<MolHandle>& products) {
+  products.erase(std::remove(products.begin(), products.end(), MolHandle()),
+    products.end());
+  std::sort(reactants.begin(), reactants.end());
+  std::sort(products.begin(), products.end());
+}
+
+
+// reactionHash computes a 64 bit hash of a reaction in canonical form
+uint64_t reactionHash(const std::vector<MolHandle>& reactants,
+  const std::vector<MolHandle>& products) {
+  auto mix = [](uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+  };
+  uint64_t h = mix(reactants.size() + 0x9e3779b97f4a7c15ULL);
+  for (auto m : reactants) {
+    h = mix(h ^ m.key());
+  }
+  h = mix(h ^ (static_cast<uint64_t>(products.size()) << 32));
+  for (auto m : products) {
+    h = mix(h ^ m.key());
+  }
+  return h;
+}
@@ -0,0 +1,79 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef REACTION_INDEX_HPP
+#define REACTION_INDEX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "molStore.hpp"
+
+void canonicalReaction(std::vector<MolHandle>& reactants,
+  std::vector<MolHandle>& products);
+uint64_t reactionHash(const std::vector<MolHandle>& reactants,
+  const std::vector<MolHandle>& products);
+
+
+// ReactionIndex maps the canonical hash of reactions (sorted reactant and
+// product handles, NULL products omitted) to the reactions with this hash.
+// Reactions are stored as pointers to the type R used by the owning model;
+// since hashes may collide, callers compare the reactions of a bucket.
+template<typename R>
+class ReactionIndex {
+
+public:
+
+  using Bucket = std::vector<R*>;
+  using Map = std::unordered_map<uint64_t, Bucket>;
+
+  // add adds reaction with the given hash
+  void add(uint64_t hash, R* reaction) {
+    index_[hash].push_back(reaction);
+  }
+
+  // remove removes reaction with the given hash if it is indexed
+  void remove(uint64_t hash, R* reaction) {
+    auto it = index_.find(hash);
+    if (it == index_.end()) {
+      return;
+    }
+    auto& bucket = it->second;
+    bucket.erase(std::remove(bucket.begin(), bucket.end(), reaction),
+      bucket.end());
+    if (bucket.empty()) {
+      index_.erase(it);
+    }
+  }
+
+  // bucket returns the reactions with the given hash or nullptr if there
+  // are none
+  const Bucket* bucket(uint64_t hash) const {
+    auto it = index_.find(hash);
+    return (it == index_.end()) ? nullptr : &it->second;
+  }
+
+  size_t bucketCount() const {
+    return index_.bucket_count();
+  }
+
+  typename Map::const_iterator begin() const {
+    return index_.begin();
+  }
+
+  typename Map::const_iterator end() const {
+    return index_.end();
+  }
+
+
+private:
+
+  Map index_;
+};
+
+#endif
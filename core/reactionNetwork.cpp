@@ -0,0 +1,60 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include "reactionNetwork.hpp"
+
+const int ReactionNetwork::maxReactants;
+
+
+// order returns the number of reactants of reaction
+int ReactionNetwork::order(int reaction) const {
+  int count = 0;
+  for (int p = 0; p < maxReactants; ++p) {
+    if (reactants[reaction * maxReactants + p] != numSpecies) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+
+// addReaction appends a reaction with the given reactant and product species
+// indices. Reactions with more than maxReactants reactants are rejected and
+// false is returned.
+bool ReactionNetwork::addReaction(const std::vector<int>& reacts,
+  const std::vector<int>& prods, double rate) {
+  if (reacts.size() > size_t(maxReactants)) {
+    return false;
+  }
+  for (int p = 0; p < maxReactants; ++p) {
+    reactants.push_back(p < int(reacts.size()) ? reacts[p] : numSpecies);
+  }
+  products.insert(products.end(), prods.begin(), prods.end());
+  prodPtr.push_back(products.size());
+  rates.push_back(rate);
+  return true;
+}
+
+
+// stoichiometry returns the species x reactions stoichiometry matrix
+CSRMatrix ReactionNetwork::stoichiometry() const {
+  StoichBuilder builder(numSpecies);
+  builder.reserve(numReactions(), reactants.size() + products.size());
+  for (int r = 0; r < numReactions(); ++r) {
+    builder.beginReaction();
+    for (int p = 0; p < maxReactants; ++p) {
+      int s = reactants[r * maxReactants + p];
+      if (s != numSpecies) {
+        builder.addSpecies(s, -1);
+      }
+    }
+    for (int i = prodPtr[r]; i < prodPtr[r + 1]; ++i) {
+      builder.addSpecies(products[i], 1);
+    }
+    builder.endReaction();
+  }
+  return builder.toCSR();
+}
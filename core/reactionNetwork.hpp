@@ -0,0 +1,54 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef REACTION_NETWORK_HPP
+#define REACTION_NETWORK_HPP
+
+#include <string>
+#include <vector>
+
+#include "stoichMatrix.hpp"
+
+
+// ReactionNetwork is a flat, Qt independent representation of a mass action
+// reaction network used by the simulation previews. Every reaction has
+// maxReactants reactant slots; unused slots refer to the constant slot
+// numSpecies whose value is always one so rate kernels need no branches.
+struct ReactionNetwork {
+  static const int maxReactants = 3;
+
+  int numSpecies = 0;
+  std::vector<std::string> speciesNames;
+
+  std::vector<int> reactants;
+  std::vector<int> prodPtr = std::vector<int>(1, 0);
+  std::vector<int> products;
+  std::vector<double> rates;
+
+  int numReactions() const {
+    return rates.size();
+  }
+
+  int order(int reaction) const;
+  bool addReaction(const std::vector<int>& reacts,
+    const std::vector<int>& prods, double rate);
+  CSRMatrix stoichiometry() const;
+};
+
+
+// Trajectory stores species values at a sequence of output times. values
+// holds numSpecies entries per output time.
+struct Trajectory {
+  int numSpecies = 0;
+  std::vector<double> times;
+  std::vector<double> values;
+
+  const double* at(int i) const {
+    return values.data() + size_t(i) * numSpecies;
+  }
+};
+
+#endif
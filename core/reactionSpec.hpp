@@ -0,0 +1,26 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef REACTION_SPEC_HPP
+#define REACTION_SPEC_HPP
+
+#include <string>
+#include <vector>
+
+#include "molStore.hpp"
+
+
+// ReactionSpec describes a single reaction in terms of the molecules of a
+// MolStore. It is used for bulk insertion into the reaction model and for
+// writing the reaction to MDL. NULL products are given as null handles.
+struct ReactionSpec {
+  std::vector<MolHandle> reactants;
+  std::vector<MolHandle> products;
+  std::string rate;
+  std::string name;
+};
+
+#endif
@@ -0,0 +1,316 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "ssaSolver.hpp"
+
+namespace {
+
+const int numSlots = ReactionNetwork::maxReactants;
+const double avogadro = 6.02214076e23;
+const double infinity = std::numeric_limits<double>::infinity();
+
+}
+
+
+// constructor builds the heap over all keys
+IndexedPriorityQueue::IndexedPriorityQueue(const std::vector<double>& keys) :
+  keys_(keys), heap_(keys.size()), pos_(keys.size()) {
+  for (size_t i = 0; i < keys.size(); ++i) {
+    heap_[i] = i;
+    pos_[i] = i;
+  }
+  for (int i = int(heap_.size()) / 2 - 1; i >= 0; --i) {
+    siftDown_(i);
+  }
+}
+
+
+// top returns the index with the smallest key
+int IndexedPriorityQueue::top() const {
+  return heap_[0];
+}
+
+
+// topKey returns the smallest key
+double IndexedPriorityQueue::topKey() const {
+  return keys_[heap_[0]];
+}
+
+
+// key returns the current key of index i
+double IndexedPriorityQueue::key(int i) const {
+  return keys_[i];
+}
+
+
+// update changes the key of index i and restores the heap property
+void IndexedPriorityQueue::update(int i, double key) {
+  double old = keys_[i];
+  keys_[i] = key;
+  if (key < old) {
+    siftUp_(pos_[i]);
+  } else {
+    siftDown_(pos_[i]);
+  }
+}
+
+
+bool IndexedPriorityQueue::less_(int a, int b) const {
+  return keys_[heap_[a]] < keys_[heap_[b]];
+}
+
+
+void IndexedPriorityQueue::swap_(int a, int b) {
+  std::swap(heap_[a], heap_[b]);
+  pos_[heap_[a]] = a;
+  pos_[heap_[b]] = b;
+}
+
+
+void IndexedPriorityQueue::siftUp_(int pos) {
+  while (pos > 0) {
+    int parent = (pos - 1) / 2;
+    if (!less_(pos, parent)) {
+      break;
+    }
+    swap_(pos, parent);
+    pos = parent;
+  }
+}
+
+
+void IndexedPriorityQueue::siftDown_(int pos) {
+  int size = heap_.size();
+  while (true) {
+    int smallest = pos;
+    int left = 2 * pos + 1;
+    int right = left + 1;
+    if (left < size && less_(left, smallest)) {
+      smallest = left;
+    }
+    if (right < size && less_(right, smallest)) {
+      smallest = right;
+    }
+    if (smallest == pos) {
+      break;
+    }
+    swap_(pos, smallest);
+    pos = smallest;
+  }
+}
+
+
+
+// constructor compiles network for a well-mixed volume in liters
+SsaKernel::SsaKernel(const ReactionNetwork& network, double volume) :
+  numSpecies_(network.numSpecies) {
+
+  int numReacts = network.numReactions();
+  reactants_ = network.reactants;
+  offsets_.assign(reactants_.size(), 0);
+  c_.resize(numReacts);
+  double nav = avogadro * volume;
+  for (int r = 0; r < numReacts; ++r) {
+    int* slot = reactants_.data() + numSlots * r;
+    std::sort(slot, slot + numSlots);
+    for (int p = 1; p < numSlots; ++p) {
+      if (slot[p] == slot[p-1] && slot[p] != numSpecies_) {
+        offsets_[numSlots * r + p] = offsets_[numSlots * r + p - 1] + 1;
+      }
+    }
+    c_[r] = network.rates[r] / std::pow(nav, network.order(r) - 1);
+  }
+
+  CSRMatrix s = network.stoichiometry();
+  changePtr_.assign(numReacts + 1, 0);
+  for (int64_t k = 0; k < s.nnz(); ++k) {
+    ++changePtr_[s.colIdx[k] + 1];
+  }
+  for (int r = 0; r < numReacts; ++r) {
+    changePtr_[r + 1] += changePtr_[r];
+  }
+  changeSpecies_.resize(s.nnz());
+  changeDelta_.resize(s.nnz());
+  std::vector<int> next(changePtr_.begin(), changePtr_.end() - 1);
+  for (int i = 0; i < s.numRows; ++i) {
+    for (int64_t k = s.rowPtr[i]; k < s.rowPtr[i + 1]; ++k) {
+      int pos = next[s.colIdx[k]]++;
+      changeSpecies_[pos] = i;
+      changeDelta_[pos] = s.values[k];
+    }
+  }
+  buildDependencies_(network);
+}
+
+
+int SsaKernel::numSpecies() const {
+  return numSpecies_;
+}
+
+
+int SsaKernel::numReactions() const {
+  return c_.size();
+}
+
+
+// buildDependencies determines for every reaction the reactions which use
+// one of the species it changes as a reactant. A reaction always depends on
+// itself since it needs a new firing time after it fired.
+void SsaKernel::buildDependencies_(const ReactionNetwork& network) {
+  int numReacts = network.numReactions();
+
+  // consumers lists the reactions using each species as a reactant
+  std::vector<int> consumerPtr(numSpecies_ + 1, 0);
+  for (int r = 0; r < numReacts; ++r) {
+    for (int p = 0; p < numSlots; ++p) {
+      int s = reactants_[numSlots * r + p];
+      if (s != numSpecies_ && (p == 0 || s != reactants_[numSlots * r + p - 1])) {
+        ++consumerPtr[s + 1];
+      }
+    }
+  }
+  for (int s = 0; s < numSpecies_; ++s) {
+    consumerPtr[s + 1] += consumerPtr[s];
+  }
+  std::vector<int> consumers(consumerPtr.back());
+  std::vector<int> next(consumerPtr.begin(), consumerPtr.end() - 1);
+  for (int r = 0; r < numReacts; ++r) {
+    for (int p = 0; p < numSlots; ++p) {
+      int s = reactants_[numSlots * r + p];
+      if (s != numSpecies_ && (p == 0 || s != reactants_[numSlots * r + p - 1])) {
+        consumers[next[s]++] = r;
+      }
+    }
+  }
+
+  depPtr_.assign(1, 0);
+  std::vector<int> dep;
+  for (int r = 0; r < numReacts; ++r) {
+    dep.clear();
+    dep.push_back(r);
+    for (int k = changePtr_[r]; k < changePtr_[r + 1]; ++k) {
+      int s = changeSpecies_[k];
+      dep.insert(dep.end(), consumers.begin() + consumerPtr[s],
+        consumers.begin() + consumerPtr[s + 1]);
+    }
+    std::sort(dep.begin(), dep.end());
+    dep.erase(std::unique(dep.begin(), dep.end()), dep.end());
+    deps_.insert(deps_.end(), dep.begin(), dep.end());
+    depPtr_.push_back(deps_.size());
+  }
+}
+
+
+// propensity returns the propensity of reaction for the molecule counts x
+// which has an extra trailing slot with a count of one
+double SsaKernel::propensity_(int reaction, const int64_t* x) const {
+  const int* r = reactants_.data() + numSlots * reaction;
+  const int* o = offsets_.data() + numSlots * reaction;
+  double a = c_[reaction];
+  for (int p = 0; p < numSlots; ++p) {
+    a *= std::max<int64_t>(x[r[p]] - o[p], 0);
+  }
+  return a;
+}
+
+
+// simulate runs a single trajectory of the next reaction method
+bool SsaKernel::simulate(const std::vector<int64_t>& x0,
+  const SsaOptions& opts, uint64_t seed, Trajectory& traj,
+  const std::atomic<bool>* cancel, std::string& error,
+  int64_t* numEvents) const {
+
+  if (int(x0.size()) != numSpecies_) {
+    error = "initial counts do not match the number of species";
+    return false;
+  }
+  if (opts.tEnd <= 0.0 || opts.numOutputs < 2) {
+    error = "invalid simulation interval";
+    return false;
+  }
+
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  auto expSample = [&rng, &uniform](double a) {
+    return -std::log(1.0 - uniform(rng)) / a;
+  };
+
+  std::vector<int64_t> x(x0);
+  x.push_back(1);
+  int numReacts = numReactions();
+  std::vector<double> a(numReacts);
+  std::vector<double> tau(numReacts);
+  for (int r = 0; r < numReacts; ++r) {
+    a[r] = propensity_(r, x.data());
+    tau[r] = (a[r] > 0.0) ? expSample(a[r]) : infinity;
+  }
+  IndexedPriorityQueue queue(tau);
+
+  traj.numSpecies = numSpecies_;
+  traj.times.clear();
+  traj.values.clear();
+  traj.times.reserve(opts.numOutputs);
+  traj.values.reserve(size_t(opts.numOutputs) * numSpecies_);
+  double outDt = opts.tEnd / (opts.numOutputs - 1);
+  int nextOut = 0;
+  auto record = [&](double tLimit) {
+    while (nextOut < opts.numOutputs && nextOut * outDt < tLimit) {
+      traj.times.push_back(nextOut * outDt);
+      traj.values.insert(traj.values.end(), x.begin(), x.end() - 1);
+      ++nextOut;
+    }
+  };
+
+  int64_t events = 0;
+  while (numReacts > 0) {
+    double t = queue.topKey();
+    if (t > opts.tEnd) {
+      break;
+    }
+    if (events >= opts.maxEvents) {
+      error = "maximum number of events exceeded";
+      return false;
+    }
+    if ((events & 0xffff) == 0 && cancel != nullptr && cancel->load()) {
+      error = "cancelled";
+      return false;
+    }
+    record(t);
+
+    int mu = queue.top();
+    for (int k = changePtr_[mu]; k < changePtr_[mu + 1]; ++k) {
+      x[changeSpecies_[k]] += changeDelta_[k];
+    }
+    ++events;
+
+    // reuse the remaining waiting times of the dependent reactions by
+    // rescaling them with the ratio of old and new propensity
+    for (int k = depPtr_[mu]; k < depPtr_[mu + 1]; ++k) {
+      int r = deps_[k];
+      double aOld = a[r];
+      a[r] = propensity_(r, x.data());
+      double tauNew;
+      if (a[r] <= 0.0) {
+        tauNew = infinity;
+      } else if (r == mu || aOld <= 0.0) {
+        tauNew = t + expSample(a[r]);
+      } else {
+        tauNew = t + (aOld / a[r]) * (queue.key(r) - t);
+      }
+      queue.update(r, tauNew);
+    }
+  }
+  record(std::numeric_limits<double>::max());
+  if (numEvents != nullptr) {
+    *numEvents = events;
+  }
+  return true;
+}
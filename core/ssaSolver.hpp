@@ -0,0 +1,95 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef SSA_SOLVER_HPP
+#define SSA_SOLVER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "reactionNetwork.hpp"
+
+
+// IndexedPriorityQueue is a binary min-heap of the putative firing times of
+// all reactions which also tracks the heap position of every reaction so a
+// single reaction's key can be updated in O(log R)
+class IndexedPriorityQueue {
+
+public:
+
+  explicit IndexedPriorityQueue(const std::vector<double>& keys);
+
+  int top() const;
+  double topKey() const;
+  double key(int i) const;
+  void update(int i, double key);
+
+
+private:
+
+  bool less_(int a, int b) const;
+  void swap_(int a, int b);
+  void siftUp_(int pos);
+  void siftDown_(int pos);
+
+  std::vector<double> keys_;
+  std::vector<int> heap_;
+  std::vector<int> pos_;
+};
+
+
+// SsaOptions controls the stochastic simulation
+struct SsaOptions {
+  double tEnd = 1.0;
+  int numOutputs = 101;
+  int64_t maxEvents = 1000000000;
+};
+
+
+// SsaKernel is a ReactionNetwork compiled for exact stochastic simulation in
+// a well-mixed volume (in liters). Rates are converted from macroscopic
+// units (M^(1-n) s^-1) to stochastic rate constants and reactant slots are
+// sorted so that repeated reactants give the proper falling factorial
+// combinatorics without branching. The reaction dependency graph lists for
+// each reaction the reactions whose propensities change when it fires,
+// derived from which reactions use each changed species as a reactant.
+class SsaKernel {
+
+public:
+
+  SsaKernel(const ReactionNetwork& network, double volume);
+
+  int numSpecies() const;
+  int numReactions() const;
+
+  bool simulate(const std::vector<int64_t>& x0, const SsaOptions& opts,
+    uint64_t seed, Trajectory& traj, const std::atomic<bool>* cancel,
+    std::string& error, int64_t* numEvents = nullptr) const;
+
+
+private:
+
+  double propensity_(int reaction, const int64_t* x) const;
+  void buildDependencies_(const ReactionNetwork& network);
+
+  int numSpecies_;
+  std::vector<int> reactants_;
+  std::vector<int> offsets_;
+  std::vector<double> c_;
+
+  // net change in species counts per reaction in CSR format
+  std::vector<int> changePtr_;
+  std::vector<int> changeSpecies_;
+  std::vector<int> changeDelta_;
+
+  // reaction dependency graph in CSR format
+  std::vector<int> depPtr_;
+  std::vector<int> deps_;
+};
+
+#endif
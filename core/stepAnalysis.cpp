@@ -0,0 +1,237 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <cmath>
+
+#include "stepAnalysis.hpp"
+
+namespace {
+
+const double pi = 3.14159265358979323846;
+
+// conversion between cm (the length unit of D) and um
+const double cmToUm = 1e4;
+
+}
+
+
+// volStepLength returns the mean 3D diffusion step length [um] of a volume
+// molecule with diffusion constant D [cm^2/s] during timeStep [s]
+double StepAnalysis::volStepLength(double D, double timeStep) {
+  return 2.0 * std::sqrt(4.0 * D * timeStep / pi) * cmToUm;
+}
+
+
+// surfStepLength returns the mean 2D diffusion step length [um] of a surface
+// molecule with diffusion constant D [cm^2/s] during timeStep [s]
+double StepAnalysis::surfStepLength(double D, double timeStep) {
+  return std::sqrt(pi * D * timeStep) * cmToUm;
+}
+
+
+// volTimeStep returns the time step [s] at which a volume molecule with
+// diffusion constant D moves length [um] per step
+double StepAnalysis::volTimeStep(double D, double length) {
+  double l = length / cmToUm;
+  return pi * l * l / (16.0 * D);
+}
+
+
+// surfTimeStep returns the time step [s] at which a surface molecule with
+// diffusion constant D moves length [um] per step
+double StepAnalysis::surfTimeStep(double D, double length) {
+  double l = length / cmToUm;
+  return l * l / (pi * D);
+}
+
+
+// setMolecule adds or updates the molecule with the given id
+void StepAnalysis::setMolecule(long long id, double D, bool surface) {
+  auto it = slots_.find(id);
+  if (it != slots_.end()) {
+    Kind& kind = it->second.surface ? surf_ : vol_;
+    if (it->second.surface == surface && std::isfinite(D) && D > 0) {
+      double old = kind.D[it->second.index];
+      kind.D[it->second.index] = D;
+      if (!kind.dirty) {
+        if (old == kind.minD || old == kind.maxD) {
+          kind.dirty = true;
+        } else {
+          kind.minD = std::min(kind.minD, D);
+          kind.maxD = std::max(kind.maxD, D);
+        }
+      }
+      return;
+    }
+    erase_(kind, it->second.index);
+    slots_.erase(it);
+  }
+  if (!std::isfinite(D) || D <= 0) {
+    return;
+  }
+  Kind& kind = surface ? surf_ : vol_;
+  if (kind.D.empty()) {
+    kind.minD = D;
+    kind.maxD = D;
+  } else if (!kind.dirty) {
+    kind.minD = std::min(kind.minD, D);
+    kind.maxD = std::max(kind.maxD, D);
+  }
+  slots_[id] = Slot{surface, kind.D.size()};
+  kind.D.push_back(D);
+  kind.ids.push_back(id);
+}
+
+
+// removeMolecule removes the molecule with the given id
+void StepAnalysis::removeMolecule(long long id) {
+  auto it = slots_.find(id);
+  if (it == slots_.end()) {
+    return;
+  }
+  erase_(it->second.surface ? surf_ : vol_, it->second.index);
+  slots_.erase(it);
+}
+
+
+// clear removes all molecules
+void StepAnalysis::clear() {
+  vol_ = Kind();
+  surf_ = Kind();
+  slots_.clear();
+}
+
+
+// numMolecules returns the number of diffusing molecules
+int StepAnalysis::numMolecules() const {
+  return slots_.size();
+}
+
+
+// erase_ removes the entry at index by moving the last entry into its place
+void StepAnalysis::erase_(Kind& kind, size_t index) {
+  double D = kind.D[index];
+  size_t last = kind.D.size() - 1;
+  if (index != last) {
+    kind.D[index] = kind.D[last];
+    kind.ids[index] = kind.ids[last];
+    slots_[kind.ids[index]].index = index;
+  }
+  kind.D.pop_back();
+  kind.ids.pop_back();
+  if (D == kind.minD || D == kind.maxD) {
+    kind.dirty = true;
+  }
+}
+
+
+// updateRange_ recomputes the range of D values of kind if it is stale
+void StepAnalysis::updateRange_(const Kind& kind) const {
+  if (!kind.dirty) {
+    return;
+  }
+  kind.dirty = false;
+  if (kind.D.empty()) {
+    kind.minD = kind.maxD = 0.0;
+    return;
+  }
+  auto range = std::minmax_element(kind.D.begin(), kind.D.end());
+  kind.minD = *range.first;
+  kind.maxD = *range.second;
+}
+
+
+// stepLengths computes the mean step length of all volume or surface
+// molecules at timeStep. Since the step length is proportional to sqrt(D)
+// this is a single scaled square root per molecule.
+void StepAnalysis::stepLengths(bool surface, double timeStep,
+  std::vector<double>& lengths) const {
+  const Kind& kind = surface ? surf_ : vol_;
+  double scale = surface ? surfStepLength(1.0, timeStep)
+    : volStepLength(1.0, timeStep);
+  size_t n = kind.D.size();
+  lengths.resize(n);
+  const double* D = kind.D.data();
+  double* l = lengths.data();
+  for (size_t i = 0; i < n; ++i) {
+    l[i] = scale * std::sqrt(D[i]);
+  }
+}
+
+
+// stats returns the range and mean of the step lengths of all volume or
+// surface molecules at timeStep
+StepStats StepAnalysis::stats(bool surface, double timeStep) const {
+  const Kind& kind = surface ? surf_ : vol_;
+  StepStats s;
+  s.count = kind.D.size();
+  if (s.count == 0 || timeStep <= 0) {
+    return s;
+  }
+  updateRange_(kind);
+  double scale = surface ? surfStepLength(1.0, timeStep)
+    : volStepLength(1.0, timeStep);
+  double sum = 0.0;
+  const double* D = kind.D.data();
+  for (size_t i = 0; i < kind.D.size(); ++i) {
+    sum += std::sqrt(D[i]);
+  }
+  s.minLength = scale * std::sqrt(kind.minD);
+  s.maxLength = scale * std::sqrt(kind.maxD);
+  s.meanLength = scale * sum / s.count;
+  return s;
+}
+
+
+// recommend suggests time and space steps for a target mean step length
+// [um]. Step statistics are computed at timeStep if it is positive and at
+// the recommended time step otherwise. The interaction radius is the MCell
+// default for the given surface grid density [1/um^2].
+StepRecommendation StepAnalysis::recommend(double targetLength,
+  double timeStep, double gridDensity) const {
+  StepRecommendation rec;
+  rec.targetLength = targetLength;
+  if (gridDensity > 0) {
+    rec.interactionRadius = 1.0 / std::sqrt(pi * gridDensity);
+  }
+  updateRange_(vol_);
+  updateRange_(surf_);
+  if (targetLength <= 0 || slots_.empty()) {
+    return rec;
+  }
+
+  // the fastest molecule limits the global time step, the slowest one the
+  // maximum time step when MCell picks per molecule time steps via
+  // SPACE_STEP
+  double minDt = 0.0;
+  double maxDt = 0.0;
+  double minD = 0.0;
+  double maxD = 0.0;
+  if (!vol_.D.empty()) {
+    minDt = volTimeStep(vol_.maxD, targetLength);
+    maxDt = volTimeStep(vol_.minD, targetLength);
+    minD = vol_.minD;
+    maxD = vol_.maxD;
+  }
+  if (!surf_.D.empty()) {
+    double fast = surfTimeStep(surf_.maxD, targetLength);
+    double slow = surfTimeStep(surf_.minD, targetLength);
+    minDt = (minDt > 0) ? std::min(minDt, fast) : fast;
+    maxDt = std::max(maxDt, slow);
+    minD = (minD > 0) ? std::min(minD, surf_.minD) : surf_.minD;
+    maxD = std::max(maxD, surf_.maxD);
+  }
+  rec.timeStep = minDt;
+  rec.timeStepMax = maxDt;
+  rec.spaceStep = targetLength;
+  rec.dSpread = maxD / minD;
+
+  double dt = (timeStep > 0) ? timeStep : rec.timeStep;
+  rec.vol = stats(false, dt);
+  rec.surf = stats(true, dt);
+  return rec;
+}
@@ -0,0 +1,92 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef STEP_ANALYSIS_HPP
+#define STEP_ANALYSIS_HPP
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+
+// StepStats summarizes the mean diffusion step lengths [um] of either the
+// volume or the surface molecules at a given time step
+struct StepStats {
+  int count = 0;
+  double minLength = 0.0;
+  double meanLength = 0.0;
+  double maxLength = 0.0;
+};
+
+
+// StepRecommendation holds the suggested MCell time and space step
+// parameters for a target mean step length. timeStep is chosen such that
+// the fastest molecule moves targetLength per step, timeStepMax such that
+// the slowest one does. Values are 0 if there are no diffusing molecules.
+struct StepRecommendation {
+  double targetLength = 0.0;
+  double timeStep = 0.0;
+  double timeStepMax = 0.0;
+  double spaceStep = 0.0;
+  double interactionRadius = 0.0;
+  double dSpread = 0.0;
+  StepStats vol;
+  StepStats surf;
+};
+
+
+// StepAnalysis keeps the diffusion constants [cm^2/s] of all molecules in
+// separate contiguous arrays for volume and surface molecules so the step
+// lengths of all molecules can be computed in tight, vectorizable loops.
+// Single molecules are updated in O(1); the range of D values is only
+// recomputed for the kind of molecule which changed.
+class StepAnalysis {
+
+public:
+
+  void setMolecule(long long id, double D, bool surface);
+  void removeMolecule(long long id);
+  void clear();
+  int numMolecules() const;
+
+  StepStats stats(bool surface, double timeStep) const;
+  void stepLengths(bool surface, double timeStep,
+    std::vector<double>& lengths) const;
+  StepRecommendation recommend(double targetLength, double timeStep,
+    double gridDensity) const;
+
+  static double volStepLength(double D, double timeStep);
+  static double surfStepLength(double D, double timeStep);
+  static double volTimeStep(double D, double length);
+  static double surfTimeStep(double D, double length);
+
+
+private:
+
+  // Kind holds the molecules of one type. D values which are invalid or not
+  // positive are not stored since these molecules do not diffuse.
+  struct Kind {
+    std::vector<double> D;
+    std::vector<long long> ids;
+    mutable double minD = 0.0;
+    mutable double maxD = 0.0;
+    mutable bool dirty = false;
+  };
+
+  struct Slot {
+    bool surface;
+    size_t index;
+  };
+
+  void erase_(Kind& kind, size_t index);
+  void updateRange_(const Kind& kind) const;
+
+  Kind vol_;
+  Kind surf_;
+  std::unordered_map<long long, Slot> slots_;
+};
+
+#endif
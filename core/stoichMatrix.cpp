@@ -0,0 +1,123 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <cassert>
+
+#include "stoichMatrix.hpp"
+
+
+// constructor
+StoichBuilder::StoichBuilder(int numSpecies) : numSpecies_(numSpecies) {
+  colPtr_.push_back(0);
+}
+
+
+// reserve preallocates storage for the expected number of reactions and
+// non-zero entries
+void StoichBuilder::reserve(int numReactions, int64_t numEntries) {
+  colPtr_.reserve(numReactions + 1);
+  rowIdx_.reserve(numEntries);
+  vals_.reserve(numEntries);
+}
+
+
+// beginReaction starts a new column
+void StoichBuilder::beginReaction() {
+  assert(colPtr_.back() == static_cast<int64_t>(rowIdx_.size()));
+}
+
+
+// addSpecies adds coeff to the entry of species in the current column
+void StoichBuilder::addSpecies(int species, int coeff) {
+  assert(species >= 0 && species < numSpecies_);
+  rowIdx_.push_back(species);
+  vals_.push_back(coeff);
+}
+
+
+// endReaction finishes the current column by sorting its entries by species,
+// combining duplicates and dropping zero entries. Columns only contain a
+// handful of entries so insertion sort is used.
+void StoichBuilder::endReaction() {
+  int64_t begin = colPtr_.back();
+  int64_t end = rowIdx_.size();
+  for (int64_t i = begin + 1; i < end; ++i) {
+    int row = rowIdx_[i];
+    int val = vals_[i];
+    int64_t j = i;
+    for (; j > begin && rowIdx_[j-1] > row; --j) {
+      rowIdx_[j] = rowIdx_[j-1];
+      vals_[j] = vals_[j-1];
+    }
+    rowIdx_[j] = row;
+    vals_[j] = val;
+  }
+
+  int64_t out = begin;
+  for (int64_t i = begin; i < end; ) {
+    int row = rowIdx_[i];
+    int val = 0;
+    for (; i < end && rowIdx_[i] == row; ++i) {
+      val += vals_[i];
+    }
+    if (val != 0) {
+      rowIdx_[out] = row;
+      vals_[out] = val;
+      ++out;
+    }
+  }
+  rowIdx_.resize(out);
+  vals_.resize(out);
+  colPtr_.push_back(out);
+}
+
+
+// toCSR converts the column wise assembled matrix into CSR format via a
+// counting sort over the species. Column indices within each row come out
+// sorted.
+CSRMatrix StoichBuilder::toCSR() const {
+  CSRMatrix m;
+  m.numRows = numSpecies_;
+  m.numCols = colPtr_.size() - 1;
+  m.rowPtr.assign(m.numRows + 1, 0);
+  for (auto r : rowIdx_) {
+    ++m.rowPtr[r + 1];
+  }
+  for (int r = 0; r < m.numRows; ++r) {
+    m.rowPtr[r + 1] += m.rowPtr[r];
+  }
+
+  m.colIdx.resize(rowIdx_.size());
+  m.values.resize(rowIdx_.size());
+  std::vector<int64_t> next(m.rowPtr.begin(), m.rowPtr.end() - 1);
+  for (int c = 0; c < m.numCols; ++c) {
+    for (int64_t k = colPtr_[c]; k < colPtr_[c + 1]; ++k) {
+      int64_t pos = next[rowIdx_[k]]++;
+      m.colIdx[pos] = c;
+      m.values[pos] = vals_[k];
+    }
+  }
+  return m;
+}
+
+
+// writeMatrixMarket writes m in Matrix Market coordinate format with 1-based
+// indices. This function returns true if it succeeds and false otherwise.
+bool writeMatrixMarket(std::ostream& out, const CSRMatrix& m,
+  const std::vector<std::string>& rowLabels) {
+  out << "%%MatrixMarket matrix coordinate integer general\n";
+  for (size_t r = 0; r < rowLabels.size(); ++r) {
+    out << "% row " << r + 1 << " " << rowLabels[r] << "\n";
+  }
+  out << m.numRows << " " << m.numCols << " " << m.nnz() << "\n";
+  for (int r = 0; r < m.numRows; ++r) {
+    for (int64_t k = m.rowPtr[r]; k < m.rowPtr[r + 1]; ++k) {
+      out << r + 1 << " " << m.colIdx[k] + 1 << " " << m.values[k] << "\n";
+    }
+  }
+  return out.good();
+}
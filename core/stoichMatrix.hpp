@@ -0,0 +1,63 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef STOICH_MATRIX_HPP
+#define STOICH_MATRIX_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+// CSRMatrix is a sparse integer matrix in compressed sparse row format
+struct CSRMatrix {
+  int numRows = 0;
+  int numCols = 0;
+  std::vector<int64_t> rowPtr;
+  std::vector<int> colIdx;
+  std::vector<int> values;
+
+  int64_t nnz() const {
+    return colIdx.size();
+  }
+};
+
+
+// StoichBuilder assembles a species x reactions stoichiometry matrix one
+// reaction (column) at a time. Reactants contribute negative and products
+// positive coefficients; repeated species within a reaction are combined
+// and entries with a net coefficient of zero are dropped.
+class StoichBuilder {
+
+public:
+
+  explicit StoichBuilder(int numSpecies);
+
+  void reserve(int numReactions, int64_t numEntries);
+
+  void beginReaction();
+  void addSpecies(int species, int coeff);
+  void endReaction();
+
+  CSRMatrix toCSR() const;
+
+
+private:
+
+  int numSpecies_;
+  std::vector<int64_t> colPtr_;
+  std::vector<int> rowIdx_;
+  std::vector<int> vals_;
+};
+
+
+// writeMatrixMarket writes m in Matrix Market coordinate format. rowLabels,
+// if not empty, are written as comments naming each row.
+bool writeMatrixMarket(std::ostream& out, const CSRMatrix& m,
+  const std::vector<std::string>& rowLabels);
+
+#endif
@@ -0,0 +1,133 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef STRING_POOL_HPP
+#define STRING_POOL_HPP
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+
+
+template<typename S, typename Hash> class StringPool;
+
+
+// Interned is a handle to a string stored once in a StringPool. Handles of
+// the same pool compare and hash by address, i.e. without looking at the
+// characters. A default constructed handle is null and refers to the empty
+// string.
+template<typename S>
+class Interned {
+
+public:
+
+  Interned() : str_(nullptr) {}
+
+  bool isNull() const {
+    return str_ == nullptr;
+  }
+
+  const S& str() const {
+    static const S empty;
+    return (str_ == nullptr) ? empty : *str_;
+  }
+
+  size_t hash() const {
+    return std::hash<const S*>()(str_);
+  }
+
+  bool operator==(const Interned& other) const {
+    return str_ == other.str_;
+  }
+
+  bool operator!=(const Interned& other) const {
+    return str_ != other.str_;
+  }
+
+
+private:
+
+  template<typename T, typename Hash> friend class StringPool;
+
+  explicit Interned(const S* str) : str_(str) {}
+
+  const S* str_;
+};
+
+
+namespace std {
+
+template<typename S>
+struct hash<Interned<S>> {
+  size_t operator()(const Interned<S>& s) const {
+    return s.hash();
+  }
+};
+
+}
+
+
+// StringPool stores each distinct string once and hands out Interned
+// handles to it. The characters of a string are hashed only when it is
+// interned or looked up; afterwards all comparisons use the handles.
+// Strings are reference counted: every intern has to be matched by a
+// release, and a string is freed once its last handle is released. Handles
+// to released strings dangle. Like the models owning them, pools are not
+// thread safe for writing.
+template<typename S, typename Hash = std::hash<S>>
+class StringPool {
+
+public:
+
+  using Map = std::unordered_map<S, size_t, Hash>;
+
+  // intern returns the handle of s, adding s to the pool if necessary, and
+  // takes a reference to it
+  Interned<S> intern(const S& s) {
+    auto it = strings_.insert(std::make_pair(s, size_t(0))).first;
+    ++it->second;
+    return Interned<S>(&it->first);
+  }
+
+  // release drops a reference taken by intern and frees the string once it
+  // is no longer referenced
+  void release(const Interned<S>& s) {
+    if (s.isNull()) {
+      return;
+    }
+    auto it = strings_.find(*s.str_);
+    if (it != strings_.end() && --it->second == 0) {
+      strings_.erase(it);
+    }
+  }
+
+  // find returns the handle of s or a null handle if s is not in the pool.
+  // Unlike intern this neither grows the pool nor takes a reference.
+  Interned<S> find(const S& s) const {
+    auto it = strings_.find(s);
+    return (it == strings_.end()) ? Interned<S>() : Interned<S>(&it->first);
+  }
+
+  size_t size() const {
+    return strings_.size();
+  }
+
+  typename Map::const_iterator begin() const {
+    return strings_.begin();
+  }
+
+  typename Map::const_iterator end() const {
+    return strings_.end();
+  }
+
+
+private:
+
+  Map strings_;
+};
+
+#endif
@@ -0,0 +1,122 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "trace.hpp"
+
+std::atomic<bool> Tracer::enabled_(false);
+
+namespace {
+
+// TraceEvent is a single completed scope
+struct TraceEvent {
+  const char* name;
+  const char* category;
+  int64_t start;
+  int64_t end;
+};
+
+// TraceBuffer holds the events recorded by a single thread. The mutex is
+// only ever contended while a trace is being written.
+struct TraceBuffer {
+  int tid;
+  std::mutex mutex;
+  std::vector<TraceEvent> events;
+};
+
+std::mutex buffersMutex;
+std::vector<std::shared_ptr<TraceBuffer>> buffers;
+
+const auto epoch = std::chrono::steady_clock::now();
+
+// localBuffer returns the trace buffer of the calling thread and registers
+// it on first use
+TraceBuffer& localBuffer() {
+  thread_local std::shared_ptr<TraceBuffer> buffer;
+  if (!buffer) {
+    buffer = std::make_shared<TraceBuffer>();
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer->tid = buffers.size() + 1;
+    buffers.push_back(buffer);
+  }
+  return *buffer;
+}
+
+// writeJSONString writes s as a quoted and escaped JSON string
+void writeJSONString(std::ostream& out, const char* s) {
+  out << '"';
+  for (; *s != '\0'; ++s) {
+    if (*s == '"' || *s == '\\') {
+      out << '\\';
+    }
+    out << *s;
+  }
+  out << '"';
+}
+
+}
+
+
+// setEnabled turns recording of trace points on or off
+void Tracer::setEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+
+// now returns the current trace time stamp in nanoseconds
+int64_t Tracer::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - epoch).count();
+}
+
+
+// record adds a completed scope to the calling thread's trace buffer
+void Tracer::record(const char* name, const char* category, int64_t start,
+  int64_t end) {
+  TraceBuffer& buffer = localBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  buffer.events.push_back(TraceEvent{name, category, start, end});
+}
+
+
+// writeChromeTrace writes all recorded events in the Chrome trace event JSON
+// format to fileName. This function returns true if it succeeds and false
+// otherwise.
+bool Tracer::writeChromeTrace(const std::string& fileName) {
+  std::ofstream out(fileName);
+  if (!out) {
+    return false;
+  }
+
+  out << std::fixed << std::setprecision(3);
+  out << "{\"traceEvents\":[\n";
+  bool first = true;
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  for (auto& b : buffers) {
+    std::lock_guard<std::mutex> bufferLock(b->mutex);
+    for (const auto& e : b->events) {
+      if (!first) {
+        out << ",\n";
+      }
+      first = false;
+      out << "{\"name\":";
+      writeJSONString(out, e.name);
+      out << ",\"cat\":";
+      writeJSONString(out, e.category);
+      out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+          << ",\"ts\":" << e.start / 1000.0
+          << ",\"dur\":" << (e.end - e.start) / 1000.0 << "}";
+    }
+  }
+  out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+  return out.good();
+}
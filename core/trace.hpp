@@ -0,0 +1,77 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+
+// Tracer collects timed scopes which can be dumped as a Chrome trace
+// (chrome://tracing or ui.perfetto.dev). Recording is off by default; when
+// disabled a trace point costs a single relaxed atomic load.
+class Tracer {
+
+public:
+
+  static bool enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+  static void setEnabled(bool enabled);
+
+  static int64_t now();
+  static void record(const char* name, const char* category, int64_t start,
+    int64_t end);
+  static bool writeChromeTrace(const std::string& fileName);
+
+
+private:
+
+  static std::atomic<bool> enabled_;
+};
+
+
+// ScopedTrace records the lifetime of a scope with the Tracer. Name and
+// category have to be string literals since only the pointers are stored.
+class ScopedTrace {
+
+public:
+
+  ScopedTrace(const char* name, const char* category) : name_(name),
+    category_(category), start_(Tracer::enabled() ? Tracer::now() : -1) {}
+
+  ~ScopedTrace() {
+    if (start_ >= 0) {
+      Tracer::record(name_, category_, start_, Tracer::now());
+    }
+  }
+
+  ScopedTrace(const ScopedTrace&) = delete;
+  ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+
+private:
+
+  const char* name_;
+  const char* category_;
+  int64_t start_;
+};
+
+
+// TRACE_SCOPE adds a trace point covering the rest of the enclosing scope.
+// Defining MCELLGUI_NO_TRACE compiles all trace points out.
+#ifdef MCELLGUI_NO_TRACE
+#define TRACE_SCOPE(name, category)
+#else
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name, category) \
+  ScopedTrace TRACE_CONCAT(traceScope_, __LINE__)(name, category)
+#endif
+
+#endif
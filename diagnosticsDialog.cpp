@@ -0,0 +1,48 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <QDialogButtonBox>
+#include <QFontDatabase>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+#include "diagnosticsDialog.hpp"
+#include "memoryReport.hpp"
+
+
+// constructor
+DiagnosticsDialog::DiagnosticsDialog(const MolModel* molModel,
+  const ReactTreeModel* reactModel,
+  const QList<const QAbstractProxyModel*>& proxies, QWidget* parent) :
+  QDialog(parent), molModel_(molModel), reactModel_(reactModel),
+  proxies_(proxies) {
+
+  setWindowTitle(tr("Memory Usage"));
+  reportView_ = new QPlainTextEdit(this);
+  reportView_->setReadOnly(true);
+  reportView_->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+  auto buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+  QPushButton* refreshButton = buttons->addButton(tr("Refresh"),
+    QDialogButtonBox::ActionRole);
+  connect(refreshButton, SIGNAL(clicked()), this, SLOT(refresh()));
+  connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+
+  auto layout = new QVBoxLayout(this);
+  layout->addWidget(reportView_);
+  layout->addWidget(buttons);
+  resize(560, 300);
+
+  refresh();
+}
+
+
+// refresh recomputes the memory report and displays it
+void DiagnosticsDialog::refresh() {
+  MemoryReport report = collectMemoryReport(molModel_, reactModel_, proxies_);
+  reportView_->setPlainText(report.toText());
+}
@@ -0,0 +1,43 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef DIAGNOSTICS_DIALOG_HPP
+#define DIAGNOSTICS_DIALOG_HPP
+
+#include <QDialog>
+#include <QList>
+
+class MolModel;
+class QAbstractProxyModel;
+class QPlainTextEdit;
+class ReactTreeModel;
+
+// DiagnosticsDialog displays the estimated memory usage of the models
+class DiagnosticsDialog : public QDialog {
+
+  Q_OBJECT
+
+public:
+
+  DiagnosticsDialog(const MolModel* molModel, const ReactTreeModel* reactModel,
+    const QList<const QAbstractProxyModel*>& proxies, QWidget* parent = 0);
+
+
+private slots:
+
+  void refresh();
+
+
+private:
+
+  const MolModel* molModel_;
+  const ReactTreeModel* reactModel_;
+  QList<const QAbstractProxyModel*> proxies_;
+
+  QPlainTextEdit* reportView_;
+};
+
+#endif
@@ -0,0 +1,110 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <QDateTime>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+
+#include "expansionDialog.hpp"
+
+namespace {
+
+const QString exampleTemplates(
+  "# one template per line\n"
+  "#   R1 + R2 -> P1 + P2 [rate] : name\n"
+  "# reactants are regular expressions matching complete molecule names,\n"
+  "# products, rate and name may use the captures of all reactants via \\N\n"
+  "# or shifted integer captures via {\\N+k} and {\\N-k}\n"
+  "S_p(\\d+) + K -> S_p{\\1+1} + K [kp] : phos_\\1\n");
+
+}
+
+
+// constructor
+ExpansionDialog::ExpansionDialog(const MolModel* molModel,
+  ReactTreeModel* reactModel, QWidget* parent) : QDialog(parent),
+  molModel_(molModel), reactModel_(reactModel) {
+
+  setWindowTitle(tr("Expand Reaction Templates"));
+  setModal(true);
+
+  templateEdit_ = new QPlainTextEdit(exampleTemplates, this);
+  generateButton_ = new QPushButton(tr("Generate"), this);
+  closeButton_ = new QPushButton(tr("Close"), this);
+  auto buttons = new QHBoxLayout;
+  buttons->addStretch();
+  buttons->addWidget(generateButton_);
+  buttons->addWidget(closeButton_);
+
+  statusLabel_ = new QLabel(this);
+  statusLabel_->setWordWrap(true);
+  auto layout = new QVBoxLayout(this);
+  layout->addWidget(templateEdit_);
+  layout->addWidget(statusLabel_);
+  layout->addLayout(buttons);
+  resize(600, 400);
+
+  connect(generateButton_, SIGNAL(clicked()), this, SLOT(generate()));
+  connect(closeButton_, SIGNAL(clicked()), this, SLOT(close()));
+  connect(&watcher_, SIGNAL(finished()), this, SLOT(generateFinished()));
+}
+
+
+// destructor waits for an outstanding expansion
+ExpansionDialog::~ExpansionDialog() {
+  watcher_.waitForFinished();
+}
+
+
+// generate parses the templates and starts the expansion in the background
+void ExpansionDialog::generate() {
+  if (watcher_.isRunning()) {
+    return;
+  }
+  QList<ReactionTemplate> templates;
+  QString error;
+  if (!parseReactionTemplates(templateEdit_->toPlainText(), templates,
+      error)) {
+    statusLabel_->setText(error);
+    return;
+  }
+  startTime_ = QDateTime::currentMSecsSinceEpoch();
+  watcher_.setFuture(QtConcurrent::run(expandTemplates, templates,
+    molModel_));
+  generateButton_->setEnabled(false);
+  closeButton_->setEnabled(false);
+  statusLabel_->setText(tr("expanding %1 templates ...")
+    .arg(templates.size()));
+}
+
+
+// generateFinished adds the expanded reactions to the reaction model in a
+// single bulk insertion and reports what was generated
+void ExpansionDialog::generateFinished() {
+  generateButton_->setEnabled(true);
+  closeButton_->setEnabled(true);
+  const ExpansionResult& result = watcher_.future().result();
+  if (!result.error.isEmpty()) {
+    statusLabel_->setText(result.error);
+    return;
+  }
+  int numAdded = reactModel_->addReactions(result.reactions, true);
+  double seconds = (QDateTime::currentMSecsSinceEpoch() - startTime_) / 1000.0;
+  QString status = tr("%1 reactant combinations, %2 without matching "
+    "products, added %3 reactions (%4 duplicates skipped) in %5 s")
+    .arg(result.numCombinations).arg(result.numMissingProducts).arg(numAdded)
+    .arg(result.reactions.size() - numAdded).arg(seconds, 0, 'g', 3);
+  if (result.numFailedSubstitutions > 0) {
+    status += tr("\n%1 combinations skipped since captures could not be "
+      "substituted, first in %2").arg(result.numFailedSubstitutions)
+      .arg(result.firstFailedSubstitution);
+  }
+  statusLabel_->setText(status);
+}
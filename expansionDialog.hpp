@@ -0,0 +1,54 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef EXPANSION_DIALOG_HPP
+#define EXPANSION_DIALOG_HPP
+
+#include <QDialog>
+#include <QFutureWatcher>
+
+#include "reactionExpansion.hpp"
+
+class QLabel;
+class QPlainTextEdit;
+class QPushButton;
+
+
+// ExpansionDialog expands reaction templates over the molecule names and
+// adds the resulting reactions to the reaction model. The dialog is modal
+// since the expansion runs in the background on the current molecules.
+class ExpansionDialog : public QDialog {
+
+  Q_OBJECT
+
+public:
+
+  ExpansionDialog(const MolModel* molModel, ReactTreeModel* reactModel,
+    QWidget* parent = 0);
+  ~ExpansionDialog();
+
+
+private slots:
+
+  void generate();
+  void generateFinished();
+
+
+private:
+
+  const MolModel* molModel_;
+  ReactTreeModel* reactModel_;
+
+  QPlainTextEdit* templateEdit_;
+  QPushButton* generateButton_;
+  QPushButton* closeButton_;
+  QLabel* statusLabel_;
+
+  QFutureWatcher<ExpansionResult> watcher_;
+  qint64 startTime_ = 0;
+};
+
+#endif
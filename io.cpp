@@ -4,6 +4,8 @@
 //
 // mcellGUI is a simulation GUI for MCell (www.mcell.org)
 
+#include <fstream>
+#include <sstream>
 
 #include <QFile>
 #include <QTextStream>
@@ -12,16 +14,18 @@
 #include "noteWarnModel.hpp"
 #include "paramModel.hpp"
 #include "reactionModel.hpp"
+#include "symbolModel.hpp"
 
 #include "io.hpp"
-
-const QString TAB("  ");
+#include "mdlWriter.hpp"
+#include "trace.hpp"
 
 // writeMDL is responsible for writing model MDL files based on the data model.
 // This function returns true if it succeeds and false otherwise.
 bool writeMDL(QString fileName, const MolModel* molModel,
   const ParamModel* paramModel, const NotificationsModel* noteModel,
   const WarningsModel* warnModel, const ReactTreeModel* reactModel) {
+  TRACE_SCOPE("writeMDL", "io");
 
   QFile file(fileName);
   if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
@@ -29,6 +33,7 @@ bool writeMDL(QString fileName, const MolModel* molModel,
   }
 
   QTextStream out(&file);
+  writeSymbols(out, molModel->symbols());
   writeParams(out, paramModel);
   writeNotifications(out, noteModel);
   out << "\n";
@@ -36,80 +41,97 @@ bool writeMDL(QString fileName, const MolModel* molModel,
   out << "\n";
   writeMolecules(out, molModel);
   out << "\n";
-  //writeReactions(out, reactModel);
+  writeReactions(out, molModel, reactModel);
 
   return true;
 }
 
 
-// writeParams writes the model parameters to the QTextStream
-void writeParams(QTextStream& out, const ParamModel* paramModel) {
-  for (int i = 0; i < paramModel->rowCount(); ++i) {
-    if (paramModel->item(i, 1)->text() == "") {
-      continue;
-    }
-    out << paramModel->item(i, 0)->text() << " = "
-        << paramModel->item(i, 1)->text() << "\n";
+// writeSymbols writes the user defined symbols to the QTextStream. Symbols
+// are written after the symbols their expressions refer to.
+void writeSymbols(QTextStream& out, const SymbolModel* symbolModel) {
+  TRACE_SCOPE("writeSymbols", "io");
+  auto defs = symbolModel->definitions();
+  if (defs.isEmpty()) {
+    return;
+  }
+  for (const auto& d : defs) {
+    out << d.first << " = " << d.second << "\n";
   }
   out << "\n";
 }
 
 
+// writeParams writes the model parameters to the QTextStream
+void writeParams(QTextStream& out, const ParamModel* paramModel) {
+  TRACE_SCOPE("writeParams", "io");
+  std::ostringstream params;
+  writeKeywords(params, paramModel->table());
+  out << QString::fromStdString(params.str()) << "\n";
+}
+
+
 // writeNotifications writes the model notifications to the QTextStream
 void writeNotifications(QTextStream& out, const NotificationsModel* noteModel) {
-  out << "NOTIFICATIONS {\n";
-  for (int i = 0; i < noteModel->rowCount(); ++i) {
-    if (noteModel->item(i, 1)->text() == "UNSET") {
-      continue;
-    }
-    out << noteModel->item(i, 0)->text() << " = "
-        << noteModel->item(i, 1)->text() << "\n";
-  }
-  out << "}\n";
+  TRACE_SCOPE("writeNotifications", "io");
+  std::ostringstream block;
+  writeKeywordBlock(block, "NOTIFICATIONS", noteModel->table());
+  out << QString::fromStdString(block.str());
 }
 
 // writeWarnings writes the model warnings to the QTextStream
 void writeWarnings(QTextStream& out, const WarningsModel* warnModel) {
-  out << "WARNINGS {\n";
-  for (int i = 0; i < warnModel->rowCount(); ++i) {
-    if (warnModel->item(i, 1)->text() == "UNSET") {
-      continue;
-    }
-    out << warnModel->item(i, 0)->text() << " = "
-        << warnModel->item(i, 1)->text() << "\n";
-  }
-  out << "}\n";
+  TRACE_SCOPE("writeWarnings", "io");
+  std::ostringstream block;
+  writeKeywordBlock(block, "WARNINGS", warnModel->table());
+  out << QString::fromStdString(block.str());
 }
 
 // writeMolecules writes the molecule info to the QTextStream.
 void writeMolecules(QTextStream& out, const MolModel* molModel) {
+  TRACE_SCOPE("writeMolecules", "io");
+  std::ostringstream block;
+  writeMoleculeBlock(block, molModel->store());
+  out << QString::fromStdString(block.str());
+}
+
+// writeStoichiometryMatrix writes the species x reactions stoichiometry
+// matrix in Matrix Market format. Rows are labeled with the molecule names.
+// This function returns true if it succeeds and false otherwise.
+bool writeStoichiometryMatrix(QString fileName, const MolModel* molModel,
+  const ReactTreeModel* reactModel) {
+  TRACE_SCOPE("writeStoichiometryMatrix", "io");
 
-  const MolList& molecules = molModel->getMols();
-  out << "DEFINE_MOLECULES {\n";
-
-  for (const auto& m : molecules) {
-    out << TAB << m->name << " {\n";
-    if (m->type == MolType::VOL) {
-      out << TAB << TAB << "DIFFUSION_CONSTANT_3D";
-    } else {
-      out << TAB << TAB << "DIFFUSION_CONSTANT_2D";
-    }
-    out << " = " << m->D << "\n";
-    out << TAB << "}\n";
+  std::ofstream out(QFile::encodeName(fileName).constData());
+  if (!out) {
+    return false;
   }
-  out << "}\n";
+  std::vector<std::string> labels;
+  for (const auto& m : molModel->getMols()) {
+    labels.push_back(m->name.str());
+  }
+  return writeMatrixMarket(out, reactModel->stoichiometryMatrix(molModel),
+    labels);
 }
 
-#if 0
-// writeReactinos writes the molecule info to the QTextStream.
-void writeReactions(QTextStream& out, const ReactionModel* reactModel) {
+// writeReactions writes the reaction info to the QTextStream.
+void writeReactions(QTextStream& out, const MolModel* molModel,
+  const ReactTreeModel* reactModel) {
+  TRACE_SCOPE("writeReactions", "io");
+  std::ostringstream block;
+  writeReactionBlock(block, collectReactions(molModel, reactModel));
+  out << QString::fromStdString(block.str());
+}
 
-  const ReactList& reacts = reactModel->getReactions();
-  out << "DEFINE_REACTIONS {\n";
 
-  for (const auto& r : reacts) {
-    out << TAB << r->reactant1->name << "\n";
+// collectReactions converts the reactions in the model into their MDL text
+// fragments
+std::vector<MdlReaction> collectReactions(const MolModel* molModel,
+  const ReactTreeModel* reactModel) {
+  std::vector<MdlReaction> reactions;
+  reactions.reserve(reactModel->numReactions());
+  for (int r = 0; r < reactModel->numReactions(); ++r) {
+    reactions.push_back(mdlReaction(reactModel->spec(r), molModel->store()));
   }
-  out << "}\n";
+  return reactions;
 }
-#endif
@@ -7,21 +7,37 @@
 #ifndef IO_HPP
 #define IO_HPP
 
+#include <vector>
+
+#include <QString>
+
+#include "mdlWriter.hpp"
+
 class MolModel;
 class ParamModel;
 class ReactTreeModel;
+class SymbolModel;
 class NotificationsModel;
 class WarningsModel;
 class QTextStream;
 
+
+bool writeStoichiometryMatrix(QString fileName, const MolModel* molModel,
+  const ReactTreeModel* reactModel);
+
 bool writeMDL(QString fileName, const MolModel* molModel,
   const ParamModel* paramModel, const NotificationsModel* noteModel,
   const WarningsModel* warnModel, const ReactTreeModel* reactModel);
 
+void writeSymbols(QTextStream& out, const SymbolModel* symbolModel);
 void writeParams(QTextStream& out, const ParamModel* paramModel);
 void writeNotifications(QTextStream& out, const NotificationsModel* noteModel);
 void writeWarnings(QTextStream& out, const WarningsModel* noteModel);
 void writeMolecules(QTextStream& out, const MolModel* molModel);
-//void writeReactions(QTextStream& out, const ReactionModel* reactModel);
+void writeReactions(QTextStream& out, const MolModel* molModel,
+  const ReactTreeModel* reactModel);
+
+std::vector<MdlReaction> collectReactions(const MolModel* molModel,
+  const ReactTreeModel* reactModel);
 
 #endif
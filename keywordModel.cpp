@@ -0,0 +1,97 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include "keywordModel.hpp"
+
+
+// constructor
+KeywordModel::KeywordModel(const KeywordTable& table, QObject* parent) :
+  QAbstractTableModel(parent), table_(table) {}
+
+
+// rowCount returns the number of keywords
+int KeywordModel::rowCount(const QModelIndex& parent) const {
+  return parent.isValid() ? 0 : table_.size();
+}
+
+
+// columnCount returns the number of columns (keyword and value)
+int KeywordModel::columnCount(const QModelIndex& parent) const {
+  return parent.isValid() ? 0 : 2;
+}
+
+
+// data returns the keyword name or value at index
+QVariant KeywordModel::data(const QModelIndex& index, int role) const {
+  if (!index.isValid() || index.row() >= table_.size()
+      || (role != Qt::DisplayRole && role != Qt::EditRole)) {
+    return QVariant();
+  }
+  if (index.column() == KeywordCol::Name) {
+    return QString(table_.keyword(index.row()).name);
+  }
+  return QString::fromStdString(table_.value(index.row()));
+}
+
+
+// flags marks the value column as editable
+Qt::ItemFlags KeywordModel::flags(const QModelIndex& index) const {
+  Qt::ItemFlags flags = QAbstractTableModel::flags(index);
+  if (index.isValid() && index.column() == KeywordCol::Value) {
+    flags |= Qt::ItemIsEditable;
+  }
+  return flags;
+}
+
+
+// setData changes the value of a keyword
+bool KeywordModel::setData(const QModelIndex& index, const QVariant& value,
+  int role) {
+  if (!index.isValid() || role != Qt::EditRole
+      || index.column() != KeywordCol::Value) {
+    return false;
+  }
+  if (!table_.setValue(index.row(), value.toString().toStdString())) {
+    return false;
+  }
+  snapshot_.reset();
+  emit dataChanged(index, index);
+  return true;
+}
+
+
+// table returns the underlying keyword table
+const KeywordTable& KeywordModel::table() const {
+  return table_;
+}
+
+
+// snapshot returns an immutable copy of the keyword table which can be read
+// from any thread. Repeated calls share the copy until a value changes.
+std::shared_ptr<const KeywordTable> KeywordModel::snapshot() const {
+  if (!snapshot_) {
+    snapshot_ = std::make_shared<const KeywordTable>(table_);
+  }
+  return snapshot_;
+}
+
+
+// value returns the value of the given keyword or an empty string if the
+// keyword does not exist
+QString KeywordModel::value(const QString& keyWord) const {
+  return QString::fromStdString(table_.value(keyWord.toStdString()));
+}
+
+
+// setValue sets the value of the given keyword. This function returns false
+// if the keyword does not exist.
+bool KeywordModel::setValue(const QString& keyWord, const QString& value) {
+  int row = table_.find(keyWord.toStdString());
+  if (row < 0) {
+    return false;
+  }
+  return setData(index(row, KeywordCol::Value), value);
+}
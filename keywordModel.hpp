@@ -0,0 +1,54 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef KEYWORD_MODEL_HPP
+#define KEYWORD_MODEL_HPP
+
+#include <QAbstractTableModel>
+#include <QString>
+
+#include <memory>
+
+#include "keywordTable.hpp"
+
+// KeywordCol names the columns of a KeywordModel
+namespace KeywordCol {
+  enum col {Name, Value};
+}
+
+
+// KeywordModel is a thin table model adapter exposing a KeywordTable to the
+// Qt views. All data lives in the table which the non GUI code accesses
+// directly.
+class KeywordModel : public QAbstractTableModel {
+
+public:
+
+  KeywordModel(const KeywordTable& table, QObject* parent = 0);
+
+  int rowCount(const QModelIndex& parent = QModelIndex()) const;
+  int columnCount(const QModelIndex& parent = QModelIndex()) const;
+  QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+  Qt::ItemFlags flags(const QModelIndex& index) const;
+  bool setData(const QModelIndex& index, const QVariant& value,
+    int role = Qt::EditRole);
+
+  const KeywordTable& table() const;
+  std::shared_ptr<const KeywordTable> snapshot() const;
+  QString value(const QString& keyWord) const;
+  bool setValue(const QString& keyWord, const QString& value);
+
+
+private:
+
+  KeywordTable table_;
+
+  // snapshot_ caches an immutable copy of table_ for worker threads and is
+  // dropped whenever a value changes
+  mutable std::shared_ptr<const KeywordTable> snapshot_;
+};
+
+#endif
@@ -6,36 +6,45 @@
 
 #include <QDebug>
 
+#include <QFile>
 #include <QFileDialog>
+#include <QMessageBox>
+#include <QTextStream>
 
+#include "diagnosticsDialog.hpp"
+#include "expansionDialog.hpp"
 #include "io.hpp"
 #include "mainWindow.hpp"
+#include "odePreviewDialog.hpp"
+#include "reactionCheck.hpp"
+#include "runDialog.hpp"
+#include "sbmlImport.hpp"
+#include "ssaPreviewDialog.hpp"
+#include "sweepDialog.hpp"
+#include "tableImport.hpp"
+#include "trace.hpp"
 
 // constructor
 MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags) :
   QMainWindow(parent, flags) {
 
+  TRACE_SCOPE("MainWindow::MainWindow", "ui");
   setupUi(this);
 
-  // initialize and propagate models to view widgets
+  // initialize the models. The symbol model is shared by the diffusion
+  // constant and rate expressions.
+  symbolModel_ = new SymbolModel(this);
   paramModel_ = new ParamModel(this);
-  paramTab->initModel(paramModel_);
-
   noteModel_ = new NotificationsModel(this);
   warnModel_ = new WarningsModel(this);
-  noteWarnTab->initModel(noteModel_, warnModel_);
-
-  moleculeModel_ = new MolModel(this);
-  molTab->initModel(moleculeModel_);
-
-  reactTreeModel_ = new ReactTreeModel(this);
-  reactTab->initModel(reactTreeModel_, moleculeModel_);
+  moleculeModel_ = new MolModel(this, symbolModel_);
+  reactTreeModel_ = new ReactTreeModel(moleculeModel_, this, symbolModel_);
 
   // connect reaction model to molecule tracked in molecule model
-  connect(reactTreeModel_, SIGNAL(useMol(long)), moleculeModel_,
-    SLOT(markMoleculeUsed(long)));
-  connect(reactTreeModel_, SIGNAL(unuseMol(long)), moleculeModel_,
-    SLOT(markMoleculeUnused(long)));
+  connect(reactTreeModel_, SIGNAL(molUseChanged(const MolUseDeltas&)),
+    moleculeModel_, SLOT(updateMoleculeUse(const MolUseDeltas&)));
+  connect(moleculeModel_, SIGNAL(molRenamed(long)), reactTreeModel_,
+    SLOT(updateMolecule(long)));
 
   // add some fake molecule data
   moleculeModel_->addMol("A", "1e-3", MolType::VOL);
@@ -44,6 +53,68 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags) :
 
   // signals and slots
   connect(exportMDLAction, SIGNAL(triggered(bool)), this, SLOT(exportMDL_()));
+  connect(importMolsAction, SIGNAL(triggered(bool)), this,
+    SLOT(importMolecules_()));
+  connect(importReactionsAction, SIGNAL(triggered(bool)), this,
+    SLOT(importReactions_()));
+  connect(importSBMLAction, SIGNAL(triggered(bool)), this,
+    SLOT(importSBML_()));
+  connect(exportStoichAction, SIGNAL(triggered(bool)), this,
+    SLOT(exportStoichiometry_()));
+  connect(sweepAction, SIGNAL(triggered(bool)), this, SLOT(showSweep_()));
+  connect(runAction, SIGNAL(triggered(bool)), this, SLOT(showRuns_()));
+  connect(odePreviewAction, SIGNAL(triggered(bool)), this,
+    SLOT(showOdePreview_()));
+  connect(ssaPreviewAction, SIGNAL(triggered(bool)), this,
+    SLOT(showSsaPreview_()));
+  connect(expandAction, SIGNAL(triggered(bool)), this,
+    SLOT(showExpansion_()));
+  connect(duplicatesAction, SIGNAL(triggered(bool)), this,
+    SLOT(findDuplicateReactions_()));
+  connect(probabilityCheckAction, SIGNAL(triggered(bool)), this,
+    SLOT(checkReactionProbabilities_()));
+  connect(memoryUsageAction, SIGNAL(triggered(bool)), this,
+    SLOT(showMemoryUsage_()));
+
+  // the widgets of each tab are created and bound to their models when the
+  // tab is first shown
+  connect(tabWidget, SIGNAL(currentChanged(int)), this, SLOT(initTab_(int)));
+  initTab_(tabWidget->currentIndex());
+  tabWidget->installEventFilter(this);
+}
+
+
+// initTab_ creates the widgets of the tab at index and binds them to their
+// models unless this already happened
+void MainWindow::initTab_(int index) {
+  QWidget* tab = tabWidget->widget(index);
+  if (tab == nullptr || initializedTabs_.contains(tab)) {
+    return;
+  }
+  TRACE_SCOPE("MainWindow::initTab", "ui");
+  initializedTabs_.insert(tab);
+  if (tab == paramTab) {
+    paramTab->initModel(paramModel_, moleculeModel_);
+  } else if (tab == symbolTab) {
+    symbolTab->initModel(symbolModel_);
+  } else if (tab == molTab) {
+    molTab->initModel(moleculeModel_);
+  } else if (tab == reactTab) {
+    reactTab->initModel(reactTreeModel_, moleculeModel_);
+  } else if (tab == noteWarnTab) {
+    noteWarnTab->initModel(noteModel_, warnModel_);
+  }
+}
+
+
+// eventFilter emits firstPaint once the tab widget has been painted for the
+// first time
+bool MainWindow::eventFilter(QObject* watched, QEvent* event) {
+  if (watched == tabWidget && event->type() == QEvent::Paint) {
+    tabWidget->removeEventFilter(this);
+    emit firstPaint();
+  }
+  return QMainWindow::eventFilter(watched, event);
 }
 
 
@@ -52,10 +123,327 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags) :
 void MainWindow::exportMDL_() {
   QString mdlFileName = QFileDialog::getSaveFileName(this, tr("Export MDL"),
     QDir::homePath(), tr("MCell Model Files (*.mdl)"));
-  if (mdlFileName.isEmpty()) {
+  if (mdlFileName.isEmpty() || !checkReactions_(true)) {
+    return;
+  }
+  if (!writeMDL(mdlFileName, moleculeModel_, paramModel_, noteModel_,
+      warnModel_, reactTreeModel_)) {
+    QMessageBox::critical(this, tr("Export MDL"),
+      tr("Could not write %1.").arg(mdlFileName), QMessageBox::Close);
+    return;
+  }
+  lastMDLFile_ = mdlFileName;
+  if (runDialog_ != nullptr) {
+    runDialog_->setMDLFile(lastMDLFile_);
+  }
+}
+
+
+// importMolecules_ asks the user for a CSV or TSV file with molecules and
+// adds all valid rows to the molecule model in one bulk insertion
+void MainWindow::importMolecules_() {
+  QString fileName = QFileDialog::getOpenFileName(this,
+    tr("Import Molecules"), QDir::homePath(),
+    tr("Delimited Text Files (*.csv *.tsv *.txt)"));
+  if (fileName.isEmpty()) {
+    return;
+  }
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    QMessageBox::critical(this, tr("Import Molecules"),
+      tr("Could not open %1.").arg(fileName), QMessageBox::Close);
     return;
   }
-  writeMDL(mdlFileName, moleculeModel_, paramModel_, noteModel_, warnModel_,
-    reactTreeModel_);
+  QTextStream in(&file);
+  MolImport result = importMolecules(in, moleculeModel_);
+  int numAdded = moleculeModel_->addMols(result.mols);
+  showImportReport(this, tr("Import Molecules"), tr("molecules"), numAdded,
+    result);
+}
+
+
+// importReactions_ asks the user for a CSV or TSV file with reactions and
+// adds all valid rows to the reaction model in one bulk insertion. Reactions
+// already in the model are skipped.
+void MainWindow::importReactions_() {
+  QString fileName = QFileDialog::getOpenFileName(this,
+    tr("Import Reactions"), QDir::homePath(),
+    tr("Delimited Text Files (*.csv *.tsv *.txt)"));
+  if (fileName.isEmpty()) {
+    return;
+  }
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    QMessageBox::critical(this, tr("Import Reactions"),
+      tr("Could not open %1.").arg(fileName), QMessageBox::Close);
+    return;
+  }
+  QTextStream in(&file);
+  ReactionImport result = importReactions(in, moleculeModel_);
+  int numAdded = reactTreeModel_->addReactions(result.reactions, true);
+  showImportReport(this, tr("Import Reactions"), tr("reactions"), numAdded,
+    result);
+}
+
+
+// importSBML_ asks the user for an SBML file and adds its species and mass
+// action reactions to the models. Constructs without an MCell equivalent
+// are listed in the report.
+void MainWindow::importSBML_() {
+  QString fileName = QFileDialog::getOpenFileName(this, tr("Import SBML"),
+    QDir::homePath(), tr("SBML Files (*.xml *.sbml)"));
+  if (fileName.isEmpty()) {
+    return;
+  }
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    QMessageBox::critical(this, tr("Import SBML"),
+      tr("Could not open %1.").arg(fileName), QMessageBox::Close);
+    return;
+  }
+  SbmlImport result = importSBML(&file, moleculeModel_, reactTreeModel_);
+  QString msg = tr("Added %1 of %2 species and %3 of %4 reactions.")
+    .arg(result.numMols).arg(result.numSpecies).arg(result.numReactions)
+    .arg(result.numRows);
+  if (!result.error.isEmpty()) {
+    msg += " " + tr("The file could not be read completely: %1")
+      .arg(result.error);
+  }
+  if (result.numErrors == 0 && result.error.isEmpty()) {
+    QMessageBox::information(this, tr("Import SBML"), msg);
+    return;
+  }
+  QString details = result.errors.join("\n");
+  if (result.numErrors > result.errors.size()) {
+    details += tr("\n... and %1 more")
+      .arg(result.numErrors - result.errors.size());
+  }
+  QMessageBox box(QMessageBox::Warning, tr("Import SBML"), msg,
+    QMessageBox::Close, this);
+  box.setDetailedText(details);
+  box.exec();
+}
+
+
+// exportStoichiometry asks the user for the export path and then writes the
+// stoichiometry matrix of the reaction network in Matrix Market format
+void MainWindow::exportStoichiometry_() {
+  QString fileName = QFileDialog::getSaveFileName(this,
+    tr("Export Stoichiometry Matrix"), QDir::homePath(),
+    tr("Matrix Market Files (*.mtx)"));
+  if (fileName.isEmpty()) {
+    return;
+  }
+  if (!writeStoichiometryMatrix(fileName, moleculeModel_, reactTreeModel_)) {
+    QMessageBox::critical(this, tr("Export Stoichiometry Matrix"),
+      tr("Could not write %1.").arg(fileName), QMessageBox::Close);
+  }
 }
 
+
+// showSweep opens the non-modal parameter sweep dialog
+void MainWindow::showSweep_() {
+  if (sweepDialog_ == nullptr) {
+    sweepDialog_ = new SweepDialog(moleculeModel_, paramModel_, noteModel_,
+      warnModel_, reactTreeModel_, this);
+  }
+  sweepDialog_->show();
+  sweepDialog_->raise();
+  sweepDialog_->activateWindow();
+}
+
+
+// findDuplicateReactions reports all groups of reactions which only differ
+// in the order of their reactants or products
+void MainWindow::findDuplicateReactions_() {
+  auto groups = reactTreeModel_->findDuplicates();
+  if (groups.empty()) {
+    QMessageBox::information(this, tr("Duplicate Reactions"),
+      tr("No duplicate reactions found."));
+    return;
+  }
+  QString details;
+  for (const auto& g : groups) {
+    for (auto row : g) {
+      details += QString("%1: %2\n").arg(row + 1)
+        .arg(reactTreeModel_->reaction(row)->name().simplified());
+    }
+    details += "\n";
+  }
+  QMessageBox box(QMessageBox::Warning, tr("Duplicate Reactions"),
+    tr("Found %1 groups of duplicate reactions. Duplicate reactions add up "
+    "their rates in MCell.").arg(groups.size()), QMessageBox::Close, this);
+  box.setDetailedText(details);
+  box.exec();
+}
+
+
+// showRuns opens the non-modal dialog for running MCell on exported MDL
+// files. Runs continue while the dialog is hidden.
+void MainWindow::showRuns_() {
+  if (runDialog_ == nullptr) {
+    runDialog_ = new RunDialog(this);
+    runDialog_->setMDLFile(lastMDLFile_);
+  }
+  runDialog_->show();
+  runDialog_->raise();
+  runDialog_->activateWindow();
+}
+
+
+// showExpansion opens the modal dialog for expanding reaction templates
+// into concrete reactions
+void MainWindow::showExpansion_() {
+  if (expansionDialog_ == nullptr) {
+    expansionDialog_ = new ExpansionDialog(moleculeModel_, reactTreeModel_,
+      this);
+  }
+  expansionDialog_->show();
+  expansionDialog_->raise();
+  expansionDialog_->activateWindow();
+}
+
+
+// checkReactionProbabilities reports all reactions with high probabilities
+// or short lifetimes
+void MainWindow::checkReactionProbabilities_() {
+  checkReactions_(false);
+}
+
+
+// checkReactions_ estimates the per time step probabilities and lifetimes
+// of all reactions and lists those which exceed the HIGH_PROBABILITY_THRESHOLD
+// and LIFETIME_THRESHOLD warning settings. When exporting, the user can
+// choose to export anyway and the function returns false if the export
+// should be aborted.
+bool MainWindow::checkReactions_(bool exporting) {
+  double dt = paramModel_->value("TIME_STEP").toDouble();
+  if (dt <= 0) {
+    if (!exporting) {
+      QMessageBox::information(this, tr("Reaction Probabilities"),
+        tr("Reaction probabilities require a positive TIME_STEP."));
+    }
+    return true;
+  }
+  ProbabilityParams params;
+  params.timeStep = dt;
+  params.interactionRadius =
+    paramModel_->value("INTERACTION_RADIUS").toDouble();
+  params.gridDensity = paramModel_->value("SURFACE_GRID_DENSITY").toDouble();
+
+  const MolList& mols = moleculeModel_->getMols();
+  std::vector<double> D(mols.size());
+  std::vector<uint8_t> surface(mols.size());
+  for (size_t i = 0; i < mols.size(); ++i) {
+    D[i] = mols[i]->DValue;
+    surface[i] = (mols[i]->type == MolType::SURF);
+  }
+  std::vector<int> rejected;
+  ReactionCheck check = checkReactions(
+    reactTreeModel_->compileNetwork(moleculeModel_, nullptr, &rejected), D,
+    surface, params);
+
+  bool ok = false;
+  double probThreshold = warnModel_->value("HIGH_PROBABILITY_THRESHOLD")
+    .toDouble(&ok);
+  if (!ok) {
+    probThreshold = 1.0;
+  }
+  double lifeThreshold = warnModel_->value("LIFETIME_THRESHOLD")
+    .toDouble(&ok);
+  if (!ok) {
+    lifeThreshold = 50;
+  }
+  auto issues = findReactionIssues(check, probThreshold, lifeThreshold);
+  if (issues.empty() && rejected.empty()) {
+    if (!exporting) {
+      QMessageBox::information(this, tr("Reaction Probabilities"),
+        tr("All reaction probabilities and lifetimes are within the "
+        "warning thresholds."));
+    }
+    return true;
+  }
+
+  // reactionName returns the name of the reaction in row or an empty string
+  // if there is no such row
+  auto reactionName = [this](int row) {
+    const ReactItem* item = reactTreeModel_->reaction(row);
+    return (item != nullptr) ? item->name().simplified() : QString();
+  };
+  QString details;
+  for (const auto& issue : issues) {
+    details += QString("%1: %2").arg(issue.reaction + 1)
+      .arg(reactionName(issue.reaction));
+    if (issue.highProbability) {
+      details += tr(", probability %1").arg(issue.probability, 0, 'g', 3);
+    }
+    if (issue.shortLifetime) {
+      details += tr(", lifetime %1 time steps").arg(issue.lifetime, 0, 'g',
+        3);
+    }
+    details += "\n";
+  }
+  for (auto r : rejected) {
+    details += tr("%1: %2, more than %3 reactants, not checked\n").arg(r + 1)
+      .arg(reactionName(r)).arg(ReactionNetwork::maxReactants);
+  }
+  QString text;
+  if (!issues.empty()) {
+    text = tr("%1 reactions exceed the HIGH_PROBABILITY_THRESHOLD "
+      "(%2) or LIFETIME_THRESHOLD (%3 time steps) at TIME_STEP = %4 s. "
+      "Consider a smaller TIME_STEP.").arg(issues.size()).arg(probThreshold)
+      .arg(lifeThreshold).arg(dt);
+  }
+  if (!rejected.empty()) {
+    if (!text.isEmpty()) {
+      text += " ";
+    }
+    text += tr("%1 reactions have more than %2 reactants and could not be "
+      "checked.").arg(rejected.size()).arg(ReactionNetwork::maxReactants);
+  }
+  if (!exporting) {
+    QMessageBox box(QMessageBox::Warning, tr("Reaction Probabilities"), text,
+      QMessageBox::Close, this);
+    box.setDetailedText(details);
+    box.exec();
+    return true;
+  }
+  QMessageBox box(QMessageBox::Warning, tr("Reaction Probabilities"), text,
+    QMessageBox::Save | QMessageBox::Cancel, this);
+  box.setButtonText(QMessageBox::Save, tr("Export Anyway"));
+  box.setDetailedText(details);
+  return box.exec() == QMessageBox::Save;
+}
+
+
+// showMemoryUsage opens a dialog with the estimated memory usage of the
+// molecule and reaction models
+void MainWindow::showMemoryUsage_() {
+  QList<const QAbstractProxyModel*> proxies;
+  proxies << molTab->proxyModel();
+  DiagnosticsDialog dialog(moleculeModel_, reactTreeModel_, proxies, this);
+  dialog.exec();
+}
+
+
+// showOdePreview opens the non-modal ODE preview of the reaction network
+void MainWindow::showOdePreview_() {
+  if (odePreview_ == nullptr) {
+    odePreview_ = new OdePreviewDialog(moleculeModel_, reactTreeModel_, this);
+  }
+  odePreview_->show();
+  odePreview_->raise();
+  odePreview_->activateWindow();
+}
+
+
+// showSsaPreview opens the non-modal stochastic preview of the reaction
+// network
+void MainWindow::showSsaPreview_() {
+  if (ssaPreview_ == nullptr) {
+    ssaPreview_ = new SsaPreviewDialog(moleculeModel_, reactTreeModel_, this);
+  }
+  ssaPreview_->show();
+  ssaPreview_->raise();
+  ssaPreview_->activateWindow();
+}
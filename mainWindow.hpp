@@ -8,14 +8,22 @@
 #define MAIN_WINDOW_HPP
 
 #include <QMainWindow>
+#include <QSet>
 
 #include "molModel.hpp"
 #include "noteWarnModel.hpp"
 #include "paramModel.hpp"
 #include "reactionModel.hpp"
+#include "symbolModel.hpp"
 
 #include "ui_mainWindow.h"
 
+class ExpansionDialog;
+class OdePreviewDialog;
+class RunDialog;
+class SsaPreviewDialog;
+class SweepDialog;
+
 
 class MainWindow : public QMainWindow, Ui::MainWindow {
 
@@ -25,18 +33,55 @@ public:
 
   MainWindow(QWidget* parent = 0, Qt::WindowFlags flags = 0);
 
+  bool eventFilter(QObject* watched, QEvent* event);
+
+
+signals:
+
+  void firstPaint();
+
+
 private:
 
+  bool checkReactions_(bool exporting);
+
   // data models
+  SymbolModel* symbolModel_;
   MolModel* moleculeModel_;
   ParamModel* paramModel_;
   NotificationsModel* noteModel_;
   WarningsModel* warnModel_;
   ReactTreeModel* reactTreeModel_;
 
+  // tool dialogs are created on first use
+  OdePreviewDialog* odePreview_ = nullptr;
+  SsaPreviewDialog* ssaPreview_ = nullptr;
+  SweepDialog* sweepDialog_ = nullptr;
+  ExpansionDialog* expansionDialog_ = nullptr;
+  RunDialog* runDialog_ = nullptr;
+
+  // most recently exported MDL file, proposed for MCell runs
+  QString lastMDLFile_;
+
+  // tabs whose widgets have been created
+  QSet<QWidget*> initializedTabs_;
+
 private slots:
 
+  void initTab_(int index);
   void exportMDL_();
+  void importMolecules_();
+  void importReactions_();
+  void importSBML_();
+  void exportStoichiometry_();
+  void showSweep_();
+  void showRuns_();
+  void showExpansion_();
+  void findDuplicateReactions_();
+  void checkReactionProbabilities_();
+  void showMemoryUsage_();
+  void showOdePreview_();
+  void showSsaPreview_();
 };
 
 #endif
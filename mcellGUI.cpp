@@ -5,14 +5,61 @@
 // mcellGUI is a simulation GUI for MCell (www.mcell.org)
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
 
 #include "mainWindow.hpp"
+#include "trace.hpp"
 
 int main(int argc, char *argv[])
 {
+  QElapsedTimer startupTimer;
+  startupTimer.start();
+  int64_t startupStart = Tracer::now();
   QApplication app(argc, argv);
+
+  // --trace <file> records trace points and writes them as a Chrome trace
+  // JSON file on exit
+  QCommandLineParser parser;
+  parser.addHelpOption();
+  QCommandLineOption traceOption("trace",
+    QApplication::translate("main", "Write a Chrome trace JSON to <file>."),
+    QApplication::translate("main", "file"));
+  parser.addOption(traceOption);
+  QCommandLineOption startupOption("startup-time",
+    QApplication::translate("main",
+      "Print the time from launch to the first paint of the main window."));
+  parser.addOption(startupOption);
+  parser.process(app);
+  QString traceFile = parser.value(traceOption);
+  if (!traceFile.isEmpty()) {
+    Tracer::setEnabled(true);
+  }
+
   MainWindow *mainWindow = new MainWindow;
 
+  // time to first paint is reported on request and recorded in the trace
+  bool printStartup = parser.isSet(startupOption);
+  QObject::connect(mainWindow, &MainWindow::firstPaint,
+    [&startupTimer, startupStart, printStartup]() {
+    if (Tracer::enabled()) {
+      Tracer::record("startup", "ui", startupStart, Tracer::now());
+    }
+    if (printStartup) {
+      // written to stdout directly since qDebug output may be filtered or
+      // redirected by the message handler
+      QTextStream out(stdout);
+      out << QString("time to first paint: %1 ms\n")
+        .arg(startupTimer.nsecsElapsed() / 1e6, 0, 'f', 1);
+      out.flush();
+    }
+  });
+
   mainWindow->show();
-  return app.exec();
+  int status = app.exec();
+  if (!traceFile.isEmpty()) {
+    Tracer::writeChromeTrace(traceFile.toStdString());
+  }
+  return status;
 }
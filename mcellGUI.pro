@@ -3,17 +3,36 @@
 ######################################################################
 
 CONFIG += c++11 -Wall -Wextra -pedantic
-QT += core gui widgets
+QT += core gui widgets concurrent
 TEMPLATE = app
 TARGET = mcellGUI
 INCLUDEPATH += .
 
+# add MCELLGUI_NO_TRACE to compile out all trace points
+#DEFINES += MCELLGUI_NO_TRACE
+
 # Input
 FORMS += ui/mainWindow.ui ui/molWidget.ui ui/paramWidget.ui \
-         ui/noteWarnWidget.ui ui/reactionWidget.ui
+         ui/noteWarnWidget.ui ui/reactionWidget.ui \
+         ui/symbolWidget.ui
 HEADERS += io.hpp mainWindow.hpp molModel.hpp molWidget.hpp paramWidget.hpp \
-           paramModel.hpp noteWarnWidget.hpp noteWarnModel.hpp \
-           reactionWidget.hpp reactionModel.hpp
+           keywordModel.hpp paramModel.hpp noteWarnWidget.hpp \
+           noteWarnModel.hpp reactionWidget.hpp reactionModel.hpp \
+           memoryReport.hpp diagnosticsDialog.hpp plotWidget.hpp \
+           odePreviewDialog.hpp speciesTable.hpp ssaPreviewDialog.hpp \
+           sweep.hpp sweepDialog.hpp symbolModel.hpp symbolWidget.hpp \
+           molSortProxy.hpp reactionExpansion.hpp expansionDialog.hpp \
+           tableImport.hpp sbmlImport.hpp \
+           runManager.hpp runDialog.hpp
 SOURCES += io.cpp mainWindow.cpp mcellGUI.cpp molModel.cpp molWidget.cpp \
-           paramWidget.cpp paramModel.cpp noteWarnWidget.cpp \
-           noteWarnModel.cpp reactionWidget.cpp reactionModel.cpp
+           paramWidget.cpp keywordModel.cpp paramModel.cpp \
+           noteWarnWidget.cpp noteWarnModel.cpp reactionWidget.cpp \
+           reactionModel.cpp memoryReport.cpp diagnosticsDialog.cpp \
+           plotWidget.cpp odePreviewDialog.cpp speciesTable.cpp \
+           ssaPreviewDialog.cpp sweep.cpp sweepDialog.cpp symbolModel.cpp \
+           symbolWidget.cpp molSortProxy.cpp reactionExpansion.cpp \
+           expansionDialog.cpp tableImport.cpp \
+           sbmlImport.cpp runManager.cpp runDialog.cpp
+
+# Qt independent core
+include(core/core.pri)
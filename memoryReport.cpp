@@ -0,0 +1,99 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <QAbstractProxyModel>
+#include <QStringList>
+
+#include "memoryReport.hpp"
+#include "molModel.hpp"
+#include "reactionModel.hpp"
+
+
+// total returns the sum of all accounted components
+size_t MemoryReport::total() const {
+  return molList + molStrings + molUseTracker + reactTree + reactStrings +
+    reactUsageIndex + proxyModels;
+}
+
+
+// toText formats the report as a human readable table with the cost per
+// molecule for molecule related components and per reaction for reaction
+// related ones
+QString MemoryReport::toText() const {
+  auto line = [](const QString& label, size_t bytes, int count,
+    const QString& unit) {
+    QString perItem = (count > 0) ?
+      QString("%1 bytes/%2").arg(double(bytes) / count, 0, 'f', 1).arg(unit) :
+      QString("-");
+    return QString("%1 %2 bytes  %3").arg(label, -24).arg(bytes, 12)
+      .arg(perItem);
+  };
+
+  QStringList lines;
+  lines << QString("molecules: %1   reactions: %2").arg(numMols)
+    .arg(numReactions);
+  lines << line("molecule list", molList, numMols, "molecule");
+  lines << line("molecule strings", molStrings, numMols, "molecule");
+  lines << line("molecule use tracker", molUseTracker, numMols, "molecule");
+  lines << line("molecule proxy models", proxyModels, numMols, "molecule");
+  lines << line("reaction tree", reactTree, numReactions, "reaction");
+  lines << line("reaction strings", reactStrings, numReactions, "reaction");
+  lines << line("reaction usage index", reactUsageIndex, numReactions,
+    "reaction");
+  lines << QString("%1 %2 bytes").arg(QString("total"), -24).arg(total(), 12);
+  return lines.join("\n");
+}
+
+
+// stringBytes returns the estimated heap memory owned by a QString, i.e.
+// its allocated capacity plus the shared data header
+size_t stringBytes(const QString& s) {
+  if (s.capacity() == 0) {
+    return 0;
+  }
+  return (s.capacity() + 1) * sizeof(QChar) + sizeof(QArrayData) +
+    heapOverhead;
+}
+
+
+// stringBytes returns the estimated heap memory owned by a std::string.
+// Short strings are stored inside the string object and own no heap memory.
+size_t stringBytes(const std::string& s) {
+  if (s.capacity() < sizeof(std::string)) {
+    return 0;
+  }
+  return s.capacity() + 1 + heapOverhead;
+}
+
+
+// proxyModelBytes returns the estimated memory of the source to proxy row
+// and column mappings a proxy model keeps for the top level of its source
+size_t proxyModelBytes(const QAbstractProxyModel* proxy) {
+  if (proxy == nullptr || proxy->sourceModel() == nullptr) {
+    return 0;
+  }
+  size_t rows = proxy->sourceModel()->rowCount();
+  size_t cols = proxy->sourceModel()->columnCount();
+  return 2 * (rows + cols) * sizeof(int) + 4 * heapOverhead;
+}
+
+
+// collectMemoryReport assembles a MemoryReport for the given models
+MemoryReport collectMemoryReport(const MolModel* molModel,
+  const ReactTreeModel* reactModel,
+  const QList<const QAbstractProxyModel*>& proxies) {
+  MemoryReport report;
+  if (molModel != nullptr) {
+    molModel->memoryUsage(report);
+  }
+  if (reactModel != nullptr) {
+    reactModel->memoryUsage(report);
+  }
+  for (const auto p : proxies) {
+    report.proxyModels += proxyModelBytes(p);
+  }
+  return report;
+}
@@ -0,0 +1,59 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef MEMORY_REPORT_HPP
+#define MEMORY_REPORT_HPP
+
+#include <cstddef>
+#include <string>
+
+#include <QList>
+#include <QString>
+
+class MolModel;
+class QAbstractProxyModel;
+class ReactTreeModel;
+
+// estimated bookkeeping overhead per heap allocation and per node of a
+// std::map (three pointers plus color)
+const size_t heapOverhead = 16;
+const size_t mapNodeOverhead = 32 + heapOverhead;
+
+
+// MemoryReport collects the estimated memory usage in bytes of the main
+// model components. The estimates are based on container capacities and
+// string sizes and ignore implicit sharing of QStrings.
+struct MemoryReport {
+  size_t molList = 0;
+  size_t molStrings = 0;
+  size_t molUseTracker = 0;
+  size_t reactTree = 0;
+  size_t reactStrings = 0;
+  size_t reactUsageIndex = 0;
+  size_t proxyModels = 0;
+
+  int numMols = 0;
+  int numReactions = 0;
+
+  size_t total() const;
+  QString toText() const;
+};
+
+
+// stringBytes returns the estimated heap memory owned by a QString
+size_t stringBytes(const QString& s);
+size_t stringBytes(const std::string& s);
+
+// proxyModelBytes returns the estimated memory of the row and column
+// mappings of a proxy model
+size_t proxyModelBytes(const QAbstractProxyModel* proxy);
+
+// collectMemoryReport assembles a MemoryReport for the given models
+MemoryReport collectMemoryReport(const MolModel* molModel,
+  const ReactTreeModel* reactModel,
+  const QList<const QAbstractProxyModel*>& proxies);
+
+#endif
@@ -8,18 +8,34 @@
 
 #include <algorithm>
 #include <cassert>
+#include <limits>
+#include <unordered_set>
 #include <utility>
 
-#include "molModel.hpp"
+#include <QColor>
+#include <QRegularExpression>
 
-// constructor
-MolModel::MolModel(QObject* parent) : QAbstractTableModel(parent),
-  molCount_(0)  {}
+#include "expression.hpp"
+#include "memoryReport.hpp"
+#include "molModel.hpp"
+#include "symbolModel.hpp"
+#include "trace.hpp"
+
+// constructor. Without a shared SymbolModel the model uses a private one so
+// diffusion constants can still be given as expressions.
+MolModel::MolModel(QObject* parent, SymbolModel* symbols) :
+  QAbstractTableModel(parent), symbols_(symbols)  {
+  if (symbols_ == nullptr) {
+    symbols_ = new SymbolModel(this);
+  }
+  connect(symbols_, SIGNAL(valuesChanged(const QList<int>&)), this,
+    SLOT(updateFields_(const QList<int>&)));
+}
 
 
 // rowCount returns the number of rows in the model
 int MolModel::rowCount(const QModelIndex& parent) const {
-  return parent.isValid() ? 0 : mols_.size();
+  return parent.isValid() ? 0 : store_.size();
 }
 
 
@@ -46,26 +62,27 @@ QVariant MolModel::headerData(int section, Qt::Orientation orientation, int role
 
 // data returns the data contained at index
 QVariant MolModel::data(const QModelIndex& index, int role) const {
+  TRACE_SCOPE("MolModel::data", "model");
   if (!index.isValid()) {
     return QVariant();
   }
   int row = index.row();
   int col = index.column();
   int numCols = headerLabels_.size();
-  int numRows = mols_.size();
+  int numRows = store_.size();
   if (row < 0 || row >= numRows || col < 0 || col >= numCols) {
     return QVariant();
   }
 
-  const Molecule* m = mols_[row].get();
+  const Molecule* m = store_.at(row);
   if (role == Qt::DisplayRole || role == Qt::EditRole) {
     switch (index.column()) {
       case Col::ID:
         return m->id;
       case Col::Name:
-        return m->name;
+        return QString::fromStdString(m->name.str());
       case Col::D:
-        return m->D;
+        return QString::fromStdString(m->D);
       case Col::Type:
         if (m->type == MolType::VOL) {
           return QString("3D");
@@ -75,42 +92,65 @@ QVariant MolModel::data(const QModelIndex& index, int role) const {
       default:
         Q_ASSERT(false);
     }
+  } else if (role == MolRole::Sort) {
+    switch (index.column()) {
+      case Col::ID:
+        return m->id;
+      case Col::Name:
+        return QString::fromStdString(m->name.str());
+      case Col::D:
+        return m->DValue;
+      case Col::Type:
+        return static_cast<int>(m->type);
+    }
+  } else if (index.column() == Col::D) {
+    bool valid = symbols_->isValid(m->dField);
+    if (role == Qt::ToolTipRole) {
+      return valid ? QString("= %1").arg(symbols_->value(m->dField))
+        : symbols_->error(m->dField);
+    } else if (role == Qt::ForegroundRole && !valid) {
+      return QColor(Qt::red);
+    }
   }
   return QVariant();
 }
 
 // setData enables editing of model properties via model views
 bool MolModel::setData(const QModelIndex& index, const QVariant& value, int role) {
+  TRACE_SCOPE("MolModel::setData", "model");
   if (!index.isValid() || role != Qt::EditRole) {
     return false;
   }
   int row = index.row();
   int col = index.column();
   int numCols = headerLabels_.size();
-  int numRows = mols_.size();
+  int numRows = store_.size();
   if (row < 0 || row >= numRows || col < 0 || col >= numCols) {
     return false;
   }
 
-  Molecule* m = mols_[row].get();
-  QString newName, D, type;
+  Molecule* m = store_.at(row);
+  bool renamed = false;
+  QString newName, D, type, error;
   switch (col) {
     case Col::ID:
       m->id = value.toLongLong();
       break;
     case Col::Name:
       newName = value.toString();
-      if (newName.isEmpty() || haveMol(newName)) {
+      if (!store_.rename(m, newName.toStdString())) {
         return false;
       }
-      m->name = newName;
+      renamed = true;
       break;
     case Col::D:
       D = value.toString();
-      if (D.isEmpty()) {
+      if (D.isEmpty() || !symbols_->setField(m->dField, D, error)) {
         return false;
       }
-      m->D = D;
+      m->D = D.toStdString();
+      updateDValue_(m);
+      updateStep_(m);
       break;
     case Col::Type:
       type = value.toString();
@@ -121,8 +161,16 @@ bool MolModel::setData(const QModelIndex& index, const QVariant& value, int role
       } else {
         return false;
       }
+      updateStep_(m);
   }
+  snapshot_.invalidate(row);
   emit dataChanged(index, index);
+  if (renamed) {
+    emit molRenamed(m->id);
+  }
+  if (col == Col::D || col == Col::Type) {
+    emit diffusionChanged();
+  }
   return true;
 }
 
@@ -142,20 +190,23 @@ Qt::ItemFlags MolModel::flags(const QModelIndex& index) const {
 // NOTE1: We also need to check that the model to be deleted is not curently
 // used by any view. If it is, we don't delete and return false instead.
 bool MolModel::delMol(qlonglong id) {
-  auto it = std::find_if(mols_.begin(), mols_.end(),
-    [&id](std::unique_ptr<Molecule> const& p) { return p->id == id; });
-  assert(it != mols_.end());
+  TRACE_SCOPE("MolModel::delMol", "model");
+  int row = store_.rowOf(id);
+  assert(row >= 0);
 
   // check that no part of the GUI references this molecule before deleting
-  long molID = (*it)->id;
-  if (molUseTracker_.find(molID) != molUseTracker_.end() &&
-      molUseTracker_[molID] != 0) {
+  auto use = molUseTracker_.find(id);
+  if (use != molUseTracker_.end() && use->second != 0) {
     return false;
   }
 
+  symbols_->removeField(store_.at(row)->dField);
+  stepAnalysis_.removeMolecule(id);
+  snapshot_.invalidateFrom(row);
   beginResetModel();
-  mols_.erase(it);
+  store_.remove(row);
   endResetModel();
+  emit diffusionChanged();
   return true;
 }
 
@@ -163,80 +214,322 @@ bool MolModel::delMol(qlonglong id) {
 // haveMol returns true if a molecule with the provided name exists and false
 // otherwise
 bool MolModel::haveMol(const QString& name) const {
-  auto it = std::find_if(mols_.begin(), mols_.end(),
-    [&name](std::unique_ptr<Molecule> const& p) { return p->name == name; });
-  return it != mols_.end();
+  return getMolecule(name) != nullptr;
 }
 
 
 // numMol returns the number of molecules available in the model
 int MolModel::numMols() const {
-  return mols_.size();
+  return store_.size();
 }
 
 
 // addMol adds a new molecule of the given data to the model
 // NOTE: addMol assumes that the molecule of name molName does not yet exist
 void MolModel::addMol(const QString& name, const QString& D, const MolType& type) {
+  TRACE_SCOPE("MolModel::addMol", "model");
   // create new Molecule
-  auto m = std::unique_ptr<Molecule>(new Molecule());
-  m->name = name;
-  m->D = D;
+  auto m = store_.create(name.toStdString());
+  m->D = D.toStdString();
+  m->dField = symbols_->addField(D);
+  updateDValue_(m.get());
   m->type = type;
-  m->id = molCount_++;
+  updateStep_(m.get());
 
+  snapshot_.invalidateFrom(store_.size());
   beginResetModel();
-  mols_.push_back(std::move(m));
+  store_.append(std::move(m));
   endResetModel();
+  emit diffusionChanged();
 }
 
 
-// getMol returns a read only reference to the underlying molecule map.
-// NOTE: This could probably be encapsulated a bit better without exposing
-// the internals of how molecules are stored within the model. However,
-// returning a const MolMap& seems more efficient for the time being.
-const MolList& MolModel::getMols() const {
-  return mols_;
+// addMols is the bulk insertion path for imported molecules. All molecules
+// are appended with a single row insertion. Molecules whose name is empty or
+// already taken are skipped. This function returns the number of added
+// molecules.
+int MolModel::addMols(const std::vector<MolSpec>& mols) {
+  TRACE_SCOPE("MolModel::addMols", "model");
+  MolList added;
+  added.reserve(mols.size());
+  for (const auto& spec : mols) {
+    if (spec.name.isEmpty() || haveMol(spec.name)) {
+      continue;
+    }
+    auto m = store_.create(spec.name.toStdString());
+    m->D = spec.D.toStdString();
+    m->dField = symbols_->addField(spec.D);
+    updateDValue_(m.get());
+    m->type = spec.type;
+    updateStep_(m.get());
+    added.push_back(std::move(m));
+  }
+  if (added.empty()) {
+    return 0;
+  }
+
+  int first = store_.size();
+  int numAdded = added.size();
+  snapshot_.invalidateFrom(first);
+  beginInsertRows(QModelIndex(), first, first + numAdded - 1);
+  store_.append(added);
+  endInsertRows();
+  emit diffusionChanged();
+  return numAdded;
 }
 
-// getMolecule returns a pointer to the molecule of given name
-const Molecule* MolModel::getMolecule(QString name) const {
-  auto it = std::find_if(mols_.begin(), mols_.end(),
-    [&name](std::unique_ptr<Molecule> const& p) { return p->name == name; });
-  if (it == mols_.end()) {
-    return nullptr;
+
+// editMols applies edit to the molecules in the given rows in one
+// transaction. Views are notified by a single dataChanged signal spanning
+// all edited rows. Scaling a numeric D stores the product, otherwise the
+// expression is wrapped. This function returns the number of edited rows.
+int MolModel::editMols(const std::vector<int>& rows, const MolEdit& edit) {
+  TRACE_SCOPE("MolModel::editMols", "model");
+  bool numericFactor = false;
+  double factor = edit.value.toDouble(&numericFactor);
+  QString factorText = numericFactor ? edit.value : "(" + edit.value + ")";
+  int numRows = store_.size();
+  int minRow = numRows;
+  int maxRow = -1;
+  int numEdited = 0;
+  QString D, error;
+  for (auto row : rows) {
+    if (row < 0 || row >= numRows) {
+      continue;
+    }
+    Molecule* m = store_.at(row);
+    if (edit.kind == MolEditKind::SetType) {
+      m->type = edit.type;
+    } else {
+      D = edit.value;
+      if (edit.kind == MolEditKind::ScaleD) {
+        QString oldText = QString::fromStdString(m->D);
+        bool numericD = false;
+        double oldD = oldText.toDouble(&numericD);
+        D = (numericD && numericFactor) ?
+          QString::number(oldD * factor, 'g', 12) :
+          "(" + oldText + ")*" + factorText;
+      }
+      if (!symbols_->setField(m->dField, D, error)) {
+        continue;
+      }
+      m->D = D.toStdString();
+      updateDValue_(m);
+    }
+    updateStep_(m);
+    snapshot_.invalidate(row);
+    minRow = std::min(minRow, row);
+    maxRow = std::max(maxRow, row);
+    ++numEdited;
+  }
+  if (numEdited == 0) {
+    return 0;
+  }
+  int col = (edit.kind == MolEditKind::SetType) ? Col::Type : Col::D;
+  emit dataChanged(index(minRow, col), index(maxRow, col));
+  emit diffusionChanged();
+  return numEdited;
+}
+
+
+// parseMolEdit parses a bulk edit of the form "D = expr", "D * expr",
+// "D / expr" or "type = 2D" (3D, SURF and VOL are accepted as well). The
+// multiplication may also be written as "D × expr" or "D *= expr". This
+// function returns false and describes the problem in error otherwise.
+bool parseMolEdit(const QString& text, MolEdit& edit, QString& error) {
+  static const QRegularExpression editRegex(
+    QString("^\\s*(D|type)\\s*(=|\\*=?|/=?|%1)\\s*(\\S.*)$")
+    .arg(QChar(0x00d7)), QRegularExpression::CaseInsensitiveOption);
+  QRegularExpressionMatch match = editRegex.match(text);
+  if (!match.hasMatch()) {
+    error = QObject::tr("expected D = value, D * factor, D / divisor or "
+      "type = 2D/3D");
+    return false;
+  }
+  QString target = match.captured(1).toUpper();
+  QString op = match.captured(2);
+  QString value = match.captured(3).trimmed();
+  if (target == "TYPE") {
+    QString type = value.toUpper();
+    if (op != "=" || !(type == "2D" || type == "3D" || type == "SURF" ||
+      type == "VOL")) {
+      error = QObject::tr("expected type = 2D or type = 3D");
+      return false;
+    }
+    edit.kind = MolEditKind::SetType;
+    edit.type = (type == "2D" || type == "SURF") ? MolType::SURF :
+      MolType::VOL;
+    return true;
+  }
+
+  Expression expr;
+  std::string err;
+  if (!expr.compile(value.toStdString(), [](const std::string&) { return 0; },
+    err)) {
+    error = QString::fromStdString(err);
+    return false;
+  }
+  edit.kind = (op == "=") ? MolEditKind::SetD : MolEditKind::ScaleD;
+  edit.value = value;
+  if (op.startsWith('/')) {
+    bool ok = false;
+    double divisor = value.toDouble(&ok);
+    edit.value = (ok && divisor != 0.0) ?
+      QString::number(1.0 / divisor, 'g', 12) : "1/(" + value + ")";
   }
-  return it->get();
+  return true;
+}
+
+
+// getMols returns the molecules in row order
+const MolList& MolModel::getMols() const {
+  return store_.mols();
+}
+
+
+// store returns the core storage of the molecules
+const MolStore& MolModel::store() const {
+  return store_;
+}
+
+
+// getMolecule returns a pointer to the molecule of given name or nullptr if
+// there is none
+const Molecule* MolModel::getMolecule(const QString& name) const {
+  return store_.find(name.toStdString());
+}
+
+
+// resolve returns the molecule referenced by handle in O(1) or nullptr if
+// the handle is null or its molecule has been deleted
+const Molecule* MolModel::resolve(MolHandle handle) const {
+  return store_.resolve(handle);
 }
 
 
 // getMolNames returns the list of current molecule names
 QStringList MolModel::getMolNames() const {
   QStringList names;
-  for (auto &i : mols_) {
-    names << i->name;
+  for (auto &i : store_.mols()) {
+    names << QString::fromStdString(i->name.str());
   }
   return names;
 }
 
 
+// symbols returns the symbol table used by the diffusion constant
+// expressions
+SymbolModel* MolModel::symbols() const {
+  return symbols_;
+}
+
+
+// updateDValue_ caches the numeric value of the D expression of m
+void MolModel::updateDValue_(Molecule* m) {
+  m->DValue = symbols_->isValid(m->dField) ? symbols_->value(m->dField)
+    : std::numeric_limits<double>::quiet_NaN();
+}
+
+
+// stepAnalysis returns the diffusion step analysis of the current molecules
+const StepAnalysis& MolModel::stepAnalysis() const {
+  return stepAnalysis_;
+}
+
+
+// snapshot returns an immutable copy of the current molecules which can be
+// read from any thread. Chunks of unchanged molecules are shared with the
+// previous snapshot.
+MolSnapshot MolModel::snapshot() const {
+  TRACE_SCOPE("MolModel::snapshot", "model");
+  return snapshot_.publish(store_.size(), [this](size_t i) {
+    const Molecule* m = store_.at(i);
+    return MolRecord{m->id, m->name.str(), m->D, m->DValue,
+      m->type == MolType::SURF};
+  });
+}
+
+
+// updateStep_ passes the diffusion constant and type of m on to the step
+// analysis
+void MolModel::updateStep_(const Molecule* m) {
+  stepAnalysis_.setMolecule(m->id, m->DValue, m->type == MolType::SURF);
+}
+
+
+// updateFields_ refreshes the D column of molecules whose diffusion constant
+// changed due to a symbol edit
+void MolModel::updateFields_(const QList<int>& fields) {
+  std::unordered_set<int> changed(fields.begin(), fields.end());
+  int first = -1;
+  int last = -1;
+  for (int row = 0; row < store_.size(); ++row) {
+    Molecule* m = store_.at(row);
+    if (changed.count(m->dField) != 0) {
+      updateDValue_(m);
+      updateStep_(m);
+      snapshot_.invalidate(row);
+      first = (first < 0) ? row : first;
+      last = row;
+    }
+  }
+  if (first >= 0) {
+    emit dataChanged(index(first, Col::D), index(last, Col::D));
+    emit diffusionChanged();
+  }
+}
+
+
+// memoryUsage adds the estimated memory used by the molecule list, the
+// molecule strings and the molecule use tracker to report
+void MolModel::memoryUsage(MemoryReport& report) const {
+  const MolList& mols = store_.mols();
+  report.numMols = mols.size();
+  report.molList = mols.capacity() * sizeof(MolList::value_type) +
+    mols.size() * (sizeof(Molecule) + heapOverhead) + store_.slotBytes();
+  report.molStrings = 0;
+  for (const auto& name : store_.names()) {
+    report.molStrings += stringBytes(name.first) + sizeof(name) +
+      heapOverhead + sizeof(void*);
+  }
+  for (const auto& m : mols) {
+    report.molStrings += stringBytes(m->D);
+  }
+  report.molUseTracker = molUseTracker_.size() *
+    (sizeof(decltype(molUseTracker_)::value_type) + mapNodeOverhead) +
+    molUseTracker_.bucket_count() * sizeof(void*);
+}
+
+
 // markMoleculeUsed is a slot for marking the molecule with id as used in
 // another part of the GUI (such as reactions widget, count widget, ...).
 void MolModel::markMoleculeUsed(long id) {
-  if (molUseTracker_.find(id) == molUseTracker_.end()) {
-    molUseTracker_[id] = 1;
-  } else {
-    molUseTracker_[id] += 1;
-  }
+  ++molUseTracker_[id];
 }
 
 
 // markMoleculeUnused is a slot for marking the molecule with id as unused in
 // another part of the GUI (such as reactions widget, count widget, ...).
 void MolModel::markMoleculeUnused(long id) {
-  assert(molUseTracker_.find(id) != molUseTracker_.end());
-  assert(molUseTracker_[id] != 0);
-  molUseTracker_[id] -= 1;
+  auto it = molUseTracker_.find(id);
+  assert(it != molUseTracker_.end() && it->second != 0);
+  if (--it->second == 0) {
+    molUseTracker_.erase(it);
+  }
 }
 
 
+// updateMoleculeUse is a slot for applying a batch of reference count
+// changes at once, e.g. after a bulk insertion or deletion of reactions.
+// Each molecule is looked up only once per batch.
+void MolModel::updateMoleculeUse(const MolUseDeltas& deltas) {
+  TRACE_SCOPE("MolModel::updateMoleculeUse", "model");
+  for (const auto& d : deltas) {
+    int& count = molUseTracker_[d.id];
+    count += d.delta;
+    assert(count >= 0);
+    if (count == 0) {
+      molUseTracker_.erase(d.id);
+    }
+  }
+}
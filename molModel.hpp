@@ -7,37 +7,72 @@
 #ifndef MOL_MODEL_HPP
 #define MOL_MODEL_HPP
 
-#include <map>
-#include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <QAbstractTableModel>
+#include <QList>
+#include <QMetaType>
 #include <QString>
 
-// MolType classifies 2D (SURF) or 3D (VOL) molecules
-enum class MolType {SURF, VOL};
+#include "modelState.hpp"
+#include "molStore.hpp"
+#include "stepAnalysis.hpp"
 
-// Molecule class stores the data for a single molecule
-struct Molecule {
-  qlonglong id;
+struct MemoryReport;
+class SymbolModel;
+
+Q_DECLARE_METATYPE(MolHandle)
+
+// MolSpec describes a single molecule for bulk insertion via
+// MolModel::addMols
+struct MolSpec {
   QString name;
   QString D;
   MolType type;
 };
-using MolList = std::vector<std::unique_ptr<Molecule>>;
+
+// MolEdit describes a change applied to many molecules at once via
+// MolModel::editMols. SetD replaces D by value, ScaleD multiplies D by the
+// factor given in value and SetType sets the molecule type.
+enum class MolEditKind {SetD, ScaleD, SetType};
+struct MolEdit {
+  MolEditKind kind;
+  QString value;
+  MolType type;
+};
+
+bool parseMolEdit(const QString& text, MolEdit& edit, QString& error);
+
+// MolUseDelta is the change of the number of references to a molecule by
+// other parts of the GUI. Batches of deltas are applied via
+// MolModel::updateMoleculeUse.
+struct MolUseDelta {
+  long id;
+  int delta;
+};
+using MolUseDeltas = std::vector<MolUseDelta>;
 
 // Col names column types (one per data element in Molecule)
 namespace Col {
   enum col {ID, Name, D, Type};
 }
 
-// MolModel describes the QT MVC data model for molecules
+// MolRole names custom data roles of the MolModel. Sort returns the typed
+// value of each column (e.g. the numeric value of D) for sorting.
+namespace MolRole {
+  enum role {Sort = Qt::UserRole + 1};
+}
+
+// MolModel describes the QT MVC data model for molecules. The molecules
+// themselves are stored in a core MolStore; the model adds the symbol
+// table, step analysis and use tracking and adapts the store to views.
 class MolModel : public QAbstractTableModel {
 
   Q_OBJECT
 
 public:
-  MolModel(QObject* parent = 0);
+  MolModel(QObject* parent = 0, SymbolModel* symbols = nullptr);
 
   int rowCount(const QModelIndex& parent = QModelIndex()) const ;
   int columnCount(const QModelIndex& parent = QModelIndex()) const;
@@ -50,12 +85,20 @@ public:
   bool haveMol(const QString& molName) const;
   int numMols() const;
   const MolList& getMols() const;
-  const Molecule* getMolecule(QString name) const;
+  const MolStore& store() const;
+  const Molecule* getMolecule(const QString& name) const;
+  const Molecule* resolve(MolHandle handle) const;
   QStringList getMolNames() const;
+  SymbolModel* symbols() const;
+  const StepAnalysis& stepAnalysis() const;
+  MolSnapshot snapshot() const;
+  void memoryUsage(MemoryReport& report) const;
 
   // write methods
   bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole);
   void addMol(const QString& name, const QString& D, const MolType& type);
+  int addMols(const std::vector<MolSpec>& mols);
+  int editMols(const std::vector<int>& rows, const MolEdit& edit);
   bool delMol(qlonglong id);
 
 
@@ -63,12 +106,32 @@ public slots:
 
   void markMoleculeUsed(long id);
   void markMoleculeUnused(long id);
+  void updateMoleculeUse(const MolUseDeltas& deltas);
+
+
+signals:
+
+  void molRenamed(long id);
+  void diffusionChanged();
+
+
+private slots:
+
+  void updateFields_(const QList<int>& fields);
 
 
 private:
-  long molCount_;
-  std::map<int, int> molUseTracker_;
-  MolList mols_;
+  void updateDValue_(Molecule* m);
+  void updateStep_(const Molecule* m);
+
+  SymbolModel* symbols_;
+  std::unordered_map<long, int> molUseTracker_;
+  MolStore store_;
+  StepAnalysis stepAnalysis_;
+
+  // snapshot_ publishes immutable copies of the molecules for worker
+  // threads; only chunks with changed molecules are copied
+  mutable PersistentVectorBuilder<MolRecord> snapshot_;
 
   std::vector<QString> headerLabels_ = {"id", "molecule name", "D", "type"};
 };
@@ -0,0 +1,71 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <cmath>
+
+#include "molModel.hpp"
+#include "molSortProxy.hpp"
+
+
+// constructor
+MolSortProxy::MolSortProxy(QObject* parent) : QSortFilterProxyModel(parent) {
+  setSortRole(MolRole::Sort);
+}
+
+
+// setMolModel sets the molecule model as source model
+void MolSortProxy::setMolModel(const MolModel* molModel) {
+  molModel_ = molModel;
+  setSourceModel(const_cast<MolModel*>(molModel));
+}
+
+
+// setDRange only accepts molecules whose diffusion constant lies within
+// [minD, maxD]
+void MolSortProxy::setDRange(double minD, double maxD) {
+  haveDRange_ = true;
+  minD_ = minD;
+  maxD_ = maxD;
+  invalidateFilter();
+}
+
+
+// clearDRange accepts molecules regardless of their diffusion constant
+void MolSortProxy::clearDRange() {
+  haveDRange_ = false;
+  invalidateFilter();
+}
+
+
+// lessThan compares diffusion constants numerically. Invalid diffusion
+// constants (NaN) sort after all valid ones. Other columns are compared via
+// their sort role.
+bool MolSortProxy::lessThan(const QModelIndex& left,
+  const QModelIndex& right) const {
+  if (molModel_ == nullptr || left.column() != Col::D) {
+    return QSortFilterProxyModel::lessThan(left, right);
+  }
+  const MolList& mols = molModel_->getMols();
+  double l = mols[left.row()]->DValue;
+  double r = mols[right.row()]->DValue;
+  if (std::isnan(l)) {
+    return false;
+  }
+  return std::isnan(r) || l < r;
+}
+
+
+// filterAcceptsRow applies the D range filter on top of the regular filter
+bool MolSortProxy::filterAcceptsRow(int sourceRow,
+  const QModelIndex& sourceParent) const {
+  if (haveDRange_ && molModel_ != nullptr) {
+    double D = molModel_->getMols()[sourceRow]->DValue;
+    if (!(D >= minD_ && D <= maxD_)) {
+      return false;
+    }
+  }
+  return QSortFilterProxyModel::filterAcceptsRow(sourceRow, sourceParent);
+}
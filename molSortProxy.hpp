@@ -0,0 +1,45 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef MOL_SORT_PROXY_HPP
+#define MOL_SORT_PROXY_HPP
+
+#include <QSortFilterProxyModel>
+
+class MolModel;
+
+
+// MolSortProxy sorts and filters the MolModel. Comparisons and the D range
+// filter read the cached numeric values of the molecules directly instead
+// of going through QVariant and string conversion.
+class MolSortProxy : public QSortFilterProxyModel {
+
+  Q_OBJECT
+
+public:
+
+  MolSortProxy(QObject* parent = 0);
+
+  void setMolModel(const MolModel* molModel);
+  void setDRange(double minD, double maxD);
+  void clearDRange();
+
+
+protected:
+
+  bool lessThan(const QModelIndex& left, const QModelIndex& right) const;
+  bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const;
+
+
+private:
+
+  const MolModel* molModel_ = nullptr;
+  bool haveDRange_ = false;
+  double minD_ = 0.0;
+  double maxD_ = 0.0;
+};
+
+#endif
@@ -6,46 +6,125 @@
 
 #include <QDebug>
 
+#include <algorithm>
 #include <map>
 #include <set>
+#include <vector>
 
+#include <QApplication>
+#include <QClipboard>
 #include <QComboBox>
+#include <QKeyEvent>
 #include <QLineEdit>
 #include <QMessageBox>
 #include <QShortcut>
+#include <QStringList>
 
 #include "molWidget.hpp"
+#include "tableImport.hpp"
+#include "trace.hpp"
 
 
-// constructor
+// constructor. The widgets of the tab are only created by initModel once
+// the tab is first shown.
 MolWidget::MolWidget(QWidget* parent, Qt::WindowFlags flags) :
-  QWidget(parent, flags) {
+  QWidget(parent, flags), model_(nullptr), proxyModel_(nullptr) {}
 
+
+// initModel creates the widgets of the tab and connects them to the
+// underlying molecule model
+void MolWidget::initModel(MolModel* model) {
+  TRACE_SCOPE("MolWidget::initModel", "ui");
   setupUi(this);
   molTableView->setSortingEnabled(true);
   molTableView->setItemDelegate(&delegate_);
 
   connect(addMolButton, SIGNAL(clicked()), this, SLOT(addMol()));
   connect(deleteMolButton, SIGNAL(clicked()), this, SLOT(deleteMols()));
+  connect(dFilterEntry, SIGNAL(textChanged(const QString&)), this,
+    SLOT(filterD(const QString&)));
+  connect(bulkEditButton, SIGNAL(clicked()), this, SLOT(editSelected()));
+  connect(bulkEditEntry, SIGNAL(returnPressed()), this, SLOT(editSelected()));
 
   // add shortcuts for adding and deleting
   QShortcut *addShortCut = new QShortcut(QKeySequence("Ctrl+A"), this);
   connect(addShortCut, SIGNAL(activated()), this, SLOT(addMol()));
   QShortcut *delShortCut = new QShortcut(QKeySequence("Ctrl+X"), this);
   connect(delShortCut, SIGNAL(activated()), this, SLOT(deleteMols()));
-}
 
+  // pasting is handled by the view itself so that editors keep their own
+  // clipboard handling
+  molTableView->installEventFilter(this);
 
-// initModel initializes the widget's underlying molecule model
-void MolWidget::initModel(MolModel* model) {
   model_ = model;
-  auto proxyModel = new QSortFilterProxyModel(this);
-  proxyModel->setSourceModel(model);
-  molTableView->setModel(proxyModel);
+  proxyModel_ = new MolSortProxy(this);
+  proxyModel_->setMolModel(model);
+  molTableView->setModel(proxyModel_);
   molTableView->setColumnHidden(0,true);
 }
 
 
+// proxyModel returns the sort proxy sitting between the molecule model and
+// the table view or nullptr if the tab has not been shown yet
+const QSortFilterProxyModel* MolWidget::proxyModel() const {
+  return proxyModel_;
+}
+
+
+// eventFilter pastes the clipboard contents as molecules when Paste is
+// pressed in the molecule table
+bool MolWidget::eventFilter(QObject* watched, QEvent* event) {
+  if (watched == molTableView && event->type() == QEvent::KeyPress &&
+    static_cast<QKeyEvent*>(event)->matches(QKeySequence::Paste)) {
+    pasteMols();
+    return true;
+  }
+  return QWidget::eventFilter(watched, event);
+}
+
+
+// filterD restricts the view to molecules whose diffusion constant lies
+// within the range given as min:max. Incomplete ranges show all molecules.
+void MolWidget::filterD(const QString& range) {
+  QStringList bounds = range.split(':');
+  bool okMin = false;
+  bool okMax = false;
+  if (bounds.size() == 2) {
+    double minD = bounds[0].trimmed().toDouble(&okMin);
+    double maxD = bounds[1].trimmed().toDouble(&okMax);
+    if (okMin && okMax) {
+      proxyModel_->setDRange(minD, maxD);
+      return;
+    }
+  }
+  proxyModel_->clearDRange();
+}
+
+
+// editSelected applies the edit entered in the bulk edit entry, e.g.
+// "D * 0.5" or "type = 2D", to all selected molecules at once. The rows are
+// taken from the selection ranges instead of the selected indexes to avoid
+// creating an index per selected cell.
+void MolWidget::editSelected() {
+  TRACE_SCOPE("MolWidget::editSelected", "ui");
+  MolEdit edit;
+  QString error;
+  if (!parseMolEdit(bulkEditEntry->text(), edit, error)) {
+    QMessageBox::critical(this, tr("Invalid Edit"), error, QMessageBox::Close);
+    return;
+  }
+  std::vector<int> rows;
+  for (const auto& range : molTableView->selectionModel()->selection()) {
+    for (int r = range.top(); r <= range.bottom(); ++r) {
+      rows.push_back(proxyModel_->mapToSource(proxyModel_->index(r, 0)).row());
+    }
+  }
+  std::sort(rows.begin(), rows.end());
+  rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+  model_->editMols(rows, edit);
+}
+
+
 // deleteMols deletes all currently selected molecules from the model
 // NOTE: we need to assemble the list of names first before we can
 // start deleting since the rowIDs are invalidated as soon as we touch
@@ -86,6 +165,26 @@ void MolWidget::addMol() {
   model_->addMol(molName, "0.0", MolType::VOL);
 }
 
+
+// pasteMols adds the rows of the clipboard, e.g. cells copied from a
+// spreadsheet, as molecules in one bulk insertion. Invalid rows and
+// existing molecules are skipped and reported.
+void MolWidget::pasteMols() {
+  TRACE_SCOPE("MolWidget::pasteMols", "ui");
+  QString text = QApplication::clipboard()->text();
+  if (text.isEmpty()) {
+    return;
+  }
+  QTextStream in(&text, QIODevice::ReadOnly);
+  MolImport result = importMolecules(in, model_);
+  int numAdded = model_->addMols(result.mols);
+  if (numAdded < result.numRows) {
+    showImportReport(this, tr("Paste Molecules"), tr("molecules"), numAdded,
+      result);
+  }
+}
+
+
 // MolModelDelegate constructor
 MolModelDelegate::MolModelDelegate(QWidget *parent) :
   QItemDelegate(parent) {};
@@ -94,6 +193,7 @@ MolModelDelegate::MolModelDelegate(QWidget *parent) :
 // createEditor creates the appropriate editor for each of the columns
 QWidget* MolModelDelegate::createEditor(QWidget *parent,
   const QStyleOptionViewItem &option, const QModelIndex &index) const {
+  TRACE_SCOPE("MolModelDelegate::createEditor", "delegate");
 
   Q_UNUSED(option)
 
@@ -109,7 +209,6 @@ QWidget* MolModelDelegate::createEditor(QWidget *parent,
       return edit;
     case Col::D:
       edit = new QLineEdit(parent);
-      edit->setValidator(new QDoubleValidator);
       return edit;
     case Col::Type:
       comb = new QComboBox(parent);
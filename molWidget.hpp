@@ -12,6 +12,7 @@
 #include <QWidget>
 
 #include "molModel.hpp"
+#include "molSortProxy.hpp"
 #include "ui_molWidget.h"
 
 
@@ -44,16 +45,23 @@ public:
   MolWidget(QWidget* parent = 0, Qt::WindowFlags flags = 0);
 
   void initModel(MolModel* model);
+  const QSortFilterProxyModel* proxyModel() const;
+
+  bool eventFilter(QObject* watched, QEvent* event);
 
 private:
 
   int molCount_ = 0;
   MolModel* model_;
+  MolSortProxy* proxyModel_;
   MolModelDelegate delegate_;
 
 private slots:
   void addMol();
   void deleteMols();
+  void pasteMols();
+  void editSelected();
+  void filterD(const QString& range);
 };
 
 
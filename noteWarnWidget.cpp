@@ -11,69 +11,56 @@
 #include "paramWidget.hpp"
 #include "noteWarnModel.hpp"
 #include "noteWarnWidget.hpp"
+#include "trace.hpp"
 
 
-// constructor
+// constructor. The widgets of the tab are only created by initModel once
+// the tab is first shown.
 NoteWarnWidget::NoteWarnWidget(QWidget* parent, Qt::WindowFlags flags) :
-  QWidget(parent, flags) {
+  QWidget(parent, flags) {}
 
-  setupUi(this);
-}
-
-// initModel connects the widget elements to the underlying model
+// initModel creates the widgets of the tab and connects them to the
+// underlying model
 // NOTE: To make the code a bit more compact the interface is created
 // programmatically based on the NotificationsModel and WarningsModel
 void NoteWarnWidget::initModel(NotificationsModel* noteModel,
   WarningsModel* warnModel) {
+  TRACE_SCOPE("NoteWarnWidget::initModel", "ui");
+  setupUi(this);
+  addKeywords_(noteGrid, noteModel);
+  addKeywords_(warnGrid, warnModel);
+}
 
-  auto keys = noteModel->noteKeyWords;
-  auto vals = noteModel->noteValues;
-  for (int i=0; i<keys.size(); ++i) {
-    QDataWidgetMapper* mapper = new QDataWidgetMapper;
-    mapper->setModel(noteModel);
-    noteGrid->addWidget(new QLabel(keys[i]), i, 0);
-
-    if (keys[i] == "PROBABILITY_REPORT_THRESHOLD") {
-      auto l = new QLineEdit(vals[i][0], this);
-      l->setValidator(new QIntValidator);
-      noteGrid->addWidget(l, i, 1);
-      mapper->addMapping(l, 1);
-    } else {
-      auto c = new QComboBox(this);
-      c->insertItems(0,vals[i]);
-      noteGrid->addWidget(c, i, 1);
 
-      auto del = new ComboBoxModelDelegate(this);
-      mapper->setItemDelegate(del);
-      mapper->addMapping(c, 1);
-      connect(c, SIGNAL(currentIndexChanged(int)), del,
-        SLOT(onCurrentIndexChanged(int)));
-    }
-    mapper->setCurrentIndex(i);
-  }
-
-  keys = warnModel->warnKeyWords;
-  vals = warnModel->warnValues;
-  for (int i=0; i<keys.size(); ++i) {
+// addKeywords_ adds a label and an editor for every keyword of model to
+// grid. Choice keywords are edited via combo boxes, thresholds via line
+// edits validated according to the keyword kind.
+void NoteWarnWidget::addKeywords_(QGridLayout* grid, KeywordModel* model) {
+  const KeywordTable& table = model->table();
+  for (int i=0; i<table.size(); ++i) {
+    const Keyword& keyword = table.keyword(i);
     QDataWidgetMapper* mapper = new QDataWidgetMapper;
-    mapper->setModel(warnModel);
-    warnGrid->addWidget(new QLabel(keys[i]), i, 0);
+    mapper->setModel(model);
+    grid->addWidget(new QLabel(keyword.name), i, 0);
 
-    if (keys[i] == "HIGH_PROBABILITY_THRESHOLD" ||
-        keys[i] == "LIFETIME_THRESHOLD" ||
-        keys[i] == "MISSED_REACTION_THRESHOLD") {
-      auto l = new QLineEdit(vals[i][0], this);
-      if (keys[i] == "LIFETIME_THRESHOLD") {
+    if (keyword.kind != KeywordKind::Choice) {
+      auto l = new QLineEdit(this);
+      if (keyword.kind == KeywordKind::Integer) {
         l->setValidator(new QIntValidator);
       } else {
         l->setValidator(new QDoubleValidator);
       }
-      warnGrid->addWidget(l, i, 1);
+      grid->addWidget(l, i, 1);
       mapper->addMapping(l, 1);
     } else {
       auto c = new QComboBox(this);
-      c->insertItems(0,vals[i]);
-      warnGrid->addWidget(c, i, 1);
+      for (int n = 0; n < keyword.numChoices; ++n) {
+        c->addItem(keyword.choices[n]);
+      }
+      if (keyword.unsetName != nullptr) {
+        c->addItem(keyword.unsetName);
+      }
+      grid->addWidget(c, i, 1);
 
       auto del = new ComboBoxModelDelegate(this);
       mapper->setItemDelegate(del);
@@ -84,5 +71,3 @@ void NoteWarnWidget::initModel(NotificationsModel* noteModel,
     mapper->setCurrentIndex(i);
   }
 }
-
-
@@ -11,6 +11,8 @@
 
 #include "ui_noteWarnWidget.h"
 
+class KeywordModel;
+
 // NoteWarnWidget is responsible for setting notification and error
 // reporting options
 class NoteWarnWidget : public QWidget, Ui::NoteWarnWidget {
@@ -19,6 +21,9 @@ public:
   NoteWarnWidget(QWidget* parent = 0, Qt::WindowFlags flags = 0);
 
   void initModel(NotificationsModel* note, WarningsModel* warn);
+
+private:
+  void addKeywords_(QGridLayout* grid, KeywordModel* model);
 };
 
 
@@ -0,0 +1,214 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <QCheckBox>
+#include <QDoubleValidator>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QSplitter>
+#include <QTimer>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+
+#include "modelState.hpp"
+#include "molModel.hpp"
+#include "odePreviewDialog.hpp"
+#include "odeSolver.hpp"
+#include "plotWidget.hpp"
+#include "reactionModel.hpp"
+#include "speciesTable.hpp"
+
+namespace {
+
+// maximum number of species plotted if none are selected explicitly
+const int maxAutoPlot = 8;
+
+}
+
+
+// constructor
+OdePreviewDialog::OdePreviewDialog(const MolModel* molModel,
+  const ReactTreeModel* reactModel, QWidget* parent) : QDialog(parent),
+  molModel_(molModel), reactModel_(reactModel) {
+
+  setWindowTitle(tr("ODE Preview"));
+
+  speciesTable_ = new SpeciesTable(molModel_, tr("initial conc. [M]"), "1e-6",
+    this);
+
+  tEndEntry_ = new QLineEdit("1.0", this);
+  tEndEntry_->setValidator(new QDoubleValidator(0.0, 1e12, 12, this));
+  numOutputsEntry_ = new QSpinBox(this);
+  numOutputsEntry_->setRange(2, 100000);
+  numOutputsEntry_->setValue(201);
+  autoRunBox_ = new QCheckBox(tr("re-run after reaction edits"), this);
+  autoRunBox_->setChecked(true);
+
+  auto form = new QFormLayout;
+  form->addRow(tr("end time [s]"), tEndEntry_);
+  form->addRow(tr("output points"), numOutputsEntry_);
+  form->addRow(autoRunBox_);
+
+  runButton_ = new QPushButton(tr("Run"), this);
+  cancelButton_ = new QPushButton(tr("Cancel"), this);
+  cancelButton_->setEnabled(false);
+  auto buttons = new QHBoxLayout;
+  buttons->addWidget(runButton_);
+  buttons->addWidget(cancelButton_);
+
+  auto controls = new QWidget(this);
+  auto controlLayout = new QVBoxLayout(controls);
+  controlLayout->addWidget(speciesTable_);
+  controlLayout->addLayout(form);
+  controlLayout->addLayout(buttons);
+
+  plot_ = new PlotWidget(this);
+  plot_->setYLabel(tr("concentration [M]"));
+  auto splitter = new QSplitter(this);
+  splitter->addWidget(controls);
+  splitter->addWidget(plot_);
+  splitter->setStretchFactor(1, 1);
+
+  statusLabel_ = new QLabel(this);
+  auto layout = new QVBoxLayout(this);
+  layout->addWidget(splitter);
+  layout->addWidget(statusLabel_);
+  resize(900, 500);
+
+  rerunTimer_ = new QTimer(this);
+  rerunTimer_->setSingleShot(true);
+  rerunTimer_->setInterval(300);
+
+  connect(runButton_, SIGNAL(clicked()), this, SLOT(run()));
+  connect(cancelButton_, SIGNAL(clicked()), this, SLOT(cancel()));
+  connect(rerunTimer_, SIGNAL(timeout()), this, SLOT(run()));
+  connect(&watcher_, SIGNAL(finished()), this, SLOT(runFinished()));
+  connect(reactModel_, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this,
+    SLOT(scheduleRun()));
+}
+
+
+// destructor cancels and waits for a running integration
+OdePreviewDialog::~OdePreviewDialog() {
+  cancel();
+  watcher_.waitForFinished();
+}
+
+
+// scheduleRun re-runs the preview shortly after reaction edits if auto
+// re-run is enabled. Bursts of edits are collapsed into a single run.
+void OdePreviewDialog::scheduleRun() {
+  if (isVisible() && autoRunBox_->isChecked()) {
+    rerunTimer_->start();
+  }
+}
+
+
+// run takes snapshots of the current molecules and reactions and starts the
+// integration on a worker thread which also compiles the reaction network.
+// If a run is already in progress it is cancelled and the new run starts
+// once it has finished.
+void OdePreviewDialog::run() {
+  if (watcher_.isRunning()) {
+    rerunPending_ = true;
+    cancel();
+    return;
+  }
+  speciesTable_->refresh();
+
+  MolSnapshot mols = molModel_->snapshot();
+  ReactionSnapshot reactions = reactModel_->snapshot();
+  std::vector<double> x0(mols.size());
+  double xMax = 0.0;
+  for (size_t i = 0; i < mols.size(); ++i) {
+    x0[i] = speciesTable_->value(i);
+    xMax = std::max(xMax, x0[i]);
+  }
+
+  // plot the selected species or the ones with the largest initial values
+  plotSpecies_ = speciesTable_->plotSelection(x0, maxAutoPlot);
+  plotNames_.clear();
+  for (auto s : plotSpecies_) {
+    plotNames_ << QString::fromStdString(mols[s].name);
+  }
+
+  OdeOptions opts;
+  opts.tEnd = tEndEntry_->text().toDouble();
+  opts.numOutputs = numOutputsEntry_->value();
+  opts.atol = std::max(1e-6 * xMax, 1e-30);
+
+  cancelFlag_ = std::make_shared<std::atomic<bool>>(false);
+  auto cancelFlag = cancelFlag_;
+  watcher_.setFuture(QtConcurrent::run(
+    [mols, reactions, x0, opts, cancelFlag]() {
+    auto start = std::chrono::steady_clock::now();
+    OdeRunResult result;
+    std::vector<int> rejected;
+    ReactionNetwork network = compileNetwork(mols, reactions,
+      &result.numInvalid, &rejected);
+    result.numRejected = rejected.size();
+    MassActionKernel kernel(network);
+    result.ok = integrateODE(kernel, x0, opts, result.traj, cancelFlag.get(),
+      result.error);
+    result.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+    return result;
+  }));
+
+  runButton_->setEnabled(false);
+  cancelButton_->setEnabled(true);
+  statusLabel_->setText(tr("integrating %1 species and %2 reactions ...")
+    .arg(mols.size()).arg(reactions.size()));
+}
+
+
+// cancel requests the running integration to stop
+void OdePreviewDialog::cancel() {
+  if (cancelFlag_) {
+    cancelFlag_->store(true);
+  }
+}
+
+
+// runFinished plots the result of a completed integration and starts a
+// pending re-run if necessary
+void OdePreviewDialog::runFinished() {
+  runButton_->setEnabled(true);
+  cancelButton_->setEnabled(false);
+  OdeRunResult result = watcher_.result();
+  if (rerunPending_) {
+    rerunPending_ = false;
+    run();
+    return;
+  }
+  if (!result.ok) {
+    statusLabel_->setText(tr("integration failed: %1")
+      .arg(QString::fromStdString(result.error)));
+    return;
+  }
+
+  plot_->clear();
+  plot_->addTrajectory(result.traj, plotSpecies_, plotNames_);
+  QString status = tr("integration finished in %1 s")
+    .arg(result.seconds, 0, 'g', 3);
+  if (result.numInvalid > 0) {
+    status += tr(" (%1 reactions with invalid rates were ignored)")
+      .arg(result.numInvalid);
+  }
+  if (result.numRejected > 0) {
+    status += tr(" (%1 reactions with more than %2 reactants were ignored)")
+      .arg(result.numRejected).arg(ReactionNetwork::maxReactants);
+  }
+  statusLabel_->setText(status);
+}
@@ -0,0 +1,85 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef ODE_PREVIEW_DIALOG_HPP
+#define ODE_PREVIEW_DIALOG_HPP
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <QDialog>
+#include <QFutureWatcher>
+
+#include "reactionNetwork.hpp"
+
+class MolModel;
+class PlotWidget;
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QSpinBox;
+class QTimer;
+class ReactTreeModel;
+class SpeciesTable;
+
+// OdeRunResult is the outcome of a single ODE preview run
+struct OdeRunResult {
+  bool ok = false;
+  std::string error;
+  Trajectory traj;
+  double seconds = 0.0;
+  int numInvalid = 0;
+  int numRejected = 0;
+};
+
+
+// OdePreviewDialog integrates the well-mixed mass action ODEs of the current
+// reaction network on a worker thread and plots the species trajectories.
+// If requested, the preview is re-run whenever a reaction is edited.
+class OdePreviewDialog : public QDialog {
+
+  Q_OBJECT
+
+public:
+
+  OdePreviewDialog(const MolModel* molModel, const ReactTreeModel* reactModel,
+    QWidget* parent = 0);
+  ~OdePreviewDialog();
+
+
+private slots:
+
+  void run();
+  void cancel();
+  void scheduleRun();
+  void runFinished();
+
+
+private:
+
+  const MolModel* molModel_;
+  const ReactTreeModel* reactModel_;
+
+  SpeciesTable* speciesTable_;
+  QLineEdit* tEndEntry_;
+  QSpinBox* numOutputsEntry_;
+  QCheckBox* autoRunBox_;
+  QPushButton* runButton_;
+  QPushButton* cancelButton_;
+  QLabel* statusLabel_;
+  PlotWidget* plot_;
+  QTimer* rerunTimer_;
+
+  QFutureWatcher<OdeRunResult> watcher_;
+  std::shared_ptr<std::atomic<bool>> cancelFlag_;
+  bool rerunPending_ = false;
+  std::vector<int> plotSpecies_;
+  QStringList plotNames_;
+};
+
+#endif
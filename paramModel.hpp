@@ -7,24 +7,14 @@
 #ifndef PARAM_MODEL_HPP
 #define PARAM_MODEL_HPP
 
-#include <QStandardItemModel>
-#include <QStringList>
+#include "keywordModel.hpp"
 
-class ParamModel : public QStandardItemModel {
+// ParamModel exposes the main and advanced model parameters
+class ParamModel : public KeywordModel {
 
 public:
 
   ParamModel(QObject* parent = 0);
-
-  // list of main keywords
-  const QStringList keyWords = QStringList({"ITERATIONS", "TIME_STEP"});
-
-  // list of advanced keywords and their possible values
-  const QStringList advKeyWords = QStringList({"TIME_STEP_MAX", "SPACE_STEP",
-    "SURFACE_GRID_DENSITY", "INTERACTION_RADIUS", "ACCURATE_3D_REACTIONS",
-    "CENTER_MOLECULES_ON_GRID", "VACANCY_SEARCH_DISTANCE",
-    "MICROSCOPIC_REVERSIBILITY"});
-  QList<QStringList> values;
 };
 
 #endif
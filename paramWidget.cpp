@@ -9,24 +9,50 @@
 #include <QMetaProperty>
 #include <QPushButton>
 #include <QStringListModel>
-#include <QStandardItemModel>
 
+#include "molModel.hpp"
 #include "paramModel.hpp"
 #include "paramWidget.hpp"
+#include "stepAnalysis.hpp"
+#include "trace.hpp"
 
 
-// constructor
+// constructor. The widgets of the tab are only created by initModel once
+// the tab is first shown.
 ParamWidget::ParamWidget(QWidget* parent, Qt::WindowFlags flags) :
-  QWidget(parent, flags) {
+  QWidget(parent, flags) {}
 
+
+// initModel creates the widgets of the tab and connects them to the
+// underlying model. The molecule model provides the diffusion constants for
+// the step recommendations.
+void ParamWidget::initModel(ParamModel* paramModel, const MolModel* molModel) {
+  TRACE_SCOPE("ParamWidget::initModel", "ui");
   setupUi(this);
   advancedGrouper->setHidden(true);
   timeStepEntry->setValidator(new QDoubleValidator);
-}
-
-
-// initModel connects the widget elements to the underlying model
-void ParamWidget::initModel(ParamModel* paramModel) {
+  targetLengthEntry->setValidator(new QDoubleValidator);
+
+  // step recommendations are refreshed once per event loop iteration
+  // regardless of how many molecules changed
+  stepTimer_ = new QTimer(this);
+  stepTimer_->setSingleShot(true);
+  stepTimer_->setInterval(0);
+  connect(stepTimer_, SIGNAL(timeout()), this, SLOT(updateSteps()));
+
+  paramModel_ = paramModel;
+  molModel_ = molModel;
+  connect(molModel_, SIGNAL(diffusionChanged()), this,
+    SLOT(scheduleStepUpdate()));
+  connect(paramModel_,
+    SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&)), this,
+    SLOT(scheduleStepUpdate()));
+  connect(targetLengthEntry, SIGNAL(textChanged(const QString&)), this,
+    SLOT(scheduleStepUpdate()));
+  connect(applyTimeStepButton, SIGNAL(clicked()), this,
+    SLOT(applyTimeStep()));
+  connect(applySpaceStepButton, SIGNAL(clicked()), this,
+    SLOT(applySpaceStep()));
 
   QDataWidgetMapper* iterMapper = new QDataWidgetMapper;
   iterMapper->setModel(paramModel);
@@ -38,31 +64,31 @@ void ParamWidget::initModel(ParamModel* paramModel) {
   dtMapper->addMapping(timeStepEntry, 1);
   dtMapper->setCurrentIndex(1);
 
-  auto keys = paramModel->advKeyWords;
-  auto vals = paramModel->values;
-  int id = 2;
-  for (int i=0; i<keys.size(); ++i) {
-
+  const KeywordTable& table = paramModel->table();
+  int gridRow = 0;
+  for (int i=0; i<table.size(); ++i) {
+    const Keyword& keyword = table.keyword(i);
+    if (!keyword.advanced) {
+      continue;
+    }
     QDataWidgetMapper* mapper = new QDataWidgetMapper;
     mapper->setModel(paramModel);
-    paramGrid->addWidget(new QLabel(keys[i]), i, 0);
-    if (keys[i] == "SURFACE_GRID_DENSITY" ||
-        keys[i] == "TIME_STEP_MAX" ||
-        keys[i] == "SPACE_STEP" ||
-        keys[i] == "INTERACTION_RADIUS" ||
-        keys[i] == "VACANCY_SEARCH_DISTANCE") {
-      auto l = new QLineEdit(vals[i][0], this);
-      if (keys[i] == "SURFACE_GRID_DENSITY") {
+    paramGrid->addWidget(new QLabel(keyword.name), gridRow, 0);
+    if (keyword.kind != KeywordKind::Choice) {
+      auto l = new QLineEdit(this);
+      if (keyword.kind == KeywordKind::Integer) {
         l->setValidator(new QRegExpValidator(intOrEmptyRegex_));
       } else {
         l->setValidator(new QRegExpValidator(doubleOrEmptyRegex_));
       }
-      paramGrid->addWidget(l, i, 1);
+      paramGrid->addWidget(l, gridRow, 1);
       mapper->addMapping(l, 1);
     } else {
       auto c = new QComboBox(this);
-      c->insertItems(0,vals[i]);
-      paramGrid->addWidget(c, i, 1);
+      for (int n = 0; n < keyword.numChoices; ++n) {
+        c->addItem(keyword.choices[n]);
+      }
+      paramGrid->addWidget(c, gridRow, 1);
 
       auto del = new ComboBoxModelDelegate(this);
       mapper->setItemDelegate(del);
@@ -70,8 +96,94 @@ void ParamWidget::initModel(ParamModel* paramModel) {
       connect(c, SIGNAL(currentIndexChanged(int)), del,
         SLOT(onCurrentIndexChanged(int)));
     }
-    mapper->setCurrentIndex(id++);
+    mapper->setCurrentIndex(i);
+    ++gridRow;
+  }
+  updateSteps();
+}
+
+
+// scheduleStepUpdate requests an update of the step recommendations
+void ParamWidget::scheduleStepUpdate() {
+  stepTimer_->start();
+}
+
+
+// updateSteps shows the mean diffusion step lengths of volume and surface
+// molecules at the current TIME_STEP and the recommended time and space
+// steps for the target step length
+void ParamWidget::updateSteps() {
+  if (paramModel_ == nullptr || molModel_ == nullptr) {
+    return;
+  }
+  double target = targetLengthEntry->text().toDouble();
+  double dt = paramModel_->value("TIME_STEP").toDouble();
+  double density = paramModel_->value("SURFACE_GRID_DENSITY").toDouble();
+  StepRecommendation rec = molModel_->stepAnalysis().recommend(target, dt,
+    density);
+
+  bool haveSteps = rec.timeStep > 0;
+  applyTimeStepButton->setEnabled(haveSteps);
+  applySpaceStepButton->setEnabled(haveSteps);
+  if (!haveSteps) {
+    stepReport->setText(tr("No diffusing molecules or no target step "
+      "length."));
+    return;
+  }
+
+  QString report;
+  QString at = (dt > 0) ? tr("at TIME_STEP = %1 s").arg(dt)
+    : tr("at the recommended TIME_STEP");
+  if (rec.vol.count > 0) {
+    report += tr("%1 volume molecules %2: mean step length %3 um "
+      "(%4 - %5 um)\n").arg(rec.vol.count).arg(at).arg(rec.vol.meanLength)
+      .arg(rec.vol.minLength).arg(rec.vol.maxLength);
+  }
+  if (rec.surf.count > 0) {
+    report += tr("%1 surface molecules %2: mean step length %3 um "
+      "(%4 - %5 um)\n").arg(rec.surf.count).arg(at).arg(rec.surf.meanLength)
+      .arg(rec.surf.minLength).arg(rec.surf.maxLength);
+  }
+  report += tr("recommended TIME_STEP = %1 s\n").arg(rec.timeStep);
+  report += tr("recommended SPACE_STEP = %1 um with TIME_STEP_MAX = %2 s")
+    .arg(rec.spaceStep).arg(rec.timeStepMax);
+  if (rec.dSpread > 10) {
+    report += tr(" (diffusion constants span a factor of %1, per molecule "
+      "time steps via SPACE_STEP save work)").arg(rec.dSpread, 0, 'g', 3);
+  }
+  if (rec.interactionRadius > 0) {
+    report += tr("\nINTERACTION_RADIUS defaults to %1 um for the current "
+      "SURFACE_GRID_DENSITY").arg(rec.interactionRadius);
+  }
+  stepReport->setText(report);
+}
+
+
+// applyTimeStep sets TIME_STEP to the recommended value and clears
+// SPACE_STEP and TIME_STEP_MAX
+void ParamWidget::applyTimeStep() {
+  double target = targetLengthEntry->text().toDouble();
+  StepRecommendation rec = molModel_->stepAnalysis().recommend(target, 0, 0);
+  if (rec.timeStep <= 0) {
+    return;
+  }
+  paramModel_->setValue("TIME_STEP", QString::number(rec.timeStep, 'g', 3));
+  paramModel_->setValue("SPACE_STEP", "");
+  paramModel_->setValue("TIME_STEP_MAX", "");
+}
+
+
+// applySpaceStep sets SPACE_STEP and TIME_STEP_MAX to the recommended values
+// so MCell picks a time step per molecule
+void ParamWidget::applySpaceStep() {
+  double target = targetLengthEntry->text().toDouble();
+  StepRecommendation rec = molModel_->stepAnalysis().recommend(target, 0, 0);
+  if (rec.timeStep <= 0) {
+    return;
   }
+  paramModel_->setValue("SPACE_STEP", QString::number(rec.spaceStep, 'g', 3));
+  paramModel_->setValue("TIME_STEP_MAX",
+    QString::number(rec.timeStepMax, 'g', 3));
 }
 
 
@@ -8,12 +8,14 @@
 #define PARAM_WIDGET_HPP
 
 #include <QItemDelegate>
+#include <QTimer>
 #include <QWidget>
 
 #include "ui_paramWidget.h"
 
 
 
+class MolModel;
 class ParamModel;
 
 // ComboBoxModelDelegate defines a custom delegate between combo-boxes and the model
@@ -41,9 +43,18 @@ class ParamWidget : public QWidget, Ui::ParamWidget {
 public:
   ParamWidget(QWidget* parent = 0, Qt::WindowFlags flags = 0);
 
-  void initModel(ParamModel* model);
+  void initModel(ParamModel* model, const MolModel* molModel);
+
+private slots:
+  void scheduleStepUpdate();
+  void updateSteps();
+  void applyTimeStep();
+  void applySpaceStep();
 
 private:
+  ParamModel* paramModel_ = nullptr;
+  const MolModel* molModel_ = nullptr;
+  QTimer* stepTimer_;
   QRegExp doubleOrEmptyRegex_ = QRegExp("([-+]?[0-9]*\\.?[0-9]+([eE][-+]?[0-9]+)?)?");
   QRegExp intOrEmptyRegex_ = QRegExp("([0-9]+)?");
 };
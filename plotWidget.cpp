@@ -0,0 +1,135 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+
+#include <QPainter>
+#include <QPolygonF>
+
+#include "plotWidget.hpp"
+
+
+// curveColor returns a distinct color for the i-th curve
+static QColor curveColor(int i) {
+  return QColor::fromHsv((i * 67) % 360, 200, 200);
+}
+
+
+// constructor
+PlotWidget::PlotWidget(QWidget* parent) : QWidget(parent) {
+  setMinimumSize(300, 200);
+  setBackgroundRole(QPalette::Base);
+  setAutoFillBackground(true);
+}
+
+
+// clear removes all curves
+void PlotWidget::clear() {
+  curves_.clear();
+  names_.clear();
+  tMax_ = 0.0;
+  yMax_ = 0.0;
+  update();
+}
+
+
+// addTrajectory adds one curve per entry of species. Curves of the same
+// species share a color so several trajectories can be overlaid. names
+// contains the legend entry for each species.
+void PlotWidget::addTrajectory(const Trajectory& traj,
+  const std::vector<int>& species, const QStringList& names) {
+  for (size_t s = 0; s < species.size(); ++s) {
+    Curve c;
+    c.t = traj.times;
+    c.y.reserve(traj.times.size());
+    for (size_t i = 0; i < traj.times.size(); ++i) {
+      double v = traj.at(i)[species[s]];
+      c.y.push_back(v);
+      yMax_ = std::max(yMax_, v);
+    }
+    c.colorIndex = s;
+    if (!traj.times.empty()) {
+      tMax_ = std::max(tMax_, traj.times.back());
+    }
+    curves_.push_back(std::move(c));
+  }
+  names_ = names;
+  update();
+}
+
+
+// setYLabel sets the label of the y axis
+void PlotWidget::setYLabel(const QString& label) {
+  yLabel_ = label;
+  update();
+}
+
+
+// paintEvent draws axes, curves and legend
+void PlotWidget::paintEvent(QPaintEvent* event) {
+  Q_UNUSED(event);
+  QPainter painter(this);
+  painter.setRenderHint(QPainter::Antialiasing);
+
+  const int left = 70;
+  const int right = 20;
+  const int top = 20;
+  const int bottom = 40;
+  QRectF area(left, top, width() - left - right, height() - top - bottom);
+  if (area.width() <= 0 || area.height() <= 0) {
+    return;
+  }
+
+  painter.setPen(palette().color(QPalette::Text));
+  painter.drawRect(area);
+  if (curves_.empty() || tMax_ <= 0.0) {
+    painter.drawText(area, Qt::AlignCenter, tr("no data"));
+    return;
+  }
+  double yMax = (yMax_ > 0.0) ? yMax_ : 1.0;
+
+  // axis labels at the extremes of both axes
+  QFontMetrics fm(painter.font());
+  painter.drawText(QRectF(0, area.top() - fm.height() / 2, left - 5,
+    fm.height()), Qt::AlignRight, QString::number(yMax, 'g', 3));
+  painter.drawText(QRectF(0, area.bottom() - fm.height() / 2, left - 5,
+    fm.height()), Qt::AlignRight, "0");
+  painter.drawText(QRectF(area.left(), area.bottom() + 2, 100, fm.height()),
+    Qt::AlignLeft, "0");
+  painter.drawText(QRectF(area.right() - 100, area.bottom() + 2, 100,
+    fm.height()), Qt::AlignRight, QString::number(tMax_, 'g', 3));
+  painter.drawText(QRectF(area.left(), area.bottom() + 2, area.width(),
+    fm.height()), Qt::AlignHCenter, tr("time [s]"));
+  painter.save();
+  painter.translate(12, area.center().y());
+  painter.rotate(-90);
+  painter.drawText(QRectF(-area.height() / 2, -fm.height() / 2, area.height(),
+    fm.height()), Qt::AlignCenter, yLabel_);
+  painter.restore();
+
+  painter.setClipRect(area.adjusted(-1, -1, 1, 1));
+  for (const auto& c : curves_) {
+    QPolygonF line;
+    for (size_t i = 0; i < c.t.size(); ++i) {
+      line << QPointF(area.left() + area.width() * c.t[i] / tMax_,
+        area.bottom() - area.height() * c.y[i] / yMax);
+    }
+    painter.setPen(QPen(curveColor(c.colorIndex), 1.5));
+    painter.drawPolyline(line);
+  }
+  painter.setClipping(false);
+
+  // legend in the upper right corner
+  int y = area.top() + 5;
+  for (int i = 0; i < names_.size(); ++i) {
+    int x = area.right() - fm.width(names_[i]) - 30;
+    painter.setPen(QPen(curveColor(i), 2));
+    painter.drawLine(x, y + fm.ascent() / 2, x + 20, y + fm.ascent() / 2);
+    painter.setPen(palette().color(QPalette::Text));
+    painter.drawText(x + 25, y + fm.ascent(), names_[i]);
+    y += fm.height();
+  }
+}
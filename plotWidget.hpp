@@ -0,0 +1,55 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef PLOT_WIDGET_HPP
+#define PLOT_WIDGET_HPP
+
+#include <vector>
+
+#include <QStringList>
+#include <QWidget>
+
+#include "reactionNetwork.hpp"
+
+
+// PlotWidget draws selected species of one or more trajectories as line
+// plots over time
+class PlotWidget : public QWidget {
+
+  Q_OBJECT
+
+public:
+
+  PlotWidget(QWidget* parent = 0);
+
+  void clear();
+  void addTrajectory(const Trajectory& traj, const std::vector<int>& species,
+    const QStringList& names);
+  void setYLabel(const QString& label);
+
+
+protected:
+
+  void paintEvent(QPaintEvent* event);
+
+
+private:
+
+  // Curve is a single plotted line
+  struct Curve {
+    std::vector<double> t;
+    std::vector<double> y;
+    int colorIndex;
+  };
+
+  std::vector<Curve> curves_;
+  QStringList names_;
+  QString yLabel_;
+  double tMax_ = 0.0;
+  double yMax_ = 0.0;
+};
+
+#endif
@@ -0,0 +1,346 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <functional>
+#include <string>
+
+#include <QRegularExpression>
+#include <QThread>
+#include <QtConcurrent>
+
+#include "molModel.hpp"
+#include "reactionExpansion.hpp"
+#include "reactionNetwork.hpp"
+#include "trace.hpp"
+
+namespace {
+
+// maximum number of reactant combinations a single expansion may visit
+const long long maxCombinations = 100000000;
+
+// Match is a molecule matching a reactant pattern together with the
+// pattern's captured substrings
+struct Match {
+  MolHandle mol;
+  QStringList captures;
+};
+
+// Chunk is a contiguous range of reactant combinations of one template
+struct Chunk {
+  int templ;
+  long long begin;
+  long long end;
+};
+
+// ChunkResult holds the reactions generated from a single Chunk
+struct ChunkResult {
+  std::vector<ReactionSpec> reactions;
+  long long numMissingProducts = 0;
+  long long numFailedSubstitutions = 0;
+  QString firstFailedSubstitution;
+};
+
+
+// needsSubstitution checks if text refers to any capture groups
+bool needsSubstitution(const QString& text) {
+  return text.contains('\\') || text.contains('{');
+}
+
+
+// captureIndex parses the capture reference \N starting at pos and returns
+// the zero based capture index or -1 if there is none
+int captureIndex(const QString& text, int& pos) {
+  if (pos >= text.size() || text[pos] != '\\') {
+    return -1;
+  }
+  int start = ++pos;
+  while (pos < text.size() && text[pos].isDigit()) {
+    ++pos;
+  }
+  return (pos > start) ? text.mid(start, pos - start).toInt() - 1 : -1;
+}
+
+
+// substitute replaces \N by the N-th capture and {\N+k} or {\N-k} by the
+// integer value of the N-th capture plus or minus k. This function returns
+// false if text refers to a capture which does not exist or is not an
+// integer.
+bool substitute(const QString& text, const QStringList& captures,
+  QString& result) {
+  result.clear();
+  int pos = 0;
+  while (pos < text.size()) {
+    if (text[pos] == '\\') {
+      int c = captureIndex(text, pos);
+      if (c < 0 || c >= captures.size()) {
+        return false;
+      }
+      result += captures[c];
+    } else if (text[pos] == '{') {
+      int close = text.indexOf('}', pos);
+      if (close < 0) {
+        return false;
+      }
+      QString inner = text.mid(pos + 1, close - pos - 1).trimmed();
+      int ipos = 0;
+      int c = captureIndex(inner, ipos);
+      if (c < 0 || c >= captures.size()) {
+        return false;
+      }
+      bool ok = false;
+      long long value = captures[c].toLongLong(&ok);
+      if (!ok) {
+        return false;
+      }
+      QString offset = inner.mid(ipos).remove(' ');
+      if (!offset.isEmpty()) {
+        long long k = offset.toLongLong(&ok);
+        if (!ok) {
+          return false;
+        }
+        value += k;
+      }
+      result += QString::number(value);
+      pos = close + 1;
+    } else {
+      result += text[pos++];
+    }
+  }
+  return true;
+}
+
+}
+
+
+// parseReactionTemplates parses one template per line of the form
+//
+//   R1 + R2 -> P1 + P2 [rate] : name
+//
+// Reactants and products have to be separated by " + " (with spaces) so
+// that + can be used inside regular expressions. The name is optional.
+// Empty lines and lines starting with # are ignored.
+bool parseReactionTemplates(const QString& text,
+  QList<ReactionTemplate>& templates, QString& error) {
+  templates.clear();
+  QRegularExpression plus("\\s+\\+\\s+");
+  int lineNum = 0;
+  for (const auto& rawLine : text.split('\n')) {
+    ++lineNum;
+    QString line = rawLine.trimmed();
+    if (line.isEmpty() || line.startsWith('#')) {
+      continue;
+    }
+    int arrow = line.indexOf("->");
+    int open = line.indexOf('[', arrow);
+    int close = line.indexOf(']', open);
+    if (arrow < 0 || open < 0 || close < 0) {
+      error = QString("line %1: expected reactants -> products [rate]")
+        .arg(lineNum);
+      return false;
+    }
+    ReactionTemplate t;
+    t.reactants = line.left(arrow).trimmed().split(plus);
+    t.products = line.mid(arrow + 2, open - arrow - 2).trimmed().split(plus);
+    t.rate = line.mid(open + 1, close - open - 1).trimmed();
+    QString rest = line.mid(close + 1).trimmed();
+    if (rest.startsWith(':')) {
+      t.name = rest.mid(1).trimmed();
+    } else if (!rest.isEmpty()) {
+      error = QString("line %1: unexpected '%2'").arg(lineNum).arg(rest);
+      return false;
+    }
+    if (t.name.isEmpty()) {
+      t.name = "reaction";
+    }
+    if (t.reactants.size() > ReactionNetwork::maxReactants) {
+      error = QString("line %1: at most %2 reactants are supported")
+        .arg(lineNum).arg(ReactionNetwork::maxReactants);
+      return false;
+    }
+    if (t.rate.isEmpty() || t.reactants.contains("")
+        || t.products.contains("")) {
+      error = QString("line %1: empty reactant, product or rate")
+        .arg(lineNum);
+      return false;
+    }
+    for (const auto& r : t.reactants) {
+      QRegularExpression re(r);
+      if (!re.isValid()) {
+        error = QString("line %1: invalid pattern %2: %3").arg(lineNum)
+          .arg(r).arg(re.errorString());
+        return false;
+      }
+    }
+    templates << t;
+  }
+  if (templates.isEmpty()) {
+    error = "no reaction templates given";
+    return false;
+  }
+  return true;
+}
+
+
+// expandTemplates generates all concrete reactions of the templates. The
+// reactant patterns are matched against the molecules once, then the
+// combinations of matches are split into chunks which are expanded in
+// parallel. The result is ordered by template and combination.
+ExpansionResult expandTemplates(const QList<ReactionTemplate>& templates,
+  const MolModel* molModel) {
+  TRACE_SCOPE("expandTemplates", "model");
+  ExpansionResult result;
+
+  const MolList& mols = molModel->getMols();
+
+  // match every reactant pattern of every template against all molecules
+  QStringList molNames;
+  for (const auto& m : mols) {
+    molNames << QString::fromStdString(m->name.str());
+  }
+  std::vector<std::vector<std::vector<Match>>> matches(templates.size());
+  QList<Chunk> chunks;
+  int numChunks = 4 * std::max(1, QThread::idealThreadCount());
+  for (int t = 0; t < templates.size(); ++t) {
+    long long combinations = 1;
+    for (const auto& pattern : templates[t].reactants) {
+      QRegularExpression re(QRegularExpression::anchoredPattern(pattern));
+      std::vector<Match> reactMatches;
+      for (size_t i = 0; i < mols.size(); ++i) {
+        QRegularExpressionMatch match = re.match(molNames[i]);
+        if (match.hasMatch()) {
+          QStringList captures = match.capturedTexts();
+          captures.removeFirst();
+          reactMatches.push_back(Match{mols[i]->handle, captures});
+        }
+      }
+      combinations *= reactMatches.size();
+      if (combinations > maxCombinations) {
+        result.error = QString("template %1 has more than %2 reactant "
+          "combinations").arg(t + 1).arg(maxCombinations);
+        return result;
+      }
+      matches[t].push_back(reactMatches);
+    }
+    result.numCombinations += combinations;
+    long long chunkSize = std::max(1LL, combinations / numChunks);
+    for (long long b = 0; b < combinations; b += chunkSize) {
+      chunks << Chunk{t, b, std::min(combinations, b + chunkSize)};
+    }
+  }
+
+  std::function<ChunkResult(const Chunk&)> expand =
+    [&templates, &matches, molModel](const Chunk& chunk) {
+      const ReactionTemplate& t = templates[chunk.templ];
+      const auto& reactMatches = matches[chunk.templ];
+      bool substProducts = false;
+      for (const auto& p : t.products) {
+        substProducts = substProducts || needsSubstitution(p);
+      }
+      bool substRate = needsSubstitution(t.rate);
+      bool substName = needsSubstitution(t.name);
+      const std::string fixedRate = t.rate.toStdString();
+      const std::string fixedName = t.name.toStdString();
+
+      ChunkResult res;
+      res.reactions.reserve(chunk.end - chunk.begin);
+      QStringList captures;
+      QString text;
+
+      // substituteOrFail substitutes the captures into field and records a
+      // failure if that is not possible
+      auto substituteOrFail = [&chunk, &captures, &text, &res](
+        const QString& field) {
+        if (substitute(field, captures, text)) {
+          return true;
+        }
+        if (res.numFailedSubstitutions++ == 0) {
+          res.firstFailedSubstitution = QString("template %1: %2 for "
+            "captures %3").arg(QString::number(chunk.templ + 1), field,
+            captures.join(", "));
+        }
+        return false;
+      };
+      for (long long c = chunk.begin; c < chunk.end; ++c) {
+        // decode the combination index into one match per reactant
+        ReactionSpec spec;
+        captures.clear();
+        long long rest = c;
+        std::vector<const Match*> picked(reactMatches.size());
+        for (int r = reactMatches.size() - 1; r >= 0; --r) {
+          picked[r] = &reactMatches[r][rest % reactMatches[r].size()];
+          rest /= reactMatches[r].size();
+        }
+        for (auto m : picked) {
+          spec.reactants.push_back(m->mol);
+          captures += m->captures;
+        }
+
+        bool ok = true;
+        bool missing = false;
+        for (const auto& p : t.products) {
+          if (substProducts && !substituteOrFail(p)) {
+            ok = false;
+            break;
+          }
+          const QString& name = substProducts ? text : p;
+          if (name == "NULL") {
+            spec.products.push_back(MolHandle());
+            continue;
+          }
+          const Molecule* mol = molModel->getMolecule(name);
+          if (mol == nullptr) {
+            ok = false;
+            missing = true;
+            break;
+          }
+          spec.products.push_back(mol->handle);
+        }
+        if (missing) {
+          ++res.numMissingProducts;
+        }
+        if (!ok) {
+          continue;
+        }
+        if (substRate) {
+          if (!substituteOrFail(t.rate)) {
+            continue;
+          }
+          spec.rate = text.toStdString();
+        } else {
+          spec.rate = fixedRate;
+        }
+        if (substName) {
+          if (!substituteOrFail(t.name)) {
+            continue;
+          }
+          spec.name = text.toStdString();
+        } else {
+          spec.name = fixedName;
+        }
+        res.reactions.push_back(std::move(spec));
+      }
+      return res;
+    };
+
+  QList<ChunkResult> chunkResults =
+    QtConcurrent::blockingMapped<QList<ChunkResult>>(chunks, expand);
+  size_t total = 0;
+  for (const auto& c : chunkResults) {
+    total += c.reactions.size();
+  }
+  result.reactions.reserve(total);
+  for (auto& c : chunkResults) {
+    result.numMissingProducts += c.numMissingProducts;
+    if (result.numFailedSubstitutions == 0) {
+      result.firstFailedSubstitution = c.firstFailedSubstitution;
+    }
+    result.numFailedSubstitutions += c.numFailedSubstitutions;
+    std::move(c.reactions.begin(), c.reactions.end(),
+      std::back_inserter(result.reactions));
+  }
+  return result;
+}
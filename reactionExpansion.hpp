@@ -0,0 +1,55 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef REACTION_EXPANSION_HPP
+#define REACTION_EXPANSION_HPP
+
+#include <vector>
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "reactionModel.hpp"
+
+class MolModel;
+
+
+// ReactionTemplate describes a family of reactions. Reactants are regular
+// expressions matched against complete molecule names. Products, rate and
+// name may refer to the capture groups of all reactants (numbered
+// consecutively across reactants) via \N and to their integer value plus
+// or minus an offset via {\N+k} or {\N-k}.
+struct ReactionTemplate {
+  QStringList reactants;
+  QStringList products;
+  QString rate;
+  QString name;
+};
+
+
+// ExpansionResult holds the concrete reactions generated from a set of
+// templates. Combinations whose products do not name existing molecules or
+// whose products, rate or name refer to missing or non-integer captures are
+// skipped and counted. firstFailedSubstitution describes the first failed
+// substitution.
+struct ExpansionResult {
+  std::vector<ReactionSpec> reactions;
+  long long numCombinations = 0;
+  long long numMissingProducts = 0;
+  long long numFailedSubstitutions = 0;
+  QString firstFailedSubstitution;
+  QString error;
+};
+
+
+bool parseReactionTemplates(const QString& text,
+  QList<ReactionTemplate>& templates, QString& error);
+
+ExpansionResult expandTemplates(const QList<ReactionTemplate>& templates,
+  const MolModel* molModel);
+
+#endif
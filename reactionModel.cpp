@@ -8,12 +8,18 @@
 
 #include <algorithm>
 #include <cassert>
+#include <set>
 
+#include <QColor>
+
+#include "memoryReport.hpp"
 #include "reactionModel.hpp"
+#include "symbolModel.hpp"
+#include "trace.hpp"
 
 
 ReactItem::ReactItem(const ReactItemType& type, const QString& name,
-  const Molecule* mol, ReactItem* parent) : type_(type), name_(name), mol_(mol),
+  MolHandle mol, ReactItem* parent) : type_(type), name_(name), mol_(mol),
   parent_(parent) {
   if (parent) {
     parent->addChild(this);
@@ -34,21 +40,19 @@ void ReactItem::addChild(ReactItem* item) {
 }
 
 
-// name returns the proper name for the ReactItem
+// name returns the proper name for the ReactItem. Reactant and Product
+// items cache the name of their molecule which the ReactTreeModel refreshes
+// when the molecule is renamed.
 QString ReactItem::name() const {
   QString reactString;
   switch (type_) {
     case ReactItemType::Repr:
       return makeReactionString_();
     case ReactItemType::Reactant:
-      Q_ASSERT(mol_ != nullptr);
-      return mol_->name;
+      Q_ASSERT(!mol_.isNull());
+      return name_;
     case ReactItemType::Product:
-      if (mol_ == nullptr) {
-        return "NULL";
-      } else {
-        return mol_->name;
-      }
+      return mol_.isNull() ? "NULL" : name_;
     default:
       return name_;
   }
@@ -100,7 +104,7 @@ ReactItemType ReactItem::type() const {
 }
 
 
-const Molecule* ReactItem::mol() const {
+MolHandle ReactItem::mol() const {
   return mol_;
 }
 
@@ -131,6 +135,21 @@ int ReactItem::childCount() const {
 }
 
 
+// memoryUsage adds the estimated memory used by this item and all its
+// children to itemBytes and the memory of their strings to stringBytes
+void ReactItem::memoryUsage(size_t& itemBytes, size_t& stringBytes) const {
+  itemBytes += sizeof(ReactItem) + heapOverhead;
+  if (!children_.isEmpty()) {
+    itemBytes += children_.size() * sizeof(void*) + sizeof(QArrayData) +
+      heapOverhead;
+  }
+  stringBytes += ::stringBytes(name_);
+  for (const auto c : children_) {
+    c->memoryUsage(itemBytes, stringBytes);
+  }
+}
+
+
 int ReactItem::rowOfChild(ReactItem* child) const {
   return children_.indexOf(child);
 }
@@ -141,8 +160,35 @@ void ReactItem::setName(const QString& name) {
 }
 
 
-void ReactItem::setMol(const Molecule* mol) {
+// setMol sets the molecule of a Reactant or Product item together with its
+// current name
+void ReactItem::setMol(MolHandle mol, const QString& name) {
   mol_ = mol;
+  name_ = name;
+}
+
+
+// field returns the SymbolModel field holding the compiled expression of a
+// Rate item or -1 for all other items
+int ReactItem::field() const {
+  return field_;
+}
+
+
+void ReactItem::setField(int field) {
+  field_ = field;
+}
+
+
+// hash returns the canonical hash of a Repr item's reaction as maintained by
+// the ReactTreeModel
+uint64_t ReactItem::hash() const {
+  return hash_;
+}
+
+
+void ReactItem::setHash(uint64_t hash) {
+  hash_ = hash;
 }
 
 
@@ -162,8 +208,17 @@ ReactItem* ReactItem::takeChild(int row) {
 
 
 // ReactTreeModel encapsulates the currently defined reactions as a tree model
-ReactTreeModel::ReactTreeModel(QObject* parent) :
-  QAbstractItemModel(parent), root_(nullptr)  {}
+// whose molecules are resolved via molModel. Without a shared SymbolModel
+// the model uses a private one so rates can still be given as expressions.
+ReactTreeModel::ReactTreeModel(const MolModel* molModel, QObject* parent,
+  SymbolModel* symbols) : QAbstractItemModel(parent), root_(nullptr),
+  molModel_(molModel), symbols_(symbols)  {
+  if (symbols_ == nullptr) {
+    symbols_ = new SymbolModel(this);
+  }
+  connect(symbols_, SIGNAL(valuesChanged(const QList<int>&)), this,
+    SLOT(updateFields_(const QList<int>&)));
+}
 
 
 ReactTreeModel::~ReactTreeModel() {
@@ -187,6 +242,7 @@ Qt::ItemFlags ReactTreeModel::flags(const QModelIndex& index) const {
 
 
 QVariant ReactTreeModel::data(const QModelIndex& index, int role) const {
+  TRACE_SCOPE("ReactTreeModel::data", "model");
   if (!root_ || !index.isValid() || index.column() < 0 ||
     index.column() >= columnCount_) {
     return QVariant();
@@ -195,6 +251,22 @@ QVariant ReactTreeModel::data(const QModelIndex& index, int role) const {
     if (role == Qt::DisplayRole || role == Qt::EditRole) {
       return item->name();
     }
+    if (item->type() == ReactItemType::Repr && isDuplicate(item)) {
+      if (role == Qt::ToolTipRole) {
+        return tr("duplicate of another reaction");
+      } else if (role == Qt::ForegroundRole) {
+        return QColor(Qt::darkYellow);
+      }
+    }
+    if (item->type() == ReactItemType::Rate) {
+      bool valid = symbols_->isValid(item->field());
+      if (role == Qt::ToolTipRole) {
+        return valid ? QString("= %1").arg(symbols_->value(item->field()))
+          : symbols_->error(item->field());
+      } else if (role == Qt::ForegroundRole && !valid) {
+        return QColor(Qt::red);
+      }
+    }
   }
   return QVariant();
 }
@@ -202,6 +274,7 @@ QVariant ReactTreeModel::data(const QModelIndex& index, int role) const {
 
 bool ReactTreeModel::setData(const QModelIndex& index, const QVariant& v,
   int role) {
+  TRACE_SCOPE("ReactTreeModel::setData", "model");
   if (!index.isValid() || index.column() != 0) {
     return false;
   }
@@ -209,19 +282,48 @@ bool ReactTreeModel::setData(const QModelIndex& index, const QVariant& v,
     if (role == Qt::EditRole) {
       switch(item->type()) {
         case ReactItemType::Reactant:
-        case ReactItemType::Product:
-          if (item->mol() != nullptr) {
-            emit(unuseMol(item->mol()->id));
-          }
-          item->setMol(static_cast<const Molecule*>(v.value<void *>()));
-          if (item->mol() != nullptr) {    // will happen for NULL product
-            emit(useMol(item->mol()->id));
+        case ReactItemType::Product: {
+            // stale handles of deleted molecules are rejected; only
+            // products may be NULL
+            MolHandle handle = v.value<MolHandle>();
+            const Molecule* mol = molModel_->resolve(handle);
+            if ((mol == nullptr && !handle.isNull()) || (handle.isNull()
+                && item->type() == ReactItemType::Reactant)) {
+              return false;
+            }
+            ReactItem* reaction = reactionForItem_(item);
+            uint64_t oldHash = reaction->hash();
+            unindexReaction_(reaction);
+            beginUseBatch();
+            untrackMolUse_(item);
+            item->setMol(handle, molName_(handle));
+            trackMolUse_(item);
+            commitUseBatch();
+            indexReaction_(reaction);
+            refreshBucket_(oldHash);
+            refreshBucket_(reaction->hash());
           }
           break;
+      case ReactItemType::Rate: {
+          QString error;
+          if (!symbols_->setField(item->field(), v.toString(), error)) {
+            return false;
+          }
+          item->setName(v.toString());
+        }
+        break;
       default:
         item->setName(v.toString());
         break;
       }
+      emit dataChanged(index, index);
+      QModelIndex reactIndex = indexForItem_(reactionForItem_(item));
+      if (reactIndex.isValid()) {
+        snapshot_.invalidate(reactIndex.row());
+      }
+      if (reactIndex.isValid() && reactIndex != index) {
+        emit dataChanged(reactIndex, reactIndex);
+      }
       return true;
     } else {
       return false;
@@ -231,6 +333,27 @@ bool ReactTreeModel::setData(const QModelIndex& index, const QVariant& v,
 }
 
 
+// indexForItem returns the QModelIndex corresponding to item. This requires
+// a search through the children of item's parent.
+QModelIndex ReactTreeModel::indexForItem_(ReactItem* item) const {
+  if (item == nullptr || item == root_) {
+    return QModelIndex();
+  }
+  ReactItem* parentItem = item->parent();
+  Q_ASSERT(parentItem);
+  return createIndex(parentItem->rowOfChild(item), 0, item);
+}
+
+
+// reactionForItem returns the top level reaction (Repr) item item belongs to
+ReactItem* ReactTreeModel::reactionForItem_(ReactItem* item) const {
+  while (item != nullptr && item->parent() != root_) {
+    item = item->parent();
+  }
+  return item;
+}
+
+
 // itemForIndex returns a pointer to the ReactItem corresponding to index
 ReactItem* ReactTreeModel::itemForIndex_(const QModelIndex& index) const {
   if (index.isValid()) {
@@ -315,14 +438,19 @@ bool ReactTreeModel::setHeaderData(int section, Qt::Orientation orient,
 
 
 bool ReactTreeModel::insertRows(int row, int count, const QModelIndex& parent) {
+  TRACE_SCOPE("ReactTreeModel::insertRows", "model");
   if (!root_) {
     root_ = new ReactItem(ReactItemType::Repr, "");
   }
   ReactItem* parentItem = parent.isValid() ? itemForIndex_(parent) : root_;
+  invalidateRows_(parentItem, row);
   beginInsertRows(parent, row, row+count-1);
   for (int i=0; i < count; ++i) {
     ReactItem* item = new ReactItem(ReactItemType::Repr, tr("NewItem"));
     parentItem->insertChild(row, item);
+    if (parentItem == root_) {
+      indexReaction_(item);
+    }
   }
   endInsertRows();
   return true;
@@ -330,15 +458,38 @@ bool ReactTreeModel::insertRows(int row, int count, const QModelIndex& parent) {
 
 
 bool ReactTreeModel::removeRows(int row, int count, const QModelIndex& parent) {
+  TRACE_SCOPE("ReactTreeModel::removeRows", "model");
   if (!root_) {
     return false;
   }
   ReactItem* parentItem = parent.isValid() ? itemForIndex_(parent) : root_;
+  ReactItem* reaction = (parentItem == root_) ? nullptr
+    : reactionForItem_(parentItem);
+  if (reaction != nullptr) {
+    unindexReaction_(reaction);
+  }
+  invalidateRows_(parentItem, row);
   beginRemoveRows(parent, row, row+count-1);
+  beginUseBatch();
+  std::vector<uint64_t> hashes;
   for (int i=0; i<count; ++i) {
-    delete parentItem->takeChild(row);
+    ReactItem* item = parentItem->takeChild(row);
+    if (parentItem == root_) {
+      unindexReaction_(item);
+      hashes.push_back(item->hash());
+    }
+    untrackSubtree_(item);
+    delete item;
   }
+  commitUseBatch();
   endRemoveRows();
+  if (reaction != nullptr) {
+    indexReaction_(reaction);
+    hashes.push_back(reaction->hash());
+  }
+  for (auto h : hashes) {
+    refreshBucket_(h);
+  }
   return true;
 }
 
@@ -346,33 +497,41 @@ bool ReactTreeModel::removeRows(int row, int count, const QModelIndex& parent) {
 // addReaction adds a new default reaction to the model which can then be
 // edited by the user.
 void ReactTreeModel::addReaction(const QString& reactName, const QString& rate,
-  const Molecule* react1, const Molecule* react2, const Molecule* prod1) {
+  MolHandle react1, MolHandle react2, MolHandle prod1) {
+  TRACE_SCOPE("ReactTreeModel::addReaction", "model");
   ReactItem* parentItem;
   if (!root_) {
     root_ = new ReactItem(ReactItemType::Repr, "");
   }
+  snapshot_.invalidateFrom(0);
   beginInsertRows(QModelIndex(), 0, 4);
+  beginUseBatch();
   ReactItem* reaction = new ReactItem(ReactItemType::Repr, tr(""));
   root_->insertChild(0, reaction);
 
   ReactItem* reactItem = new ReactItem(ReactItemType::ReactantTag, tr("reactants"));
   reaction->insertChild(0, reactItem);
-  ReactItem* react1Item = new ReactItem(ReactItemType::Reactant, "", react1);
+  ReactItem* react1Item = new ReactItem(ReactItemType::Reactant,
+    molName_(react1), react1);
   reactItem->insertChild(0, react1Item);
-  emit(useMol(react1->id));
-  ReactItem* react2Item = new ReactItem(ReactItemType::Reactant, "", react2);
+  trackMolUse_(react1Item);
+  ReactItem* react2Item = new ReactItem(ReactItemType::Reactant,
+    molName_(react2), react2);
   reactItem->insertChild(1, react2Item);
-  emit(useMol(react2->id));
+  trackMolUse_(react2Item);
 
   ReactItem* prodItem = new ReactItem(ReactItemType::ProductTag, tr("products"));
   reaction->insertChild(1, prodItem);
-  ReactItem* prod1Item = new ReactItem(ReactItemType::Product, "", prod1);
+  ReactItem* prod1Item = new ReactItem(ReactItemType::Product,
+    molName_(prod1), prod1);
   prodItem->insertChild(0, prod1Item);
-  emit(useMol(prod1->id));
+  trackMolUse_(prod1Item);
 
   ReactItem* rateItem = new ReactItem(ReactItemType::RateTag, tr("rate"));
   reaction->insertChild(2, rateItem);
   ReactItem* rate1Item = new ReactItem(ReactItemType::Rate, tr("0.0"));
+  rate1Item->setField(symbols_->addField(rate1Item->name()));
+  rateItems_[rate1Item->field()] = rate1Item;
   rateItem->insertChild(0, rate1Item);
 
   ReactItem* nameItem = new ReactItem(ReactItemType::NameTag, tr("name"));
@@ -380,16 +539,611 @@ void ReactTreeModel::addReaction(const QString& reactName, const QString& rate,
   ReactItem* name1Item = new ReactItem(ReactItemType::Name, tr("reaction"));
   nameItem->insertChild(0, name1Item);
 
+  commitUseBatch();
+  indexReaction_(reaction);
+  endInsertRows();
+  refreshBucket_(reaction->hash());
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+// addReactions is the bulk insertion path for generated networks. All
+// reactions are appended with a single row insertion. If skipDuplicates is
+// set, reactions which already exist or occur earlier in reactions are
+// skipped. This function returns the number of added reactions.
+int ReactTreeModel::addReactions(const std::vector<ReactionSpec>& reactions,
+  bool skipDuplicates) {
+  TRACE_SCOPE("ReactTreeModel::addReactions", "model");
+  if (!root_) {
+    root_ = new ReactItem(ReactItemType::Repr, "");
+  }
+  std::vector<ReactItem*> items;
+  items.reserve(reactions.size());
+  beginUseBatch();
+  for (const auto& spec : reactions) {
+    if (skipDuplicates && hasReaction(spec.reactants, spec.products)) {
+      continue;
+    }
+    ReactItem* reaction = makeReaction_(spec);
+    indexReaction_(reaction);
+    items.push_back(reaction);
+  }
+  commitUseBatch();
+  if (items.empty()) {
+    return 0;
+  }
+
+  int first = root_->childCount();
+  snapshot_.invalidateFrom(first);
+  beginInsertRows(QModelIndex(), first, first + items.size() - 1);
+  for (auto item : items) {
+    root_->addChild(item);
+  }
   endInsertRows();
+  return items.size();
 }
 
 
+// makeReaction_ builds the item subtree of a reaction and registers its
+// molecules and rate expression. The returned item is not yet part of the
+// tree.
+ReactItem* ReactTreeModel::makeReaction_(const ReactionSpec& spec) {
+  static const QString reactantsLabel = tr("reactants");
+  static const QString productsLabel = tr("products");
+  static const QString rateLabel = tr("rate");
+  static const QString nameLabel = tr("name");
+
+  ReactItem* reaction = new ReactItem(ReactItemType::Repr, "");
+  ReactItem* reactTag = new ReactItem(ReactItemType::ReactantTag,
+    reactantsLabel, MolHandle(), reaction);
+  for (auto mol : spec.reactants) {
+    ReactItem* item = new ReactItem(ReactItemType::Reactant, molName_(mol),
+      mol, reactTag);
+    trackMolUse_(item);
+  }
+  ReactItem* prodTag = new ReactItem(ReactItemType::ProductTag,
+    productsLabel, MolHandle(), reaction);
+  for (auto mol : spec.products) {
+    ReactItem* item = new ReactItem(ReactItemType::Product, molName_(mol),
+      mol, prodTag);
+    trackMolUse_(item);
+  }
+  ReactItem* rateTag = new ReactItem(ReactItemType::RateTag, rateLabel,
+    MolHandle(), reaction);
+  QString rate = QString::fromStdString(spec.rate);
+  ReactItem* rateItem = new ReactItem(ReactItemType::Rate, rate, MolHandle(),
+    rateTag);
+  rateItem->setField(symbols_->addField(rate));
+  rateItems_[rateItem->field()] = rateItem;
+  ReactItem* nameTag = new ReactItem(ReactItemType::NameTag, nameLabel,
+    MolHandle(), reaction);
+  new ReactItem(ReactItemType::Name, QString::fromStdString(spec.name),
+    MolHandle(), nameTag);
+  return reaction;
+}
 
 
+// numReactions returns the number of reactions in the model
+int ReactTreeModel::numReactions() const {
+  return root_ ? root_->childCount() : 0;
+}
 
 
+// reaction returns the Repr item of the reaction at the given row or nullptr
+// if the row is out of range
+const ReactItem* ReactTreeModel::reaction(int row) const {
+  return root_ ? root_->childAt(row) : nullptr;
+}
 
 
+// molecule returns the molecule of a Reactant or Product item or nullptr
+// for NULL products
+const Molecule* ReactTreeModel::molecule(const ReactItem* item) const {
+  return molModel_->resolve(item->mol());
+}
 
 
+// spec returns the reactants, products, rate and name of the reaction in row
+ReactionSpec ReactTreeModel::spec(int row) const {
+  ReactionSpec spec;
+  for (const auto tag : reaction(row)->children()) {
+    switch (tag->type()) {
+      case ReactItemType::ReactantTag:
+        for (const auto item : tag->children()) {
+          spec.reactants.push_back(item->mol());
+        }
+        break;
+      case ReactItemType::ProductTag:
+        for (const auto item : tag->children()) {
+          spec.products.push_back(item->mol());
+        }
+        break;
+      case ReactItemType::RateTag:
+        spec.rate = tag->childAt(0)->name().toStdString();
+        break;
+      case ReactItemType::NameTag:
+        spec.name = tag->childAt(0)->name().toStdString();
+        break;
+      default:
+        break;
+    }
+  }
+  return spec;
+}
 
+
+// molName_ returns the current name of the molecule with the given handle
+// or an empty string for NULL products
+QString ReactTreeModel::molName_(MolHandle handle) const {
+  const Molecule* mol = molModel_->resolve(handle);
+  return (mol == nullptr) ? QString() :
+    QString::fromStdString(mol->name.str());
+}
+
+
+// snapshot returns an immutable copy of the current reactions which can be
+// read from any thread. Chunks of unchanged reactions are shared with the
+// previous snapshot.
+ReactionSnapshot ReactTreeModel::snapshot() const {
+  TRACE_SCOPE("ReactTreeModel::snapshot", "model");
+  return snapshot_.publish(numReactions(), [this](size_t row) {
+    return record_(root_->childAt(row));
+  });
+}
+
+
+// record_ builds the snapshot record of a reaction
+ReactionRecord ReactTreeModel::record_(const ReactItem* reaction) const {
+  ReactionRecord rec;
+  rec.rateValue = 0.0;
+  rec.rateValid = false;
+  for (const auto tag : reaction->children()) {
+    switch (tag->type()) {
+      case ReactItemType::ReactantTag:
+      case ReactItemType::ProductTag:
+        for (const auto item : tag->children()) {
+          const Molecule* mol = molecule(item);
+          if (mol == nullptr) {
+            continue;
+          }
+          if (tag->type() == ReactItemType::ReactantTag) {
+            rec.reactants.push_back(mol->id);
+          } else {
+            rec.products.push_back(mol->id);
+          }
+        }
+        break;
+      case ReactItemType::RateTag:
+        if (tag->childCount() > 0) {
+          const ReactItem* rate = tag->childAt(0);
+          rec.rate = rate->name().toStdString();
+          rec.rateValid = symbols_->isValid(rate->field());
+          rec.rateValue = symbols_->value(rate->field());
+        }
+        break;
+      case ReactItemType::NameTag:
+        if (tag->childCount() > 0) {
+          rec.name = tag->childAt(0)->name().toStdString();
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return rec;
+}
+
+
+// invalidateRows_ marks the snapshot rows affected by inserting or removing
+// children of parentItem at row
+void ReactTreeModel::invalidateRows_(ReactItem* parentItem, int row) {
+  if (parentItem == root_) {
+    snapshot_.invalidateFrom(row);
+  } else {
+    ReactItem* reaction = reactionForItem_(parentItem);
+    snapshot_.invalidate(root_->rowOfChild(reaction));
+  }
+}
+
+
+// symbols returns the symbol table used by the rate expressions
+SymbolModel* ReactTreeModel::symbols() const {
+  return symbols_;
+}
+
+
+// updateFields_ refreshes the rate items whose value changed due to a
+// symbol edit
+void ReactTreeModel::updateFields_(const QList<int>& fields) {
+  // locating the reaction row of a rate is linear in the number of
+  // reactions, so large updates invalidate the whole snapshot instead
+  bool invalidateAll = fields.size() > maxRowInvalidations;
+  if (invalidateAll) {
+    snapshot_.invalidateAll();
+  }
+  for (auto field : fields) {
+    auto it = rateItems_.find(field);
+    if (it != rateItems_.end()) {
+      QModelIndex index = indexForItem_(it->second);
+      emit dataChanged(index, index);
+      if (!invalidateAll) {
+        snapshot_.invalidate(indexForItem_(reactionForItem_(it->second)).row());
+      }
+    }
+  }
+}
+
+
+// stoichiometryMatrix builds the species x reactions stoichiometry matrix in
+// a single pass over the reaction store. Species rows are ordered as the
+// molecules in molModel and reaction columns as the reactions in the model.
+// NULL products do not contribute.
+CSRMatrix ReactTreeModel::stoichiometryMatrix(const MolModel* molModel) const {
+  TRACE_SCOPE("ReactTreeModel::stoichiometryMatrix", "model");
+  const MolList& mols = molModel->getMols();
+  qlonglong maxID = -1;
+  for (const auto& m : mols) {
+    maxID = std::max(maxID, m->id);
+  }
+  std::vector<int> rowOfID(maxID + 1, -1);
+  for (size_t i = 0; i < mols.size(); ++i) {
+    rowOfID[mols[i]->id] = i;
+  }
+
+  int numReacts = numReactions();
+  StoichBuilder builder(mols.size());
+  builder.reserve(numReacts, 3 * int64_t(numReacts));
+  for (int r = 0; r < numReacts; ++r) {
+    builder.beginReaction();
+    for (const auto tag : root_->childAt(r)->children()) {
+      int coeff;
+      if (tag->type() == ReactItemType::ReactantTag) {
+        coeff = -1;
+      } else if (tag->type() == ReactItemType::ProductTag) {
+        coeff = 1;
+      } else {
+        continue;
+      }
+      for (const auto item : tag->children()) {
+        if (const Molecule* mol = molecule(item)) {
+          builder.addSpecies(rowOfID[mol->id], coeff);
+        }
+      }
+    }
+    builder.endReaction();
+  }
+  return builder.toCSR();
+}
+
+
+// compileNetwork converts the reactions into a flat ReactionNetwork whose
+// species are the molecules in molModel in model order. Rates whose
+// expressions are invalid are set to zero and counted in numInvalidRates.
+// Rows of reactions with too many reactants are returned in rejected.
+ReactionNetwork ReactTreeModel::compileNetwork(const MolModel* molModel,
+  int* numInvalidRates, std::vector<int>* rejected) const {
+  TRACE_SCOPE("ReactTreeModel::compileNetwork", "model");
+  return ::compileNetwork(molModel->snapshot(), snapshot(), numInvalidRates,
+    rejected);
+}
+
+
+// memoryUsage adds the estimated memory used by the reaction tree, its
+// strings and the molecule usage index to report
+void ReactTreeModel::memoryUsage(MemoryReport& report) const {
+  report.numReactions = numReactions();
+  report.reactTree = 0;
+  report.reactStrings = 0;
+  if (root_) {
+    root_->memoryUsage(report.reactTree, report.reactStrings);
+  }
+  report.reactUsageIndex = 0;
+  for (const auto& u : molUsers_) {
+    report.reactUsageIndex += sizeof(u) + mapNodeOverhead +
+      u.second.capacity() * sizeof(ReactItem*) + heapOverhead;
+  }
+  report.reactUsageIndex += reactionIndex_.bucketCount() * sizeof(void*);
+  for (const auto& r : reactionIndex_) {
+    report.reactUsageIndex += sizeof(r) + mapNodeOverhead +
+      r.second.capacity() * sizeof(ReactItem*) + heapOverhead;
+  }
+}
+
+
+// reactionKey_ extracts the canonical reactant and product lists of a
+// reaction
+void ReactTreeModel::reactionKey_(const ReactItem* reaction,
+  std::vector<MolHandle>& reactants, std::vector<MolHandle>& products) {
+  reactants.clear();
+  products.clear();
+  for (const auto tag : reaction->children()) {
+    if (tag->type() == ReactItemType::ReactantTag) {
+      for (const auto item : tag->children()) {
+        if (!item->mol().isNull()) {
+          reactants.push_back(item->mol());
+        }
+      }
+    } else if (tag->type() == ReactItemType::ProductTag) {
+      for (const auto item : tag->children()) {
+        products.push_back(item->mol());
+      }
+    }
+  }
+  canonicalReaction(reactants, products);
+}
+
+
+// sameReaction_ compares the canonical forms of two reactions to rule out
+// hash collisions
+bool ReactTreeModel::sameReaction_(const ReactItem* a, const ReactItem* b) {
+  std::vector<MolHandle> ra, pa, rb, pb;
+  reactionKey_(a, ra, pa);
+  reactionKey_(b, rb, pb);
+  return ra == rb && pa == pb;
+}
+
+
+// indexReaction_ computes the canonical hash of a reaction and adds it to
+// the reaction index. Reactions without reactants, e.g. freshly inserted
+// rows, are incomplete and never duplicates, so they are not indexed.
+void ReactTreeModel::indexReaction_(ReactItem* reaction) {
+  std::vector<MolHandle> reactants, products;
+  reactionKey_(reaction, reactants, products);
+  reaction->setHash(reactionHash(reactants, products));
+  if (reactants.empty()) {
+    return;
+  }
+  reactionIndex_.add(reaction->hash(), reaction);
+}
+
+
+// unindexReaction_ removes a reaction from the reaction index
+void ReactTreeModel::unindexReaction_(ReactItem* reaction) {
+  reactionIndex_.remove(reaction->hash(), reaction);
+}
+
+
+// refreshBucket_ refreshes the summary rows of all reactions with the given
+// hash since their duplicate state may have changed
+void ReactTreeModel::refreshBucket_(uint64_t hash) {
+  auto bucket = reactionIndex_.bucket(hash);
+  if (bucket == nullptr) {
+    return;
+  }
+  for (auto reaction : *bucket) {
+    QModelIndex index = indexForItem_(reaction);
+    emit dataChanged(index, index);
+  }
+}
+
+
+// isDuplicate returns true if another reaction has the same reactants and
+// products as reaction regardless of their order
+bool ReactTreeModel::isDuplicate(const ReactItem* reaction) const {
+  auto bucket = reactionIndex_.bucket(reaction->hash());
+  if (bucket == nullptr) {
+    return false;
+  }
+  for (auto other : *bucket) {
+    if (other != reaction && sameReaction_(reaction, other)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// hasReaction checks in O(1) if a reaction with the given reactants and
+// products already exists. NULL products are given as null handles.
+bool ReactTreeModel::hasReaction(std::vector<MolHandle> reactants,
+  std::vector<MolHandle> products) const {
+  canonicalReaction(reactants, products);
+  auto bucket = reactionIndex_.bucket(reactionHash(reactants, products));
+  if (bucket == nullptr) {
+    return false;
+  }
+  std::vector<MolHandle> r, p;
+  for (auto reaction : *bucket) {
+    reactionKey_(reaction, r, p);
+    if (r == reactants && p == products) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// findDuplicates returns groups of rows of reactions which are identical up
+// to the order of their reactants and products
+std::vector<std::vector<int>> ReactTreeModel::findDuplicates() const {
+  TRACE_SCOPE("ReactTreeModel::findDuplicates", "model");
+  std::vector<std::vector<int>> groups;
+  if (!root_) {
+    return groups;
+  }
+  std::unordered_map<const ReactItem*, int> rows;
+  for (int r = 0; r < root_->childCount(); ++r) {
+    rows[root_->childAt(r)] = r;
+  }
+  for (const auto& b : reactionIndex_) {
+    const auto& bucket = b.second;
+    if (bucket.size() < 2) {
+      continue;
+    }
+    // split the bucket into groups of identical reactions in case of hash
+    // collisions
+    std::vector<bool> done(bucket.size(), false);
+    for (size_t i = 0; i < bucket.size(); ++i) {
+      if (done[i]) {
+        continue;
+      }
+      std::vector<int> group(1, rows[bucket[i]]);
+      for (size_t j = i + 1; j < bucket.size(); ++j) {
+        if (!done[j] && sameReaction_(bucket[i], bucket[j])) {
+          done[j] = true;
+          group.push_back(rows[bucket[j]]);
+        }
+      }
+      if (group.size() > 1) {
+        std::sort(group.begin(), group.end());
+        groups.push_back(group);
+      }
+    }
+  }
+  std::sort(groups.begin(), groups.end());
+  return groups;
+}
+
+
+// beginUseBatch starts collecting molecule reference count changes. Batches
+// may be nested; the changes are emitted when the outermost batch is
+// committed.
+void ReactTreeModel::beginUseBatch() {
+  ++useBatchDepth_;
+}
+
+
+// commitUseBatch ends a batch started by beginUseBatch and emits the net
+// reference count change of every affected molecule in a single
+// molUseChanged signal
+void ReactTreeModel::commitUseBatch() {
+  Q_ASSERT(useBatchDepth_ > 0);
+  if (--useBatchDepth_ > 0 || molUseDeltas_.empty()) {
+    return;
+  }
+  MolUseDeltas deltas;
+  deltas.reserve(molUseDeltas_.size());
+  for (const auto& d : molUseDeltas_) {
+    if (d.second != 0) {
+      deltas.push_back(MolUseDelta{d.first, d.second});
+    }
+  }
+  molUseDeltas_.clear();
+  if (!deltas.empty()) {
+    emit(molUseChanged(deltas));
+  }
+}
+
+
+// changeMolUse_ records a reference count change of the molecule with the
+// given id. Outside of a batch the change is emitted right away.
+void ReactTreeModel::changeMolUse_(long id, int delta) {
+  if (useBatchDepth_ == 0) {
+    emit(molUseChanged(MolUseDeltas{MolUseDelta{id, delta}}));
+    return;
+  }
+  molUseDeltas_[id] += delta;
+}
+
+
+// trackMolUse registers a Reactant or Product item with the molecule usage
+// index and counts it as a reference to its molecule
+void ReactTreeModel::trackMolUse_(ReactItem* item) {
+  const Molecule* mol = molecule(item);
+  if (mol == nullptr) {
+    return;
+  }
+  molUsers_[mol->id].push_back(item);
+  changeMolUse_(mol->id, 1);
+}
+
+
+// untrackMolUse removes a Reactant or Product item from the molecule usage
+// index and releases its reference to the molecule
+void ReactTreeModel::untrackMolUse_(ReactItem* item) {
+  const Molecule* mol = molecule(item);
+  if (mol == nullptr) {
+    return;
+  }
+  auto it = molUsers_.find(mol->id);
+  if (it == molUsers_.end()) {
+    return;
+  }
+  changeMolUse_(mol->id, -1);
+  auto& users = it->second;
+  users.erase(std::remove(users.begin(), users.end(), item), users.end());
+  if (users.empty()) {
+    molUsers_.erase(it);
+  }
+}
+
+
+// untrackSubtree removes item and all its descendants from the molecule
+// usage index and releases their rate expressions. This needs to happen
+// before items are deleted.
+void ReactTreeModel::untrackSubtree_(ReactItem* item) {
+  if (item->type() == ReactItemType::Reactant ||
+      item->type() == ReactItemType::Product) {
+    untrackMolUse_(item);
+  } else if (item->type() == ReactItemType::Rate) {
+    rateItems_.erase(item->field());
+    symbols_->removeField(item->field());
+  }
+  for (auto c : item->children()) {
+    untrackSubtree_(c);
+  }
+}
+
+
+// updateMolecule is a slot for refreshing all rows which display the
+// molecule with the given id, e.g. after it was renamed. Only the affected
+// Reactant and Product rows and the summary rows of their reactions are
+// refreshed. Affected rows under a common parent are coalesced into
+// contiguous ranges so that each range triggers a single dataChanged.
+void ReactTreeModel::updateMolecule(long id) {
+  TRACE_SCOPE("ReactTreeModel::updateMolecule", "model");
+  auto it = molUsers_.find(id);
+  if (it == molUsers_.end() || it->second.empty()) {
+    return;
+  }
+
+  // refresh the cached molecule names and collect the affected items
+  // grouped by their parent item
+  std::map<ReactItem*, std::set<ReactItem*>> affected;
+  for (auto item : it->second) {
+    item->setName(molName_(item->mol()));
+    ReactItem* tag = item->parent();
+    Q_ASSERT(tag);
+    affected[tag].insert(item);
+    ReactItem* reaction = tag->parent();
+    if (reaction != nullptr && reaction != root_) {
+      affected[root_].insert(reaction);
+    }
+  }
+
+  // a single pass over each parent's children yields the affected rows in
+  // order which are then merged into contiguous ranges
+  for (auto& a : affected) {
+    ReactItem* parentItem = a.first;
+    const auto& items = a.second;
+    QModelIndex parentIndex = indexForItem_(parentItem);
+    int first = -1;
+    int last = -1;
+    for (int row = 0; row < parentItem->childCount(); ++row) {
+      if (items.find(parentItem->childAt(row)) == items.end()) {
+        continue;
+      }
+      if (first >= 0 && row == last + 1) {
+        last = row;
+        continue;
+      }
+      if (first >= 0) {
+        emit dataChanged(index(first, 0, parentIndex), index(last, 0, parentIndex));
+      }
+      first = last = row;
+    }
+    if (first >= 0) {
+      emit dataChanged(index(first, 0, parentIndex), index(last, 0, parentIndex));
+    }
+  }
+}
@@ -7,15 +7,25 @@
 #ifndef REACTION_MODEL_HPP
 #define REACTION_MODEL_HPP
 
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <QAbstractListModel>
 #include <QList>
 #include <QString>
 
+#include "modelState.hpp"
 #include "molModel.hpp"
+#include "reactionIndex.hpp"
+#include "reactionNetwork.hpp"
+#include "reactionSpec.hpp"
+#include "stoichMatrix.hpp"
+
+struct MemoryReport;
+class SymbolModel;
 
 
 // this enum describes the type of ReactItem
@@ -33,7 +43,7 @@ class ReactItem {
 public:
 
   explicit ReactItem(const ReactItemType& type, const QString& name,
-    const Molecule* mol = nullptr, ReactItem* parent = nullptr);
+    MolHandle mol = MolHandle(), ReactItem* parent = nullptr);
   ~ReactItem();
 
   QString name() const;
@@ -43,12 +53,17 @@ public:
   ReactItem* parent() const;
   ReactItem* childAt(int row) const;
   const QList<ReactItem*> children() const;
-  const Molecule* mol() const;
+  MolHandle mol() const;
   int rowOfChild(ReactItem* child) const;
   int childCount() const;
+  int field() const;
+  uint64_t hash() const;
+  void memoryUsage(size_t& itemBytes, size_t& stringBytes) const;
 
   void setName(const QString& name);
-  void setMol(const Molecule* mol);
+  void setMol(MolHandle mol, const QString& name);
+  void setField(int field);
+  void setHash(uint64_t hash);
 
   void insertChild(int row, ReactItem* item);
   void addChild(ReactItem* item);
@@ -61,7 +76,9 @@ private:
 
   ReactItemType type_;
   QString name_;
-  const Molecule* mol_;
+  MolHandle mol_;
+  int field_ = -1;
+  uint64_t hash_ = 0;
 
   ReactItem* parent_;
   QList<ReactItem*> children_;
@@ -76,7 +93,8 @@ class ReactTreeModel : public QAbstractItemModel {
 
 public:
 
-  explicit ReactTreeModel(QObject* parent = nullptr);
+  explicit ReactTreeModel(const MolModel* molModel, QObject* parent = nullptr,
+    SymbolModel* symbols = nullptr);
   ~ReactTreeModel();
 
   Qt::ItemFlags flags(const QModelIndex& index) const;
@@ -93,22 +111,96 @@ public:
   bool insertRows(int row, int count, const QModelIndex& parent);
   bool removeRows(int row, int count, const QModelIndex& parent);
 
-  void addReaction(const QString& reactName, const QString& rate, const Molecule* react1,
-    const Molecule* react2, const Molecule* prod1);
+  void addReaction(const QString& reactName, const QString& rate,
+    MolHandle react1, MolHandle react2, MolHandle prod1);
+  int addReactions(const std::vector<ReactionSpec>& reactions,
+    bool skipDuplicates = true);
+  void beginUseBatch();
+  void commitUseBatch();
+
+  int numReactions() const;
+  SymbolModel* symbols() const;
+  const ReactItem* reaction(int row) const;
+  const Molecule* molecule(const ReactItem* item) const;
+  ReactionSpec spec(int row) const;
+  ReactionSnapshot snapshot() const;
+  CSRMatrix stoichiometryMatrix(const MolModel* molModel) const;
+  ReactionNetwork compileNetwork(const MolModel* molModel,
+    int* numInvalidRates = nullptr,
+    std::vector<int>* rejected = nullptr) const;
+
+  bool isDuplicate(const ReactItem* reaction) const;
+  bool hasReaction(std::vector<MolHandle> reactants,
+    std::vector<MolHandle> products) const;
+  std::vector<std::vector<int>> findDuplicates() const;
+
+  void memoryUsage(MemoryReport& report) const;
+
+
+public slots:
+
+  void updateMolecule(long id);
 
 
 signals:
 
-  void useMol(long id);
-  void unuseMol(long id);
+  void molUseChanged(const MolUseDeltas& deltas);
+
+
+private slots:
+
+  void updateFields_(const QList<int>& fields);
 
 
 private:
 
   ReactItem* itemForIndex_(const QModelIndex& index) const;
+  QModelIndex indexForItem_(ReactItem* item) const;
+  ReactItem* reactionForItem_(ReactItem* item) const;
+
+  void changeMolUse_(long id, int delta);
+  void trackMolUse_(ReactItem* item);
+  void untrackMolUse_(ReactItem* item);
+  void untrackSubtree_(ReactItem* item);
+  QString molName_(MolHandle handle) const;
+  ReactItem* makeReaction_(const ReactionSpec& spec);
+  ReactionRecord record_(const ReactItem* reaction) const;
+  void invalidateRows_(ReactItem* parentItem, int row);
+
+  static void reactionKey_(const ReactItem* reaction,
+    std::vector<MolHandle>& reactants, std::vector<MolHandle>& products);
+  static bool sameReaction_(const ReactItem* a, const ReactItem* b);
+  void indexReaction_(ReactItem* reaction);
+  void unindexReaction_(ReactItem* reaction);
+  void refreshBucket_(uint64_t hash);
+
+  // maximum number of rate changes which invalidate single snapshot rows
+  static const int maxRowInvalidations = 64;
 
   const int columnCount_ = 1;
   ReactItem* root_;
+  const MolModel* molModel_;
+  SymbolModel* symbols_;
+
+  // rateItems_ maps the SymbolModel fields of rate expressions to their items
+  std::unordered_map<int, ReactItem*> rateItems_;
+
+  // molUsers_ maps molecule ids to the Reactant and Product items which
+  // reference them so that changes to a molecule only refresh affected rows
+  std::map<long, std::vector<ReactItem*>> molUsers_;
+
+  // molUseDeltas_ collects the molecule reference count changes of the
+  // current use batch which are emitted once by commitUseBatch
+  int useBatchDepth_ = 0;
+  std::unordered_map<long, int> molUseDeltas_;
+
+  // reactionIndex_ maps the canonical hash of each reaction to the
+  // reactions with this hash for O(1) duplicate checks
+  ReactionIndex<ReactItem> reactionIndex_;
+
+  // snapshot_ publishes immutable copies of the reactions for worker
+  // threads; only chunks with changed reactions are copied
+  mutable PersistentVectorBuilder<ReactionRecord> snapshot_;
 
 };
 
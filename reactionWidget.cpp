@@ -10,17 +10,29 @@
 #include <set>
 #include <utility>
 
+#include <QApplication>
+#include <QClipboard>
 #include <QComboBox>
+#include <QKeyEvent>
 #include <QLineEdit>
 #include <QMessageBox>
 #include <QShortcut>
 
 #include "reactionWidget.hpp"
+#include "tableImport.hpp"
+#include "trace.hpp"
 
-// constructor
+// constructor. The widgets of the tab are only created by initModel once
+// the tab is first shown.
 ReactionWidget::ReactionWidget(QWidget* parent, Qt::WindowFlags flags) :
-  QWidget(parent, flags) {
+  QWidget(parent, flags) {}
 
+
+// initModel creates the widgets of the tab and initializes the widget's
+// underlying reaction model. In addition to the ReactionModel, the widget
+// also keeps track of the MoleculeModel
+void ReactionWidget::initModel(ReactTreeModel* reactModel, MolModel* molModel) {
+  TRACE_SCOPE("ReactionWidget::initModel", "ui");
   setupUi(this);
   //reactListView->setSortingEnabled(true);
 
@@ -32,12 +44,11 @@ ReactionWidget::ReactionWidget(QWidget* parent, Qt::WindowFlags flags) :
   connect(addShortCut, SIGNAL(activated()), this, SLOT(addReaction()));
   QShortcut *delShortCut = new QShortcut(QKeySequence("Ctrl+X"), this);
   connect(delShortCut, SIGNAL(activated()), this, SLOT(deleteReactions()));
-}
 
+  // pasting is handled by the view itself so that editors keep their own
+  // clipboard handling
+  reactTreeView->installEventFilter(this);
 
-// initModel initializes the widget's underlying reaction model. In addition
-// to the ReactionModel, the widget also keeps track of the MoleculeModel
-void ReactionWidget::initModel(ReactTreeModel* reactModel, MolModel* molModel) {
   reactModel_ = reactModel;
   molModel_ = molModel;
 
@@ -51,6 +62,18 @@ void ReactionWidget::initModel(ReactTreeModel* reactModel, MolModel* molModel) {
 }
 
 
+// eventFilter pastes the clipboard contents as reactions when Paste is
+// pressed in the reaction view
+bool ReactionWidget::eventFilter(QObject* watched, QEvent* event) {
+  if (watched == reactTreeView && event->type() == QEvent::KeyPress &&
+    static_cast<QKeyEvent*>(event)->matches(QKeySequence::Paste)) {
+    pasteReactions();
+    return true;
+  }
+  return QWidget::eventFilter(watched, event);
+}
+
+
 // deleteReactions deletes all currently selected molecules from the model
 void ReactionWidget::deleteReactions() {
   /*
@@ -88,13 +111,31 @@ void ReactionWidget::addReaction() {
   // construct a default reaction
   QString id;
   QString reactName = "reac_" + id.setNum(reactCount_++);
-  Molecule* mol = molModel_->getMols()[0].get();
-  std::vector<const Molecule*> products;
-  products.push_back(mol);
+  MolHandle mol = molModel_->getMols()[0]->handle;
   reactModel_->addReaction(reactName, "0.0", mol, mol, mol);
 }
 
 
+// pasteReactions adds the rows of the clipboard as reactions in one bulk
+// insertion. Reactants and products have to name existing molecules;
+// invalid rows and duplicates of existing reactions are skipped and
+// reported.
+void ReactionWidget::pasteReactions() {
+  TRACE_SCOPE("ReactionWidget::pasteReactions", "ui");
+  QString text = QApplication::clipboard()->text();
+  if (text.isEmpty()) {
+    return;
+  }
+  QTextStream in(&text, QIODevice::ReadOnly);
+  ReactionImport result = importReactions(in, molModel_);
+  int numAdded = reactModel_->addReactions(result.reactions, true);
+  if (numAdded < result.numRows) {
+    showImportReport(this, tr("Paste Reactions"), tr("reactions"), numAdded,
+      result);
+  }
+}
+
+
 // ReactModelDelegate constructor
 // NOTE: The delegate needs access to the molModel in order to populate
 // properly populate the molecule selectors with the available molecule names
@@ -105,6 +146,7 @@ ReactModelDelegate::ReactModelDelegate(const MolModel* molModel,
 // createEditor creates the appropriate editor for each of the columns
 QWidget* ReactModelDelegate::createEditor(QWidget *parent,
   const QStyleOptionViewItem &option, const QModelIndex &index) const {
+  TRACE_SCOPE("ReactModelDelegate::createEditor", "delegate");
 
   Q_UNUSED(option)
 
@@ -150,7 +192,6 @@ void ReactModelDelegate::setEditorData(QWidget* editor,
     case ReactItemType::Rate:
       edit = qobject_cast<QLineEdit*>(editor);
       Q_ASSERT(edit);
-      edit->setValidator(new QDoubleValidator);
       edit->setText(v.toString());
       break;
     case ReactItemType::Reactant:
@@ -166,10 +207,9 @@ void ReactModelDelegate::setEditorData(QWidget* editor,
 }
 
 
-// setModelData writes the data to the model based on the editor setting
-// NOTE: Currently we send the molecule info to the reaction model as void
-// pointers within a QVariant. This seems a bit hackish and could perhaps be
-// improved.
+// setModelData writes the data to the model based on the editor setting.
+// Molecules are passed to the reaction model as MolHandles; the NULL
+// product is passed as a null handle.
 void ReactModelDelegate::setModelData(QWidget *editor, QAbstractItemModel* model,
   const QModelIndex& index) const {
 
@@ -189,7 +229,7 @@ void ReactModelDelegate::setModelData(QWidget *editor, QAbstractItemModel* model
     case ReactItemType::Product:
       combo = qobject_cast<QComboBox*>(editor);
       mol = molModel_->getMolecule(combo->currentText());
-      v = qVariantFromValue((void *)mol);
+      v = QVariant::fromValue(mol ? mol->handle : MolHandle());
       model->setData(index, v);
       break;
     default:
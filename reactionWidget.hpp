@@ -48,6 +48,8 @@ public:
 
   void initModel(ReactTreeModel* reactModel, MolModel* molModel);
 
+  bool eventFilter(QObject* watched, QEvent* event);
+
 private:
 
   int reactCount_ = 0;
@@ -57,6 +59,7 @@ private:
 private slots:
   void addReaction();
   void deleteReactions();
+  void pasteReactions();
 };
 
 
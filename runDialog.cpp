@@ -0,0 +1,241 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QItemSelectionModel>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QSplitter>
+#include <QTableView>
+#include <QVBoxLayout>
+
+#include "runDialog.hpp"
+
+namespace {
+
+// maximum number of runs queued at once
+const int maxRuns = 100000;
+
+// maximum number of output lines shown for the selected run
+const int maxLogLines = 10000;
+
+}
+
+
+// constructor
+RunDialog::RunDialog(QWidget* parent) : QDialog(parent) {
+  setWindowTitle(tr("MCell Runs"));
+
+  executableEntry_ = new QLineEdit(runs_.executable(), this);
+  auto exeButton = new QPushButton(tr("Browse..."), this);
+  auto exeLayout = new QHBoxLayout;
+  exeLayout->addWidget(executableEntry_);
+  exeLayout->addWidget(exeButton);
+  mdlEntry_ = new QLineEdit(this);
+  mdlEntry_->setPlaceholderText(tr("MDL file or pattern, e.g. sweep_*.mdl"));
+  auto mdlButton = new QPushButton(tr("Browse..."), this);
+  auto mdlLayout = new QHBoxLayout;
+  mdlLayout->addWidget(mdlEntry_);
+  mdlLayout->addWidget(mdlButton);
+  seedsEntry_ = new QLineEdit("1", this);
+  seedsEntry_->setPlaceholderText(tr("e.g. 1:10, 42"));
+  maxRunningBox_ = new QSpinBox(this);
+  maxRunningBox_->setRange(1, 1024);
+  maxRunningBox_->setValue(runs_.maxRunning());
+
+  auto form = new QFormLayout;
+  form->addRow(tr("MCell executable"), exeLayout);
+  form->addRow(tr("MDL files"), mdlLayout);
+  form->addRow(tr("seeds"), seedsEntry_);
+  form->addRow(tr("concurrent runs"), maxRunningBox_);
+
+  queueButton_ = new QPushButton(tr("Queue Runs"), this);
+  cancelButton_ = new QPushButton(tr("Cancel Selected"), this);
+  clearButton_ = new QPushButton(tr("Clear Finished"), this);
+  auto buttons = new QHBoxLayout;
+  buttons->addStretch();
+  buttons->addWidget(queueButton_);
+  buttons->addWidget(cancelButton_);
+  buttons->addWidget(clearButton_);
+
+  runView_ = new QTableView(this);
+  runView_->setModel(&runs_);
+  runView_->setSelectionBehavior(QAbstractItemView::SelectRows);
+  runView_->horizontalHeader()->setStretchLastSection(true);
+  runView_->verticalHeader()->hide();
+  logView_ = new QPlainTextEdit(this);
+  logView_->setReadOnly(true);
+  logView_->setMaximumBlockCount(maxLogLines);
+  auto splitter = new QSplitter(Qt::Vertical, this);
+  splitter->addWidget(runView_);
+  splitter->addWidget(logView_);
+
+  statusLabel_ = new QLabel(this);
+  auto layout = new QVBoxLayout(this);
+  layout->addLayout(form);
+  layout->addLayout(buttons);
+  layout->addWidget(splitter);
+  layout->addWidget(statusLabel_);
+  resize(700, 600);
+
+  connect(exeButton, SIGNAL(clicked()), this, SLOT(browseExecutable()));
+  connect(mdlButton, SIGNAL(clicked()), this, SLOT(browseMDL()));
+  connect(queueButton_, SIGNAL(clicked()), this, SLOT(queueRuns()));
+  connect(cancelButton_, SIGNAL(clicked()), this, SLOT(cancelSelected()));
+  connect(clearButton_, SIGNAL(clicked()), &runs_, SLOT(clearFinished()));
+  connect(clearButton_, SIGNAL(clicked()), logView_, SLOT(clear()));
+  connect(maxRunningBox_, SIGNAL(valueChanged(int)), &runs_,
+    SLOT(setMaxRunning(int)));
+  connect(runView_->selectionModel(),
+    SIGNAL(currentRowChanged(const QModelIndex&, const QModelIndex&)), this,
+    SLOT(showLog(const QModelIndex&)));
+  connect(&runs_, SIGNAL(output(int, const QString&)), this,
+    SLOT(appendOutput(int, const QString&)));
+  connect(&runs_, SIGNAL(statusChanged()), this, SLOT(updateStatus()));
+  updateStatus();
+}
+
+
+// setMDLFile proposes fileName, e.g. the most recently exported MDL file,
+// for the next runs
+void RunDialog::setMDLFile(const QString& fileName) {
+  mdlEntry_->setText(fileName);
+}
+
+
+// browseExecutable lets the user pick the MCell executable
+void RunDialog::browseExecutable() {
+  QString fileName = QFileDialog::getOpenFileName(this,
+    tr("MCell Executable"), QDir::homePath());
+  if (!fileName.isEmpty()) {
+    executableEntry_->setText(fileName);
+  }
+}
+
+
+// browseMDL lets the user pick the MDL file to run
+void RunDialog::browseMDL() {
+  QString fileName = QFileDialog::getOpenFileName(this, tr("MDL File"),
+    QDir::homePath(), tr("MCell Model Files (*.mdl)"));
+  if (!fileName.isEmpty()) {
+    mdlEntry_->setText(fileName);
+  }
+}
+
+
+// queueRuns queues one run per MDL file and seed
+void RunDialog::queueRuns() {
+  QList<int> seeds;
+  QString error;
+  if (!parseSeeds_(seeds, error)) {
+    statusLabel_->setText(error);
+    return;
+  }
+  QStringList files = mdlFiles_();
+  if (files.isEmpty()) {
+    statusLabel_->setText(tr("no MDL file matches %1").arg(mdlEntry_->text()));
+    return;
+  }
+  if (static_cast<long long>(files.size()) * seeds.size() > maxRuns) {
+    statusLabel_->setText(tr("more than %1 runs").arg(maxRuns));
+    return;
+  }
+  if (executableEntry_->text().trimmed().isEmpty()) {
+    statusLabel_->setText(tr("no MCell executable given"));
+    return;
+  }
+  runs_.setExecutable(executableEntry_->text().trimmed());
+  for (const auto& f : files) {
+    for (auto seed : seeds) {
+      runs_.addRun(f, seed);
+    }
+  }
+}
+
+
+// cancelSelected cancels all selected runs
+void RunDialog::cancelSelected() {
+  for (const auto& index : runView_->selectionModel()->selectedRows()) {
+    runs_.cancel(index.row());
+  }
+}
+
+
+// showLog shows the output of the current run
+void RunDialog::showLog(const QModelIndex& current) {
+  logView_->setPlainText(runs_.log(current.row()));
+}
+
+
+// appendOutput appends new output of a run if it is the current one
+void RunDialog::appendOutput(int row, const QString& text) {
+  if (row != runView_->currentIndex().row()) {
+    return;
+  }
+  logView_->moveCursor(QTextCursor::End);
+  logView_->insertPlainText(text);
+}
+
+
+// updateStatus shows the number of executing and queued runs
+void RunDialog::updateStatus() {
+  statusLabel_->setText(tr("%1 running, %2 queued")
+    .arg(runs_.numRunning()).arg(runs_.numQueued()));
+}
+
+
+// parseSeeds_ parses a comma separated list of seeds and inclusive seed
+// ranges start:stop
+bool RunDialog::parseSeeds_(QList<int>& seeds, QString& error) const {
+  for (const auto& item : seedsEntry_->text().split(',')) {
+    QStringList bounds = item.split(':');
+    bool okStart = false;
+    bool okStop = false;
+    int start = bounds[0].trimmed().toInt(&okStart);
+    int stop = (bounds.size() == 2) ? bounds[1].trimmed().toInt(&okStop) :
+      start;
+    if (!okStart || (bounds.size() == 2 && !okStop) || bounds.size() > 2 ||
+      stop < start) {
+      error = tr("invalid seeds %1").arg(item.trimmed());
+      return false;
+    }
+    if (static_cast<long long>(stop) - start >= maxRuns) {
+      error = tr("more than %1 runs").arg(maxRuns);
+      return false;
+    }
+    // the counter is wider than the seeds so stop == INT_MAX terminates
+    for (long long s = start; s <= stop; ++s) {
+      seeds << static_cast<int>(s);
+    }
+  }
+  return true;
+}
+
+
+// mdlFiles_ returns the MDL files to run. File names containing wildcards
+// select all matching files, e.g. the variants of a parameter sweep.
+QStringList RunDialog::mdlFiles_() const {
+  QFileInfo info(mdlEntry_->text().trimmed());
+  QStringList files;
+  if (info.fileName().contains('*') || info.fileName().contains('?')) {
+    QDir dir = info.absoluteDir();
+    for (const auto& f : dir.entryList(QStringList() << info.fileName(),
+      QDir::Files, QDir::Name)) {
+      files << dir.absoluteFilePath(f);
+    }
+  } else if (info.isFile()) {
+    files << info.absoluteFilePath();
+  }
+  return files;
+}
@@ -0,0 +1,67 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef RUN_DIALOG_HPP
+#define RUN_DIALOG_HPP
+
+#include <QDialog>
+#include <QList>
+#include <QModelIndex>
+
+#include "runManager.hpp"
+
+class QLabel;
+class QLineEdit;
+class QPlainTextEdit;
+class QPushButton;
+class QSpinBox;
+class QTableView;
+
+
+// RunDialog queues MCell runs of exported MDL files for a range of seeds
+// and shows the status and output of the runs
+class RunDialog : public QDialog {
+
+  Q_OBJECT
+
+public:
+
+  RunDialog(QWidget* parent = 0);
+
+  void setMDLFile(const QString& fileName);
+
+
+private slots:
+
+  void browseExecutable();
+  void browseMDL();
+  void queueRuns();
+  void cancelSelected();
+  void showLog(const QModelIndex& current);
+  void appendOutput(int row, const QString& text);
+  void updateStatus();
+
+
+private:
+
+  bool parseSeeds_(QList<int>& seeds, QString& error) const;
+  QStringList mdlFiles_() const;
+
+  RunManager runs_;
+
+  QLineEdit* executableEntry_;
+  QLineEdit* mdlEntry_;
+  QLineEdit* seedsEntry_;
+  QSpinBox* maxRunningBox_;
+  QPushButton* queueButton_;
+  QPushButton* cancelButton_;
+  QPushButton* clearButton_;
+  QTableView* runView_;
+  QPlainTextEdit* logView_;
+  QLabel* statusLabel_;
+};
+
+#endif
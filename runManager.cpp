@@ -0,0 +1,376 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+
+#include <QColor>
+#include <QFileInfo>
+#include <QThread>
+
+#include "runManager.hpp"
+#include "trace.hpp"
+
+namespace {
+
+// maximum number of characters of output kept per run
+const int maxLogSize = 1 << 20;
+
+// number of characters a log may exceed maxLogSize by before it is trimmed
+const int logSlack = maxLogSize / 4;
+
+// interval in ms at which the wall times of running jobs are refreshed
+const int wallTimeInterval = 1000;
+
+// statusName returns the name shown for a run status
+QString statusName(RunStatus status) {
+  switch (status) {
+    case RunStatus::Queued:
+      return QObject::tr("queued");
+    case RunStatus::Running:
+      return QObject::tr("running");
+    case RunStatus::Finished:
+      return QObject::tr("finished");
+    case RunStatus::Failed:
+      return QObject::tr("failed");
+    case RunStatus::Canceled:
+      return QObject::tr("canceled");
+  }
+  return QString();
+}
+
+}
+
+
+// constructor. By default as many runs as cores are executed at a time.
+RunManager::RunManager(QObject* parent) : QAbstractTableModel(parent),
+  maxRunning_(std::max(1, QThread::idealThreadCount())) {
+  wallTimer_.setInterval(wallTimeInterval);
+  connect(&wallTimer_, SIGNAL(timeout()), this, SLOT(updateWallTimes_()));
+}
+
+
+// destructor kills all runs which are still executing
+RunManager::~RunManager() {
+  for (auto& job : jobs_) {
+    if (job.process != nullptr) {
+      job.process->disconnect(this);
+      job.process->kill();
+      job.process->waitForFinished();
+    }
+  }
+}
+
+
+// rowCount returns the number of runs
+int RunManager::rowCount(const QModelIndex& parent) const {
+  Q_UNUSED(parent)
+  return jobs_.size();
+}
+
+
+// columnCount returns the number of columns
+int RunManager::columnCount(const QModelIndex& parent) const {
+  Q_UNUSED(parent)
+  return headerLabels_.size();
+}
+
+
+// data returns the data for the given index
+QVariant RunManager::data(const QModelIndex& index, int role) const {
+  if (!index.isValid() || index.row() >= static_cast<int>(jobs_.size())) {
+    return QVariant();
+  }
+  const RunJob& job = jobs_[index.row()];
+  if (role == Qt::ForegroundRole && index.column() == RunCol::Status &&
+    job.status == RunStatus::Failed) {
+    return QColor(Qt::red);
+  }
+  if (role != Qt::DisplayRole) {
+    return QVariant();
+  }
+  switch (index.column()) {
+    case RunCol::ID:
+      return job.id;
+    case RunCol::File:
+      return QFileInfo(job.mdlFile).fileName();
+    case RunCol::Seed:
+      return job.seed;
+    case RunCol::Status:
+      return statusName(job.status);
+    case RunCol::ExitCode:
+      return (job.status == RunStatus::Finished ||
+        job.status == RunStatus::Failed) ? QVariant(job.exitCode) : QVariant();
+    case RunCol::WallTime:
+      if (job.status == RunStatus::Running) {
+        return job.timer.elapsed() / 1000;
+      } else if (job.status != RunStatus::Queued && job.wallTime >= 0) {
+        return QString::number(job.wallTime / 1000.0, 'f', 1);
+      }
+      return QVariant();
+  }
+  return QVariant();
+}
+
+
+// headerData returns the column names
+QVariant RunManager::headerData(int section, Qt::Orientation orientation,
+  int role) const {
+  if (role != Qt::DisplayRole) {
+    return QVariant();
+  }
+  if (orientation == Qt::Horizontal) {
+    return headerLabels_[section];
+  }
+  return section + 1;
+}
+
+
+// setExecutable sets the MCell executable used for subsequently started
+// runs. Executables without a path are looked up in PATH.
+void RunManager::setExecutable(const QString& executable) {
+  executable_ = executable;
+}
+
+
+// executable returns the MCell executable
+const QString& RunManager::executable() const {
+  return executable_;
+}
+
+
+// setMaxRunning sets the maximum number of concurrent runs and starts
+// queued runs if the limit was raised
+void RunManager::setMaxRunning(int maxRunning) {
+  maxRunning_ = std::max(1, maxRunning);
+  startNext_();
+}
+
+
+// maxRunning returns the maximum number of concurrent runs
+int RunManager::maxRunning() const {
+  return maxRunning_;
+}
+
+
+// addRun queues a run of mdlFile with the given seed and returns its id
+int RunManager::addRun(const QString& mdlFile, int seed) {
+  int row = jobs_.size();
+  beginInsertRows(QModelIndex(), row, row);
+  RunJob job;
+  job.id = nextID_++;
+  job.mdlFile = mdlFile;
+  job.seed = seed;
+  job.status = RunStatus::Queued;
+  job.exitCode = 0;
+  job.wallTime = -1;
+  job.process = nullptr;
+  job.canceled = false;
+  jobs_.push_back(job);
+  endInsertRows();
+  startNext_();
+  emit statusChanged();
+  return job.id;
+}
+
+
+// log returns the output of the run in row
+const QString& RunManager::log(int row) const {
+  static const QString empty;
+  if (row < 0 || row >= static_cast<int>(jobs_.size())) {
+    return empty;
+  }
+  return jobs_[row].log;
+}
+
+
+// numRunning returns the number of currently executing runs
+int RunManager::numRunning() const {
+  return numRunning_;
+}
+
+
+// numQueued returns the number of runs waiting to be started
+int RunManager::numQueued() const {
+  return std::count_if(jobs_.begin(), jobs_.end(),
+    [](const RunJob& job) { return job.status == RunStatus::Queued; });
+}
+
+
+// cancel cancels a queued run or kills an executing one
+void RunManager::cancel(int row) {
+  if (row < 0 || row >= static_cast<int>(jobs_.size())) {
+    return;
+  }
+  RunJob& job = jobs_[row];
+  if (job.status == RunStatus::Queued) {
+    finish_(row, RunStatus::Canceled, 0);
+  } else if (job.status == RunStatus::Running) {
+    job.canceled = true;
+    job.process->kill();
+  }
+}
+
+
+// cancelAll cancels all queued and executing runs
+void RunManager::cancelAll() {
+  for (size_t row = 0; row < jobs_.size(); ++row) {
+    cancel(row);
+  }
+}
+
+
+// clearFinished removes all runs which are no longer queued or executing
+void RunManager::clearFinished() {
+  beginResetModel();
+  jobs_.erase(std::remove_if(jobs_.begin(), jobs_.end(),
+    [](const RunJob& job) {
+      return job.status != RunStatus::Queued &&
+        job.status != RunStatus::Running;
+    }), jobs_.end());
+  endResetModel();
+  emit statusChanged();
+}
+
+
+// startNext_ starts queued runs in order until maxRunning runs execute.
+// Runs execute in the directory of their MDL file and output of stdout and
+// stderr is merged.
+void RunManager::startNext_() {
+  for (size_t row = 0; row < jobs_.size() && numRunning_ < maxRunning_;
+    ++row) {
+    RunJob& job = jobs_[row];
+    if (job.status != RunStatus::Queued) {
+      continue;
+    }
+    TRACE_SCOPE("RunManager::startNext", "io");
+    job.process = new QProcess(this);
+    job.process->setProperty("runID", job.id);
+    job.process->setProcessChannelMode(QProcess::MergedChannels);
+    job.process->setWorkingDirectory(QFileInfo(job.mdlFile).absolutePath());
+    connect(job.process, SIGNAL(readyReadStandardOutput()), this,
+      SLOT(readOutput_()));
+    connect(job.process, SIGNAL(finished(int, QProcess::ExitStatus)), this,
+      SLOT(processFinished_(int, QProcess::ExitStatus)));
+    connect(job.process, SIGNAL(errorOccurred(QProcess::ProcessError)), this,
+      SLOT(processError_(QProcess::ProcessError)));
+    job.status = RunStatus::Running;
+    job.timer.start();
+    ++numRunning_;
+    job.process->start(executable_, QStringList() << "-seed"
+      << QString::number(job.seed) << job.mdlFile);
+    emit dataChanged(index(row, 0), index(row, headerLabels_.size() - 1));
+  }
+  if (numRunning_ > 0 && !wallTimer_.isActive()) {
+    wallTimer_.start();
+  }
+}
+
+
+// finish_ records the end of the run in row and schedules the start of the
+// next queued run
+void RunManager::finish_(int row, RunStatus status, int exitCode) {
+  RunJob& job = jobs_[row];
+  if (job.status == RunStatus::Running) {
+    job.wallTime = job.timer.elapsed();
+    job.process->deleteLater();
+    job.process = nullptr;
+    --numRunning_;
+  }
+  job.status = status;
+  job.exitCode = exitCode;
+  emit dataChanged(index(row, 0), index(row, headerLabels_.size() - 1));
+  if (numRunning_ == 0) {
+    wallTimer_.stop();
+  }
+  // runs may fail while being started, so queued runs are started from the
+  // event loop instead of recursively
+  QMetaObject::invokeMethod(this, "startNext_", Qt::QueuedConnection);
+  emit statusChanged();
+}
+
+
+// rowOf_ returns the row of the run executed by process or -1. Rows are
+// ordered by id.
+int RunManager::rowOf_(QObject* process) const {
+  if (process == nullptr) {
+    return -1;
+  }
+  int id = process->property("runID").toInt();
+  auto it = std::lower_bound(jobs_.begin(), jobs_.end(), id,
+    [](const RunJob& job, int id) { return job.id < id; });
+  if (it == jobs_.end() || it->id != id || it->process != process) {
+    return -1;
+  }
+  return it - jobs_.begin();
+}
+
+
+// appendLog_ adds output to the log of the run in row. Only the most recent
+// maxLogSize characters are kept. Logs are trimmed only once they exceed
+// the limit by logSlack so the front is not removed on every read.
+void RunManager::appendLog_(int row, const QString& text) {
+  QString& log = jobs_[row].log;
+  log += text;
+  if (log.size() > maxLogSize + logSlack) {
+    log.remove(0, log.size() - maxLogSize);
+  }
+  emit output(row, text);
+}
+
+
+// readOutput_ collects the available output of a run
+void RunManager::readOutput_() {
+  auto process = qobject_cast<QProcess*>(sender());
+  int row = rowOf_(process);
+  if (row < 0) {
+    return;
+  }
+  appendLog_(row, QString::fromLocal8Bit(process->readAllStandardOutput()));
+}
+
+
+// processFinished_ records the exit code of a run. Runs fail if they crash
+// or exit with a non-zero code.
+void RunManager::processFinished_(int exitCode,
+  QProcess::ExitStatus exitStatus) {
+  auto process = qobject_cast<QProcess*>(sender());
+  int row = rowOf_(process);
+  if (row < 0) {
+    return;
+  }
+  appendLog_(row, QString::fromLocal8Bit(process->readAllStandardOutput()));
+  RunStatus status = RunStatus::Finished;
+  if (jobs_[row].canceled) {
+    status = RunStatus::Canceled;
+  } else if (exitStatus != QProcess::NormalExit || exitCode != 0) {
+    status = RunStatus::Failed;
+  }
+  finish_(row, status, exitCode);
+}
+
+
+// processError_ fails runs whose executable could not be started. All other
+// errors are followed by finished.
+void RunManager::processError_(QProcess::ProcessError error) {
+  auto process = qobject_cast<QProcess*>(sender());
+  int row = rowOf_(process);
+  if (row < 0 || error != QProcess::FailedToStart) {
+    return;
+  }
+  appendLog_(row, tr("could not start %1: %2\n").arg(executable_)
+    .arg(process->errorString()));
+  finish_(row, RunStatus::Failed, -1);
+}
+
+
+// updateWallTimes_ refreshes the wall time column of all rows
+void RunManager::updateWallTimes_() {
+  if (jobs_.empty()) {
+    return;
+  }
+  emit dataChanged(index(0, RunCol::WallTime),
+    index(jobs_.size() - 1, RunCol::WallTime));
+}
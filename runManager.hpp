@@ -0,0 +1,114 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef RUN_MANAGER_HPP
+#define RUN_MANAGER_HPP
+
+#include <vector>
+
+#include <QAbstractTableModel>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QString>
+#include <QTimer>
+
+
+// RunStatus is the state of a single MCell run
+enum class RunStatus {Queued, Running, Finished, Failed, Canceled};
+
+
+// RunJob is a single MCell run of an MDL file with a given seed. wallTime
+// is the run time in ms once the run has ended. log holds the most recent
+// output of the run.
+struct RunJob {
+  int id;
+  QString mdlFile;
+  int seed;
+  RunStatus status;
+  int exitCode;
+  qint64 wallTime;
+  QElapsedTimer timer;
+  QProcess* process;
+  bool canceled;
+  QString log;
+};
+
+
+// RunCol names the columns of the RunManager
+namespace RunCol {
+  enum col {ID, File, Seed, Status, ExitCode, WallTime};
+}
+
+
+// RunManager queues MCell runs and executes them as child processes with at
+// most maxRunning runs at a time. Process output is collected via signals
+// so the GUI never blocks on a run. As a table model it shows one row per
+// run with its status, exit code and wall time.
+class RunManager : public QAbstractTableModel {
+
+  Q_OBJECT
+
+public:
+
+  RunManager(QObject* parent = 0);
+  ~RunManager();
+
+  int rowCount(const QModelIndex& parent = QModelIndex()) const;
+  int columnCount(const QModelIndex& parent = QModelIndex()) const;
+  QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+  QVariant headerData(int section, Qt::Orientation orientation, int role)
+    const;
+
+  void setExecutable(const QString& executable);
+  const QString& executable() const;
+  int maxRunning() const;
+  int addRun(const QString& mdlFile, int seed);
+  const QString& log(int row) const;
+  int numRunning() const;
+  int numQueued() const;
+
+
+public slots:
+
+  void setMaxRunning(int maxRunning);
+  void cancel(int row);
+  void cancelAll();
+  void clearFinished();
+
+
+signals:
+
+  void output(int row, const QString& text);
+  void statusChanged();
+
+
+private slots:
+
+  void readOutput_();
+  void processFinished_(int exitCode, QProcess::ExitStatus exitStatus);
+  void processError_(QProcess::ProcessError error);
+  void updateWallTimes_();
+  void startNext_();
+
+
+private:
+
+  void finish_(int row, RunStatus status, int exitCode);
+  int rowOf_(QObject* process) const;
+  void appendLog_(int row, const QString& text);
+
+  QString executable_ = "mcell";
+  int maxRunning_;
+  int numRunning_ = 0;
+  int nextID_ = 0;
+  std::vector<RunJob> jobs_;
+  QTimer wallTimer_;
+
+  std::vector<QString> headerLabels_ = {"id", "MDL file", "seed", "status",
+    "exit code", "wall time [s]"};
+};
+
+#endif
@@ -0,0 +1,585 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <QHash>
+#include <QIODevice>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+#include <QXmlStreamReader>
+
+#include "molModel.hpp"
+#include "reactionModel.hpp"
+#include "reactionNetwork.hpp"
+#include "sbmlImport.hpp"
+#include "symbolModel.hpp"
+#include "trace.hpp"
+
+namespace {
+
+// number of reactions collected before they are added to the model
+const size_t batchSize = 4096;
+
+// maximum nesting depth of the MathML of a kinetic law. Mass action laws
+// are shallow; the limit keeps malicious files from exhausting the stack.
+const int maxMathDepth = 64;
+
+
+// MathNode is a MathML element of a kinetic law: either an operator
+// application (op names the operator, e.g. "times", args holds the
+// operands), an identifier (op "ci") or a number (op "cn"). Other elements
+// only record their name.
+struct MathNode {
+  QString op;
+  QString text;
+  std::vector<MathNode> args;
+};
+
+
+// collectFactors flattens nested products into their factors
+void collectFactors(const MathNode& node,
+  std::vector<const MathNode*>& factors) {
+  if (node.op == "times") {
+    for (const auto& a : node.args) {
+      collectFactors(a, factors);
+    }
+  } else {
+    factors.push_back(&node);
+  }
+}
+
+
+// removeSpecies removes count copies of species from reactants. This
+// function returns false if reactants contains fewer copies.
+bool removeSpecies(const QString& species, int count,
+  std::vector<QString>& reactants) {
+  for (int i = 0; i < count; ++i) {
+    auto it = std::find(reactants.begin(), reactants.end(), species);
+    if (it == reactants.end()) {
+      return false;
+    }
+    reactants.erase(it);
+  }
+  return true;
+}
+
+
+// massActionRate extracts the rate constant from a mass action term, i.e. a
+// product of all reactants (with their multiplicity), compartment sizes and
+// constants. Local parameters are replaced by their values, global ones
+// refer to the symbols of the same name and compartment sizes are dropped.
+// This function returns false and describes the problem otherwise.
+bool massActionRate(const MathNode& term, std::vector<QString> reactants,
+  const QHash<QString, QString>& localParams, const QSet<QString>& species,
+  const QSet<QString>& compartments, QString& rate, QString& problem) {
+  std::vector<const MathNode*> factors;
+  collectFactors(term, factors);
+  QStringList constants;
+  for (auto f : factors) {
+    if (f->op == "cn") {
+      constants << f->text;
+    } else if (f->op == "ci" && species.contains(f->text)) {
+      if (!removeSpecies(f->text, 1, reactants)) {
+        problem = QObject::tr("kinetic law depends on %1 which is not a "
+          "reactant").arg(f->text);
+        return false;
+      }
+    } else if (f->op == "ci" && compartments.contains(f->text)) {
+      continue;
+    } else if (f->op == "ci") {
+      constants << localParams.value(f->text, f->text);
+    } else if (f->op == "power" && f->args.size() == 2 &&
+      f->args[0].op == "ci" && f->args[1].op == "cn") {
+      bool ok = false;
+      int n = f->args[1].text.toInt(&ok);
+      if (!ok || n < 1 || !removeSpecies(f->args[0].text, n, reactants)) {
+        problem = QObject::tr("kinetic law is not mass action");
+        return false;
+      }
+    } else {
+      problem = QObject::tr("kinetic law is not mass action");
+      return false;
+    }
+  }
+  if (!reactants.empty()) {
+    problem = QObject::tr("kinetic law does not depend on %1")
+      .arg(reactants.front());
+    return false;
+  }
+  rate = constants.isEmpty() ? QString("1") : constants.join("*");
+  return true;
+}
+
+
+// SbmlReader streams an SBML file into the molecule and reaction models.
+// Species become molecules and mass action reactions are added in batches
+// so that only the current batch of reactions is held in memory.
+class SbmlReader {
+
+public:
+
+  SbmlReader(QIODevice* device, MolModel* molModel,
+    ReactTreeModel* reactModel, SbmlImport& result);
+
+  void read();
+
+
+private:
+
+  void readModel_();
+  void readCompartments_();
+  void readSpecies_();
+  void readParameters_();
+  void readReactions_();
+  void readReaction_();
+  void readSpeciesRefs_(std::vector<QString>& species, QString& problem);
+  bool readKineticLaw_(MathNode& law, QHash<QString, QString>& localParams,
+    QString& problem);
+  bool readMath_(MathNode& node, int depth);
+  QString readNumber_();
+  void skipUnsupported_(const QString& what);
+  void warn_(const QString& message);
+  void flushMols_();
+  void flushReactions_();
+
+  QXmlStreamReader xml_;
+  MolModel* molModel_;
+  ReactTreeModel* reactModel_;
+  SbmlImport& result_;
+
+  QHash<QString, int> compartmentDims_;
+  QSet<QString> compartments_;
+  QSet<QString> species_;
+  QHash<QString, MolHandle> speciesHandles_;
+  std::vector<MolSpec> mols_;
+  std::vector<ReactionSpec> reactions_;
+  QMap<QString, int> unsupported_;
+};
+
+
+// constructor
+SbmlReader::SbmlReader(QIODevice* device, MolModel* molModel,
+  ReactTreeModel* reactModel, SbmlImport& result) :
+  xml_(device), molModel_(molModel), reactModel_(reactModel),
+  result_(result) {}
+
+
+// read reads the complete document. Unsupported elements are summarized at
+// the end, one message per kind of element.
+void SbmlReader::read() {
+  if (xml_.readNextStartElement()) {
+    if (xml_.name() != "sbml") {
+      xml_.raiseError(QObject::tr("not an SBML file"));
+    }
+    while (xml_.readNextStartElement()) {
+      if (xml_.name() == "model") {
+        readModel_();
+      } else {
+        xml_.skipCurrentElement();
+      }
+    }
+  }
+  flushMols_();
+  flushReactions_();
+  if (xml_.hasError()) {
+    result_.error = QObject::tr("line %1: %2").arg(xml_.lineNumber())
+      .arg(xml_.errorString());
+  }
+  for (auto it = unsupported_.begin(); it != unsupported_.end(); ++it) {
+    if (result_.numErrors++ < ImportStatus::maxErrors) {
+      result_.errors << QObject::tr("skipped %1 unsupported <%2> elements")
+        .arg(it.value()).arg(it.key());
+    }
+  }
+}
+
+
+// readModel_ reads the lists of a model. Function and unit definitions,
+// rules, initial assignments, constraints and events have no MCell
+// equivalent and are skipped.
+void SbmlReader::readModel_() {
+  while (xml_.readNextStartElement()) {
+    if (xml_.name() == "listOfCompartments") {
+      readCompartments_();
+    } else if (xml_.name() == "listOfSpecies") {
+      readSpecies_();
+    } else if (xml_.name() == "listOfParameters") {
+      readParameters_();
+    } else if (xml_.name() == "listOfReactions") {
+      readReactions_();
+    } else if (xml_.name() == "notes" || xml_.name() == "annotation") {
+      xml_.skipCurrentElement();
+    } else if (xml_.name().startsWith("listOf")) {
+      while (xml_.readNextStartElement()) {
+        skipUnsupported_(xml_.name().toString());
+      }
+    } else {
+      skipUnsupported_(xml_.name().toString());
+    }
+  }
+}
+
+
+// readCompartments_ records the compartment ids and their dimensions which
+// decide if the species inside are surface or volume molecules
+void SbmlReader::readCompartments_() {
+  while (xml_.readNextStartElement()) {
+    if (xml_.name() == "compartment") {
+      QXmlStreamAttributes attrs = xml_.attributes();
+      QString id = attrs.value("id").toString();
+      QStringRef dims = attrs.value("spatialDimensions");
+      compartments_.insert(id);
+      compartmentDims_[id] = dims.isEmpty() ? 3 :
+        static_cast<int>(dims.toDouble());
+    }
+    xml_.skipCurrentElement();
+  }
+}
+
+
+// readSpecies_ collects the species as molecules. Their ids are used as
+// molecule names since SBML names need not be unique. Diffusion constants
+// are not part of SBML and are set to 0. Initial amounts are ignored.
+void SbmlReader::readSpecies_() {
+  while (xml_.readNextStartElement()) {
+    if (xml_.name() != "species") {
+      skipUnsupported_(xml_.name().toString());
+      continue;
+    }
+    ++result_.numSpecies;
+    QXmlStreamAttributes attrs = xml_.attributes();
+    QString id = attrs.value("id").toString();
+    QString compartment = attrs.value("compartment").toString();
+    xml_.skipCurrentElement();
+    if (id.isEmpty() || species_.contains(id)) {
+      warn_(QObject::tr("species without id or with duplicate id '%1'")
+        .arg(id));
+      continue;
+    }
+    species_.insert(id);
+    if (attrs.value("boundaryCondition") == "true") {
+      warn_(QObject::tr("boundary condition of species %1 is ignored")
+        .arg(id));
+    }
+    if (molModel_->haveMol(id)) {
+      warn_(QObject::tr("species %1 uses the existing molecule").arg(id));
+      continue;
+    }
+    MolType type = (compartmentDims_.value(compartment, 3) == 2) ?
+      MolType::SURF : MolType::VOL;
+    mols_.push_back(MolSpec{id, "0.0", type});
+  }
+  flushMols_();
+}
+
+
+// readParameters_ adds global parameters with a value as symbols so that
+// rates can refer to them
+void SbmlReader::readParameters_() {
+  while (xml_.readNextStartElement()) {
+    if (xml_.name() != "parameter") {
+      skipUnsupported_(xml_.name().toString());
+      continue;
+    }
+    QString id = xml_.attributes().value("id").toString();
+    QString value = xml_.attributes().value("value").toString();
+    xml_.skipCurrentElement();
+    QString error;
+    if (value.isEmpty()) {
+      warn_(QObject::tr("parameter %1 has no value").arg(id));
+    } else if (!molModel_->symbols()->addSymbol(id, value, &error)) {
+      warn_(QObject::tr("parameter %1: %2").arg(id).arg(error));
+    }
+  }
+}
+
+
+// readReactions_ reads all reactions and adds them in batches
+void SbmlReader::readReactions_() {
+  flushMols_();
+  while (xml_.readNextStartElement()) {
+    if (xml_.name() == "reaction") {
+      readReaction_();
+    } else {
+      skipUnsupported_(xml_.name().toString());
+    }
+    if (reactions_.size() >= batchSize) {
+      flushReactions_();
+    }
+  }
+}
+
+
+// readReaction_ converts a single reaction. Modifiers take part on both
+// sides of the reaction. A kinetic law of the form forward - reverse yields
+// a reverse reaction as well. Reactions which can not be expressed in MCell
+// are skipped with a warning.
+void SbmlReader::readReaction_() {
+  ++result_.numRows;
+  QXmlStreamAttributes attrs = xml_.attributes();
+  QString id = attrs.value("id").toString();
+  if (attrs.value("fast") == "true") {
+    warn_(QObject::tr("reaction %1: fast attribute is ignored").arg(id));
+  }
+
+  std::vector<QString> reactants;
+  std::vector<QString> products;
+  std::vector<QString> modifiers;
+  QHash<QString, QString> localParams;
+  MathNode law;
+  bool haveLaw = false;
+  QString problem;
+  while (xml_.readNextStartElement()) {
+    if (xml_.name() == "listOfReactants") {
+      readSpeciesRefs_(reactants, problem);
+    } else if (xml_.name() == "listOfProducts") {
+      readSpeciesRefs_(products, problem);
+    } else if (xml_.name() == "listOfModifiers") {
+      readSpeciesRefs_(modifiers, problem);
+    } else if (xml_.name() == "kineticLaw") {
+      haveLaw = readKineticLaw_(law, localParams, problem);
+    } else {
+      xml_.skipCurrentElement();
+    }
+  }
+  reactants.insert(reactants.end(), modifiers.begin(), modifiers.end());
+  products.insert(products.end(), modifiers.begin(), modifiers.end());
+
+  if (problem.isEmpty() && !haveLaw) {
+    problem = QObject::tr("missing or unsupported kinetic law");
+  }
+  if (problem.isEmpty() && (reactants.empty() ||
+    reactants.size() > size_t(ReactionNetwork::maxReactants))) {
+    problem = QObject::tr("%1 reactants").arg(reactants.size());
+  }
+
+  // a difference of two mass action terms describes a reversible reaction
+  // which is added as a forward and a reverse reaction
+  bool reversible = law.op == "minus" && law.args.size() == 2;
+  if (reversible) {
+    ++result_.numRows;
+  }
+  const MathNode& forward = reversible ? law.args[0] : law;
+  QString rate;
+  QString reverseRate;
+  if (problem.isEmpty()) {
+    massActionRate(forward, reactants, localParams, species_, compartments_,
+      rate, problem);
+  }
+  if (problem.isEmpty() && reversible) {
+    if (products.empty() ||
+      products.size() > size_t(ReactionNetwork::maxReactants)) {
+      problem = QObject::tr("%1 reactants of reverse reaction")
+        .arg(products.size());
+    } else {
+      massActionRate(law.args[1], products, localParams, species_,
+        compartments_, reverseRate, problem);
+    }
+  }
+  if (!problem.isEmpty()) {
+    warn_(QObject::tr("reaction %1: %2").arg(id).arg(problem));
+    return;
+  }
+
+  auto handles = [this](const std::vector<QString>& ids) {
+    std::vector<MolHandle> mols;
+    for (const auto& s : ids) {
+      mols.push_back(speciesHandles_.value(s));
+    }
+    if (mols.empty()) {
+      mols.push_back(MolHandle());
+    }
+    return mols;
+  };
+  reactions_.push_back(ReactionSpec{handles(reactants), handles(products),
+    rate.toStdString(), id.toStdString()});
+  if (reversible) {
+    reactions_.push_back(ReactionSpec{handles(products), handles(reactants),
+      reverseRate.toStdString(), (id + "_rev").toStdString()});
+  }
+}
+
+
+// readSpeciesRefs_ reads a list of species references. Species are repeated
+// according to their stoichiometry which therefore has to be a small
+// positive integer. The first problem encountered is stored in problem.
+void SbmlReader::readSpeciesRefs_(std::vector<QString>& species,
+  QString& problem) {
+  while (xml_.readNextStartElement()) {
+    QXmlStreamAttributes attrs = xml_.attributes();
+    QString id = attrs.value("species").toString();
+    QStringRef stoich = attrs.value("stoichiometry");
+    double count = stoich.isEmpty() ? 1.0 : stoich.toDouble();
+    bool hasStoichMath = false;
+    while (xml_.readNextStartElement()) {
+      hasStoichMath = hasStoichMath || xml_.name() == "stoichiometryMath";
+      xml_.skipCurrentElement();
+    }
+    if (!problem.isEmpty()) {
+      continue;
+    }
+    if (!speciesHandles_.contains(id)) {
+      problem = QObject::tr("unknown species %1").arg(id);
+    } else if (hasStoichMath || count < 1.0 ||
+      count > ReactionNetwork::maxReactants ||
+      count != std::floor(count)) {
+      problem = QObject::tr("unsupported stoichiometry of %1").arg(id);
+    } else {
+      species.insert(species.end(), static_cast<size_t>(count), id);
+    }
+  }
+}
+
+
+// readKineticLaw_ reads the math and the local parameters of a kinetic law.
+// Local parameters are stored by id with their value. Math nested too deeply
+// is reported in problem unless it already describes a problem.
+bool SbmlReader::readKineticLaw_(MathNode& law,
+  QHash<QString, QString>& localParams, QString& problem) {
+  bool haveMath = false;
+  while (xml_.readNextStartElement()) {
+    if (xml_.name() == "math") {
+      if (xml_.readNextStartElement()) {
+        if (!readMath_(law, 0) && problem.isEmpty()) {
+          problem = QObject::tr("kinetic law is nested more than %1 levels "
+            "deep").arg(maxMathDepth);
+        }
+        haveMath = true;
+        xml_.skipCurrentElement();
+      }
+    } else if (xml_.name() == "listOfParameters" ||
+      xml_.name() == "listOfLocalParameters") {
+      while (xml_.readNextStartElement()) {
+        QString id = xml_.attributes().value("id").toString();
+        localParams[id] = xml_.attributes().value("value").toString();
+        xml_.skipCurrentElement();
+      }
+    } else {
+      xml_.skipCurrentElement();
+    }
+  }
+  return haveMath;
+}
+
+
+// readMath_ reads the MathML element at the current position into node.
+// depth is the nesting depth of the element. Elements nested deeper than
+// maxMathDepth are skipped, in which case this function returns false.
+bool SbmlReader::readMath_(MathNode& node, int depth) {
+  if (depth > maxMathDepth) {
+    xml_.skipCurrentElement();
+    return false;
+  }
+  if (xml_.name() == "apply") {
+    if (!xml_.readNextStartElement()) {
+      return true;
+    }
+    node.op = xml_.name().toString();
+    xml_.skipCurrentElement();
+    bool ok = true;
+    while (xml_.readNextStartElement()) {
+      node.args.emplace_back();
+      ok = readMath_(node.args.back(), depth + 1) && ok;
+    }
+    return ok;
+  } else if (xml_.name() == "ci") {
+    node.op = "ci";
+    node.text = xml_.readElementText().trimmed();
+  } else if (xml_.name() == "cn") {
+    node.op = "cn";
+    node.text = readNumber_();
+  } else {
+    node.op = xml_.name().toString();
+    xml_.skipCurrentElement();
+  }
+  return true;
+}
+
+
+// readNumber_ reads a MathML number. Numbers in e-notation separate the
+// mantissa and the exponent by a sep element. Rational numbers are given
+// as fractions.
+QString SbmlReader::readNumber_() {
+  QString sep = (xml_.attributes().value("type") == "rational") ? "/" : "e";
+  QString text;
+  while (!xml_.atEnd()) {
+    xml_.readNext();
+    if (xml_.isCharacters()) {
+      text += xml_.text().trimmed();
+    } else if (xml_.isStartElement()) {
+      text += sep;
+      xml_.skipCurrentElement();
+    } else if (xml_.isEndElement()) {
+      break;
+    }
+  }
+  return (sep == "/") ? "(" + text + ")" : text;
+}
+
+
+// skipUnsupported_ skips the current element and counts it for the
+// summary of unsupported constructs
+void SbmlReader::skipUnsupported_(const QString& what) {
+  ++unsupported_[what];
+  xml_.skipCurrentElement();
+}
+
+
+// warn_ records a problem at the current line
+void SbmlReader::warn_(const QString& message) {
+  if (result_.numErrors++ < ImportStatus::maxErrors) {
+    result_.errors << QObject::tr("line %1: %2").arg(xml_.lineNumber())
+      .arg(message);
+  }
+}
+
+
+// flushMols_ adds the collected species to the molecule model in one bulk
+// insertion and resolves the handles of all species
+void SbmlReader::flushMols_() {
+  if (!mols_.empty()) {
+    result_.numMols += molModel_->addMols(mols_);
+    mols_.clear();
+  }
+  for (const auto& id : species_) {
+    if (!speciesHandles_.contains(id)) {
+      const Molecule* mol = molModel_->getMolecule(id);
+      if (mol != nullptr) {
+        speciesHandles_[id] = mol->handle;
+      }
+    }
+  }
+}
+
+
+// flushReactions_ adds the current batch of reactions to the reaction model
+void SbmlReader::flushReactions_() {
+  if (reactions_.empty()) {
+    return;
+  }
+  result_.numReactions += reactModel_->addReactions(reactions_, false);
+  reactions_.clear();
+}
+
+}
+
+
+// importSBML reads the species and mass action reactions of an SBML model
+// from device with a streaming parser and adds them to the models. Global
+// parameters become symbols. Reactions are added in batches so that large
+// networks are imported in bounded memory.
+SbmlImport importSBML(QIODevice* device, MolModel* molModel,
+  ReactTreeModel* reactModel) {
+  TRACE_SCOPE("importSBML", "io");
+  SbmlImport result;
+  SbmlReader reader(device, molModel, reactModel, result);
+  reader.read();
+  return result;
+}
@@ -0,0 +1,35 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef SBML_IMPORT_HPP
+#define SBML_IMPORT_HPP
+
+#include <QString>
+
+#include "tableImport.hpp"
+
+class MolModel;
+class QIODevice;
+class ReactTreeModel;
+
+
+// SbmlImport summarizes an SBML import. numRows counts the reactions of the
+// file, reversible reactions twice since they become a forward and a
+// reverse reaction. Unsupported constructs are skipped and reported in
+// errors; error is set if the file is not well formed SBML, in which case
+// everything read up to the problem has been added.
+struct SbmlImport : ImportStatus {
+  int numSpecies = 0;
+  int numMols = 0;
+  int numReactions = 0;
+  QString error;
+};
+
+
+SbmlImport importSBML(QIODevice* device, MolModel* molModel,
+  ReactTreeModel* reactModel);
+
+#endif
@@ -0,0 +1,101 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <map>
+
+#include <QHeaderView>
+
+#include "molModel.hpp"
+#include "speciesTable.hpp"
+
+namespace {
+
+// column layout of the species table
+enum SpeciesCol {NameCol, ValueCol, PlotCol};
+
+}
+
+
+// constructor
+SpeciesTable::SpeciesTable(const MolModel* molModel,
+  const QString& valueLabel, const QString& defaultValue, QWidget* parent) :
+  QTableWidget(0, 3, parent), molModel_(molModel),
+  defaultValue_(defaultValue) {
+
+  setHorizontalHeaderLabels(
+    QStringList() << tr("molecule") << valueLabel << tr("plot"));
+  horizontalHeader()->setStretchLastSection(true);
+  verticalHeader()->hide();
+
+  connect(molModel_, SIGNAL(modelReset()), this, SLOT(refresh()));
+  connect(molModel_, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this,
+    SLOT(refresh()));
+  refresh();
+}
+
+
+// refresh synchronizes the table with the molecule model while keeping the
+// initial values and plot selections of molecules which are still present
+void SpeciesTable::refresh() {
+  std::map<QString, std::pair<QString, Qt::CheckState>> previous;
+  for (int r = 0; r < rowCount(); ++r) {
+    previous[item(r, NameCol)->text()] = std::make_pair(
+      item(r, ValueCol)->text(), item(r, PlotCol)->checkState());
+  }
+
+  const MolList& mols = molModel_->getMols();
+  setRowCount(mols.size());
+  for (size_t r = 0; r < mols.size(); ++r) {
+    QString name = QString::fromStdString(mols[r]->name.str());
+    QString value(defaultValue_);
+    Qt::CheckState plot = Qt::Unchecked;
+    auto it = previous.find(name);
+    if (it != previous.end()) {
+      value = it->second.first;
+      plot = it->second.second;
+    }
+    auto nameItem = new QTableWidgetItem(name);
+    nameItem->setFlags(Qt::ItemIsEnabled);
+    auto plotItem = new QTableWidgetItem;
+    plotItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsUserCheckable);
+    plotItem->setCheckState(plot);
+    setItem(r, NameCol, nameItem);
+    setItem(r, ValueCol, new QTableWidgetItem(value));
+    setItem(r, PlotCol, plotItem);
+  }
+}
+
+
+// value returns the non-negative initial value in row
+double SpeciesTable::value(int row) const {
+  return std::max(0.0, item(row, ValueCol)->text().toDouble());
+}
+
+
+// plotSelection returns the rows selected for plotting. If none are selected
+// the maxAuto rows with the largest initial values x0 are returned.
+std::vector<int> SpeciesTable::plotSelection(const std::vector<double>& x0,
+  int maxAuto) const {
+  std::vector<int> rows;
+  for (int r = 0; r < rowCount(); ++r) {
+    if (item(r, PlotCol)->checkState() == Qt::Checked) {
+      rows.push_back(r);
+    }
+  }
+  if (!rows.empty()) {
+    return rows;
+  }
+  for (int r = 0; r < rowCount(); ++r) {
+    rows.push_back(r);
+  }
+  std::stable_sort(rows.begin(), rows.end(),
+    [&x0](int a, int b) { return x0[a] > x0[b]; });
+  if (rows.size() > size_t(maxAuto)) {
+    rows.resize(maxAuto);
+  }
+  return rows;
+}
@@ -0,0 +1,43 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef SPECIES_TABLE_HPP
+#define SPECIES_TABLE_HPP
+
+#include <vector>
+
+#include <QTableWidget>
+
+class MolModel;
+
+// SpeciesTable lists the molecules of a MolModel together with an editable
+// initial value and a plot selection as used by the simulation previews
+class SpeciesTable : public QTableWidget {
+
+  Q_OBJECT
+
+public:
+
+  SpeciesTable(const MolModel* molModel, const QString& valueLabel,
+    const QString& defaultValue, QWidget* parent = 0);
+
+  double value(int row) const;
+  std::vector<int> plotSelection(const std::vector<double>& x0,
+    int maxAuto) const;
+
+
+public slots:
+
+  void refresh();
+
+
+private:
+
+  const MolModel* molModel_;
+  QString defaultValue_;
+};
+
+#endif
@@ -0,0 +1,253 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include <QDateTime>
+#include <QDoubleValidator>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QSplitter>
+#include <QThread>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+
+#include "molModel.hpp"
+#include "plotWidget.hpp"
+#include "reactionModel.hpp"
+#include "speciesTable.hpp"
+#include "ssaPreviewDialog.hpp"
+#include "ssaSolver.hpp"
+
+namespace {
+
+// maximum number of species plotted if none are selected explicitly
+const int maxAutoPlot = 8;
+
+}
+
+
+// constructor
+SsaPreviewDialog::SsaPreviewDialog(const MolModel* molModel,
+  const ReactTreeModel* reactModel, QWidget* parent) : QDialog(parent),
+  molModel_(molModel), reactModel_(reactModel) {
+
+  setWindowTitle(tr("Stochastic Preview"));
+
+  speciesTable_ = new SpeciesTable(molModel_, tr("initial count"), "100",
+    this);
+
+  tEndEntry_ = new QLineEdit("1.0", this);
+  tEndEntry_->setValidator(new QDoubleValidator(0.0, 1e12, 12, this));
+  volumeEntry_ = new QLineEdit("1.0", this);
+  volumeEntry_->setValidator(new QDoubleValidator(0.0, 1e12, 12, this));
+  numOutputsEntry_ = new QSpinBox(this);
+  numOutputsEntry_->setRange(2, 100000);
+  numOutputsEntry_->setValue(201);
+  numTrajEntry_ = new QSpinBox(this);
+  numTrajEntry_->setRange(1, 10000);
+  numTrajEntry_->setValue(std::max(1, QThread::idealThreadCount()));
+  seedEntry_ = new QSpinBox(this);
+  seedEntry_->setRange(0, 1000000000);
+  seedEntry_->setValue(1);
+
+  auto form = new QFormLayout;
+  form->addRow(tr("end time [s]"), tEndEntry_);
+  form->addRow(tr("volume [um^3]"), volumeEntry_);
+  form->addRow(tr("output points"), numOutputsEntry_);
+  form->addRow(tr("trajectories"), numTrajEntry_);
+  form->addRow(tr("seed"), seedEntry_);
+
+  runButton_ = new QPushButton(tr("Run"), this);
+  cancelButton_ = new QPushButton(tr("Cancel"), this);
+  cancelButton_->setEnabled(false);
+  auto buttons = new QHBoxLayout;
+  buttons->addWidget(runButton_);
+  buttons->addWidget(cancelButton_);
+
+  auto controls = new QWidget(this);
+  auto controlLayout = new QVBoxLayout(controls);
+  controlLayout->addWidget(speciesTable_);
+  controlLayout->addLayout(form);
+  controlLayout->addLayout(buttons);
+
+  plot_ = new PlotWidget(this);
+  plot_->setYLabel(tr("molecules"));
+  auto splitter = new QSplitter(this);
+  splitter->addWidget(controls);
+  splitter->addWidget(plot_);
+  splitter->setStretchFactor(1, 1);
+
+  statusLabel_ = new QLabel(this);
+  auto layout = new QVBoxLayout(this);
+  layout->addWidget(splitter);
+  layout->addWidget(statusLabel_);
+  resize(900, 550);
+
+  connect(runButton_, SIGNAL(clicked()), this, SLOT(run()));
+  connect(cancelButton_, SIGNAL(clicked()), this, SLOT(cancel()));
+  connect(&watcher_, SIGNAL(progressValueChanged(int)), this,
+    SLOT(progress(int)));
+  connect(&watcher_, SIGNAL(finished()), this, SLOT(runFinished()));
+  connect(&compileWatcher_, SIGNAL(finished()), this,
+    SLOT(compileFinished()));
+}
+
+
+// destructor cancels and waits for running trajectories
+SsaPreviewDialog::~SsaPreviewDialog() {
+  cancel();
+  compileWatcher_.waitForFinished();
+  watcher_.waitForFinished();
+}
+
+
+// run takes snapshots of the current molecules and reactions and compiles
+// them on a worker thread. Once compiled, compileFinished starts the
+// requested number of independent trajectories on the global thread pool.
+void SsaPreviewDialog::run() {
+  if (watcher_.isRunning() || compileWatcher_.isRunning()) {
+    return;
+  }
+  double volume = volumeEntry_->text().toDouble() * 1e-15;
+  if (volume <= 0.0) {
+    statusLabel_->setText(tr("the volume has to be positive"));
+    return;
+  }
+  speciesTable_->refresh();
+
+  MolSnapshot mols = molModel_->snapshot();
+  ReactionSnapshot reactions = reactModel_->snapshot();
+  std::vector<double> initial(mols.size());
+  x0_.resize(mols.size());
+  for (size_t i = 0; i < mols.size(); ++i) {
+    initial[i] = speciesTable_->value(i);
+    x0_[i] = std::llround(initial[i]);
+  }
+  plotSpecies_ = speciesTable_->plotSelection(initial, maxAutoPlot);
+  plotNames_.clear();
+  for (auto s : plotSpecies_) {
+    plotNames_ << QString::fromStdString(mols[s].name);
+  }
+
+  opts_ = SsaOptions();
+  opts_.tEnd = tEndEntry_->text().toDouble();
+  opts_.numOutputs = numOutputsEntry_->value();
+  seeds_.clear();
+  uint64_t seed = seedEntry_->value();
+  for (int i = 0; i < numTrajEntry_->value(); ++i) {
+    seeds_ << seed + i;
+  }
+
+  cancelFlag_ = std::make_shared<std::atomic<bool>>(false);
+  compileWatcher_.setFuture(QtConcurrent::run([mols, reactions, volume]() {
+    SsaCompileResult result;
+    std::vector<int> rejected;
+    ReactionNetwork network = compileNetwork(mols, reactions,
+      &result.numInvalid, &rejected);
+    result.numRejected = rejected.size();
+    result.numSpecies = network.numSpecies;
+    result.numReactions = network.numReactions();
+    result.kernel = std::make_shared<const SsaKernel>(network, volume);
+    return result;
+  }));
+
+  runButton_->setEnabled(false);
+  cancelButton_->setEnabled(true);
+  statusLabel_->setText(tr("compiling %1 species and %2 reactions ...")
+    .arg(mols.size()).arg(reactions.size()));
+}
+
+
+// compileFinished starts the trajectories on the compiled network. All
+// trajectories share the read-only compiled kernel.
+void SsaPreviewDialog::compileFinished() {
+  SsaCompileResult compiled = compileWatcher_.result();
+  if (cancelFlag_->load()) {
+    runButton_->setEnabled(true);
+    cancelButton_->setEnabled(false);
+    statusLabel_->setText(tr("simulation canceled"));
+    return;
+  }
+
+  auto kernel = compiled.kernel;
+  auto x0 = x0_;
+  auto opts = opts_;
+  auto cancelFlag = cancelFlag_;
+  std::function<SsaRunResult(const uint64_t&)> simulate =
+    [kernel, x0, opts, cancelFlag](const uint64_t& s) {
+      SsaRunResult result;
+      result.ok = kernel->simulate(x0, opts, s, result.traj, cancelFlag.get(),
+        result.error, &result.numEvents);
+      return result;
+    };
+  startTime_ = QDateTime::currentMSecsSinceEpoch();
+  watcher_.setFuture(QtConcurrent::mapped(seeds_, simulate));
+
+  QString status = tr("simulating %1 trajectories of %2 species and %3 "
+    "reactions ...").arg(seeds_.size()).arg(compiled.numSpecies)
+    .arg(compiled.numReactions);
+  if (compiled.numInvalid > 0) {
+    status += tr(" (%1 reactions with invalid rates are ignored)")
+      .arg(compiled.numInvalid);
+  }
+  if (compiled.numRejected > 0) {
+    status += tr(" (%1 reactions with more than %2 reactants are ignored)")
+      .arg(compiled.numRejected).arg(ReactionNetwork::maxReactants);
+  }
+  statusLabel_->setText(status);
+}
+
+
+// cancel requests all running trajectories to stop
+void SsaPreviewDialog::cancel() {
+  if (cancelFlag_) {
+    cancelFlag_->store(true);
+  }
+}
+
+
+// progress reports the number of finished trajectories
+void SsaPreviewDialog::progress(int done) {
+  statusLabel_->setText(tr("%1 of %2 trajectories finished").arg(done)
+    .arg(watcher_.progressMaximum()));
+}
+
+
+// runFinished overlays all successful trajectories in the plot
+void SsaPreviewDialog::runFinished() {
+  runButton_->setEnabled(true);
+  cancelButton_->setEnabled(false);
+  double seconds = (QDateTime::currentMSecsSinceEpoch() - startTime_) / 1000.0;
+
+  plot_->clear();
+  int64_t events = 0;
+  int numOK = 0;
+  QString error;
+  for (const auto& result : watcher_.future().results()) {
+    if (!result.ok) {
+      error = QString::fromStdString(result.error);
+      continue;
+    }
+    plot_->addTrajectory(result.traj, plotSpecies_, plotNames_);
+    events += result.numEvents;
+    ++numOK;
+  }
+  if (numOK == 0) {
+    statusLabel_->setText(tr("simulation failed: %1").arg(error));
+    return;
+  }
+  statusLabel_->setText(tr("%1 trajectories with %2 events in %3 s "
+    "(%4 events/s)").arg(numOK).arg(events).arg(seconds, 0, 'g', 3)
+    .arg(seconds > 0 ? events / seconds : 0.0, 0, 'g', 3));
+}
@@ -0,0 +1,102 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef SSA_PREVIEW_DIALOG_HPP
+#define SSA_PREVIEW_DIALOG_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QDialog>
+#include <QFutureWatcher>
+#include <QStringList>
+
+#include "reactionNetwork.hpp"
+#include "ssaSolver.hpp"
+
+class MolModel;
+class PlotWidget;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QSpinBox;
+class ReactTreeModel;
+class SpeciesTable;
+
+// SsaRunResult is the outcome of a single stochastic trajectory
+struct SsaRunResult {
+  bool ok = false;
+  std::string error;
+  Trajectory traj;
+  int64_t numEvents = 0;
+};
+
+
+// SsaCompileResult is the reaction network of a run compiled on a worker
+// thread together with the number of reactions ignored due to invalid rates
+// or too many reactants
+struct SsaCompileResult {
+  std::shared_ptr<const SsaKernel> kernel;
+  int numSpecies = 0;
+  int numReactions = 0;
+  int numInvalid = 0;
+  int numRejected = 0;
+};
+
+
+// SsaPreviewDialog runs independent stochastic trajectories of the current
+// reaction network in parallel on all cores and overlays them in a plot
+class SsaPreviewDialog : public QDialog {
+
+  Q_OBJECT
+
+public:
+
+  SsaPreviewDialog(const MolModel* molModel, const ReactTreeModel* reactModel,
+    QWidget* parent = 0);
+  ~SsaPreviewDialog();
+
+
+private slots:
+
+  void run();
+  void cancel();
+  void compileFinished();
+  void progress(int done);
+  void runFinished();
+
+
+private:
+
+  const MolModel* molModel_;
+  const ReactTreeModel* reactModel_;
+
+  SpeciesTable* speciesTable_;
+  QLineEdit* tEndEntry_;
+  QLineEdit* volumeEntry_;
+  QSpinBox* numOutputsEntry_;
+  QSpinBox* numTrajEntry_;
+  QSpinBox* seedEntry_;
+  QPushButton* runButton_;
+  QPushButton* cancelButton_;
+  QLabel* statusLabel_;
+  PlotWidget* plot_;
+
+  QFutureWatcher<SsaCompileResult> compileWatcher_;
+  QFutureWatcher<SsaRunResult> watcher_;
+  std::shared_ptr<std::atomic<bool>> cancelFlag_;
+  std::vector<int> plotSpecies_;
+  QStringList plotNames_;
+  std::vector<int64_t> x0_;
+  SsaOptions opts_;
+  QList<uint64_t> seeds_;
+  int64_t startTime_ = 0;
+};
+
+#endif
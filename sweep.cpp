@@ -0,0 +1,416 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <sstream>
+
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QtConcurrent>
+
+#include "molModel.hpp"
+#include "noteWarnModel.hpp"
+#include "paramModel.hpp"
+#include "reactionModel.hpp"
+#include "sweep.hpp"
+#include "symbolModel.hpp"
+#include "trace.hpp"
+
+namespace {
+
+const QString ratePrefix("rate:");
+
+// writeAssignments writes NAME = value lines where swept names take their
+// value from the current sweep variant
+void writeAssignments(QString& out,
+  const QList<QPair<QString, QString>>& assignments,
+  const SweepDefinition& sweep, const QStringList& values) {
+  for (const auto& a : assignments) {
+    QString value = a.second;
+    for (int i = 0; i < sweep.params.size(); ++i) {
+      if (sweep.params[i].name == a.first) {
+        value = values[i];
+      }
+    }
+    if (value.isEmpty()) {
+      continue;
+    }
+    out += a.first + " = " + value + "\n";
+  }
+}
+
+// parseRange expands "start:stop:count" into count linearly spaced values
+// or, if logScale is set, into count logarithmically spaced values
+bool parseRange(const QString& range, bool logScale, QStringList& values,
+  QString& error) {
+  QStringList parts = range.split(':');
+  bool ok0 = false;
+  bool ok1 = false;
+  bool ok2 = false;
+  double start = 0;
+  double stop = 0;
+  int count = 0;
+  if (parts.size() == 3) {
+    start = parts[0].trimmed().toDouble(&ok0);
+    stop = parts[1].trimmed().toDouble(&ok1);
+    count = parts[2].trimmed().toInt(&ok2);
+  }
+  if (!ok0 || !ok1 || !ok2 || count < 1) {
+    error = QString("invalid range %1, expected start:stop:count").arg(range);
+    return false;
+  }
+  if (count > SweepDefinition::maxVariants) {
+    error = QString("range %1 has more than %2 values").arg(range)
+      .arg(SweepDefinition::maxVariants);
+    return false;
+  }
+  if (logScale && (start <= 0 || stop <= 0)) {
+    error = QString("logarithmic range %1 requires positive bounds")
+      .arg(range);
+    return false;
+  }
+  if (logScale) {
+    start = std::log10(start);
+    stop = std::log10(stop);
+  }
+  for (int i = 0; i < count; ++i) {
+    double v = (count == 1) ? start : start + (stop - start) * i / (count - 1);
+    values << QString::number(logScale ? std::pow(10.0, v) : v, 'g', 12);
+  }
+  return true;
+}
+
+}
+
+
+// numVariants returns the number of model variants generated by the sweep
+// or -1 if there are more than maxVariants. The product of the list sizes is
+// formed in 64 bits and checked after every factor so it can not overflow.
+int SweepDefinition::numVariants() const {
+  if (params.empty()) {
+    return 0;
+  }
+  int64_t num = (mode == SweepMode::Cartesian) ? 1 : params[0].values.size();
+  for (const auto& p : params) {
+    if (mode == SweepMode::Cartesian) {
+      num *= p.values.size();
+    } else {
+      num = std::min(num, int64_t(p.values.size()));
+    }
+    if (num > maxVariants) {
+      return -1;
+    }
+  }
+  return num;
+}
+
+
+// variant returns the parameter values of the variant with the given index
+// in the order of params. For cartesian sweeps the last parameter varies
+// fastest.
+QStringList SweepDefinition::variant(int index) const {
+  QStringList values;
+  if (mode == SweepMode::Zipped) {
+    for (const auto& p : params) {
+      values << p.values[index];
+    }
+    return values;
+  }
+  for (int i = params.size() - 1; i >= 0; --i) {
+    int n = params[i].values.size();
+    values.prepend(params[i].values[index % n]);
+    index /= n;
+  }
+  return values;
+}
+
+
+// parseSweepDefinition parses a sweep given as one parameter per line of the
+// form
+//
+//   NAME = v1, v2, v3        explicit list of values
+//   NAME = start:stop:count  linearly spaced values
+//   NAME = log start:stop:count   logarithmically spaced values
+//
+// Empty lines and lines starting with # are ignored. This function returns
+// true on success and false otherwise in which case error describes the
+// problem.
+bool parseSweepDefinition(const QString& text, SweepMode mode,
+  SweepDefinition& sweep, QString& error) {
+  sweep.mode = mode;
+  sweep.params.clear();
+  int lineNum = 0;
+  for (const auto& rawLine : text.split('\n')) {
+    ++lineNum;
+    QString line = rawLine.trimmed();
+    if (line.isEmpty() || line.startsWith('#')) {
+      continue;
+    }
+    int eq = line.indexOf('=');
+    if (eq <= 0) {
+      error = QString("line %1: expected NAME = values").arg(lineNum);
+      return false;
+    }
+    SweepParam param;
+    param.name = line.left(eq).trimmed();
+    QString spec = line.mid(eq + 1).trimmed();
+    bool logScale = spec.startsWith("log ");
+    if (logScale || (spec.count(':') == 2 && !spec.contains(','))) {
+      if (!parseRange(logScale ? spec.mid(4) : spec, logScale, param.values,
+          error)) {
+        error = QString("line %1: %2").arg(lineNum).arg(error);
+        return false;
+      }
+    } else {
+      for (const auto& v : spec.split(',')) {
+        if (!v.trimmed().isEmpty()) {
+          param.values << v.trimmed();
+        }
+      }
+    }
+    if (param.values.empty()) {
+      error = QString("line %1: no values for %2").arg(lineNum)
+        .arg(param.name);
+      return false;
+    }
+    for (const auto& p : sweep.params) {
+      if (p.name == param.name) {
+        error = QString("line %1: %2 is swept twice").arg(lineNum)
+          .arg(param.name);
+        return false;
+      }
+    }
+    sweep.params << param;
+  }
+  if (sweep.params.empty()) {
+    error = "the sweep does not contain any parameters";
+    return false;
+  }
+  if (mode == SweepMode::Zipped) {
+    for (const auto& p : sweep.params) {
+      if (p.values.size() != sweep.params[0].values.size()) {
+        error = QString("zipped sweeps require value lists of equal length "
+          "but %1 has %2 values").arg(p.name).arg(p.values.size());
+        return false;
+      }
+    }
+  }
+  if (sweep.numVariants() < 0) {
+    error = QString("the sweep generates more than %1 variants")
+      .arg(SweepDefinition::maxVariants);
+    return false;
+  }
+  return true;
+}
+
+
+// constructor copies the model state and renders the notification, warning
+// and molecule sections once
+ModelSnapshot::ModelSnapshot(const MolModel* molModel,
+  const ParamModel* paramModel, const NotificationsModel* noteModel,
+  const WarningsModel* warnModel, const ReactTreeModel* reactModel) :
+  paramTable_(paramModel->table()) {
+  TRACE_SCOPE("ModelSnapshot::ModelSnapshot", "io");
+  symbols_ = molModel->symbols()->definitions();
+  for (int i = 0; i < paramTable_.size(); ++i) {
+    params_ << qMakePair(QString(paramTable_.keyword(i).name),
+      QString::fromStdString(paramTable_.value(i)));
+  }
+
+  QBuffer shared(&sharedSections_);
+  shared.open(QIODevice::WriteOnly);
+  QTextStream out(&shared);
+  writeNotifications(out, noteModel);
+  out << "\n";
+  writeWarnings(out, warnModel);
+  out << "\n";
+  writeMolecules(out, molModel);
+  out << "\n";
+  out.flush();
+
+  reactions_ = collectReactions(molModel, reactModel);
+  std::ostringstream reactOut;
+  writeReactionBlock(reactOut, reactions_);
+  reactionSection_ = QByteArray::fromStdString(reactOut.str());
+}
+
+
+// isRateOf_ checks if the swept parameter paramName refers to the rate of
+// the given reaction
+bool ModelSnapshot::isRateOf_(const QString& paramName, int reaction) const {
+  QString target = paramName.mid(ratePrefix.size());
+  if (target.startsWith('#')) {
+    return target.mid(1).toInt() == reaction + 1;
+  }
+  return reactions_[reaction].name == target.toStdString();
+}
+
+
+// validate checks that all swept parameters exist in the snapshot and that
+// the values of swept keywords are valid for their kind, e.g. integer
+// keywords reject 1.5 and choices have to be spelled as in the keyword
+// table. Valid keyword values are replaced by the text the table writes to
+// the MDL, invalid ones are listed in error.
+bool ModelSnapshot::validate(SweepDefinition& sweep, QString& error) const {
+  const int maxListed = 5;
+  QStringList problems;
+  for (auto& p : sweep.params) {
+    int k = paramTable_.find(p.name.toStdString());
+    if (k < 0) {
+      continue;
+    }
+    KeywordTable table = paramTable_;
+    QStringList invalid;
+    for (auto& v : p.values) {
+      if (table.setValue(k, v.toStdString())) {
+        v = QString::fromStdString(table.value(k));
+      } else {
+        invalid << v;
+      }
+    }
+    if (invalid.size() > maxListed) {
+      invalid = invalid.mid(0, maxListed) << "...";
+    }
+    if (!invalid.empty()) {
+      problems << QString("invalid values for %1: %2").arg(p.name)
+        .arg(invalid.join(", "));
+    }
+  }
+  if (!problems.empty()) {
+    error = problems.join("; ");
+    return false;
+  }
+
+  for (const auto& p : sweep.params) {
+    bool found = false;
+    if (p.name.startsWith(ratePrefix)) {
+      for (int r = 0; r < int(reactions_.size()) && !found; ++r) {
+        found = isRateOf_(p.name, r);
+      }
+    } else {
+      for (const auto& param : params_) {
+        found = found || (param.first == p.name);
+      }
+      for (const auto& symbol : symbols_) {
+        found = found || (symbol.first == p.name);
+      }
+    }
+    if (!found) {
+      error = QString("unknown parameter or reaction %1").arg(p.name);
+      return false;
+    }
+  }
+  return true;
+}
+
+
+// render returns the MDL text of the given sweep variant. Only the symbol
+// and parameter sections and, if any rates are swept, the reaction section
+// are generated, all other sections are shared with the snapshot.
+QByteArray ModelSnapshot::render(const SweepDefinition& sweep,
+  int variant) const {
+  QStringList values = sweep.variant(variant);
+
+  QString params;
+  if (!symbols_.isEmpty()) {
+    writeAssignments(params, symbols_, sweep, values);
+    params += "\n";
+  }
+  writeAssignments(params, params_, sweep, values);
+  params += "\n";
+
+  QByteArray reactionSection = reactionSection_;
+  bool sweepsRates = false;
+  for (const auto& p : sweep.params) {
+    sweepsRates = sweepsRates || p.name.startsWith(ratePrefix);
+  }
+  if (sweepsRates) {
+    std::vector<MdlReaction> reactions = reactions_;
+    for (size_t r = 0; r < reactions.size(); ++r) {
+      for (int i = 0; i < sweep.params.size(); ++i) {
+        if (sweep.params[i].name.startsWith(ratePrefix)
+            && isRateOf_(sweep.params[i].name, r)) {
+          reactions[r].rate = values[i].toStdString();
+        }
+      }
+    }
+    std::ostringstream out;
+    writeReactionBlock(out, reactions);
+    reactionSection = QByteArray::fromStdString(out.str());
+  }
+
+  QByteArray mdl = params.toUtf8();
+  mdl.reserve(mdl.size() + sharedSections_.size() + reactionSection.size());
+  mdl += sharedSections_;
+  mdl += reactionSection;
+  return mdl;
+}
+
+
+// sweepFileName returns the zero padded file name of a sweep variant
+QString sweepFileName(const QString& prefix, int variant, int numVariants) {
+  int width = QString::number(numVariants).size();
+  return QString("%1_%2.mdl").arg(prefix).arg(variant, width, 10, QChar('0'));
+}
+
+
+// writeSweepIndex writes a tab separated file listing the parameter values
+// of every generated variant. This function returns true on success and
+// false otherwise.
+bool writeSweepIndex(const QString& dirName, const QString& prefix,
+  const SweepDefinition& sweep, QString& error) {
+  QFile file(QDir(dirName).filePath(prefix + "_index.tsv"));
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    error = QString("could not open %1").arg(file.fileName());
+    return false;
+  }
+  QTextStream out(&file);
+  out << "file";
+  for (const auto& p : sweep.params) {
+    out << "\t" << p.name;
+  }
+  out << "\n";
+  int numVariants = sweep.numVariants();
+  for (int i = 0; i < numVariants; ++i) {
+    out << sweepFileName(prefix, i, numVariants) << "\t"
+        << sweep.variant(i).join("\t") << "\n";
+  }
+  return true;
+}
+
+
+// writeSweep renders and writes all variants of the sweep in parallel on the
+// global thread pool. The returned future yields one entry per variant
+// which is empty on success and contains an error message otherwise.
+QFuture<QString> writeSweep(std::shared_ptr<const ModelSnapshot> snapshot,
+  const SweepDefinition& sweep, const QString& dirName, const QString& prefix) {
+  int numVariants = sweep.numVariants();
+  QList<int> variants;
+  variants.reserve(numVariants);
+  for (int i = 0; i < numVariants; ++i) {
+    variants << i;
+  }
+  QDir dir(dirName);
+  std::function<QString(const int&)> write =
+    [snapshot, sweep, dir, prefix, numVariants](const int& i) {
+      TRACE_SCOPE("writeSweep variant", "io");
+      QFile file(dir.filePath(sweepFileName(prefix, i, numVariants)));
+      if (!file.open(QIODevice::WriteOnly)) {
+        return QString("could not open %1").arg(file.fileName());
+      }
+      QByteArray mdl = snapshot->render(sweep, i);
+      if (file.write(mdl) != mdl.size()) {
+        return QString("could not write %1").arg(file.fileName());
+      }
+      return QString();
+    };
+  return QtConcurrent::mapped(variants, write);
+}
@@ -0,0 +1,99 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+#include <QFuture>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+#include "io.hpp"
+#include "keywordTable.hpp"
+#include "mdlWriter.hpp"
+
+class MolModel;
+class NotificationsModel;
+class ParamModel;
+class ReactTreeModel;
+class WarningsModel;
+
+
+// SweepMode determines how the value lists of the swept parameters are
+// combined: Cartesian generates all combinations, Zipped pairs up the n-th
+// values of all lists
+enum class SweepMode {Cartesian, Zipped};
+
+
+// SweepParam is a single swept parameter. The name is either a model
+// parameter keyword (e.g. TIME_STEP), a user defined symbol or a reaction
+// rate given as rate:<reaction name> or rate:#<reaction number>.
+struct SweepParam {
+  QString name;
+  QStringList values;
+};
+
+
+// SweepDefinition describes a complete parameter sweep. Sweeps may generate
+// at most maxVariants model variants.
+struct SweepDefinition {
+  static const int maxVariants = 1000000;
+
+  SweepMode mode = SweepMode::Cartesian;
+  QList<SweepParam> params;
+
+  int numVariants() const;
+  QStringList variant(int index) const;
+};
+
+
+bool parseSweepDefinition(const QString& text, SweepMode mode,
+  SweepDefinition& sweep, QString& error);
+
+
+// ModelSnapshot is an immutable copy of everything needed to write MDL files
+// of the current model. Sections which are not affected by a sweep are
+// rendered once and shared by all generated variants.
+class ModelSnapshot {
+
+public:
+
+  ModelSnapshot(const MolModel* molModel, const ParamModel* paramModel,
+    const NotificationsModel* noteModel, const WarningsModel* warnModel,
+    const ReactTreeModel* reactModel);
+
+  bool validate(SweepDefinition& sweep, QString& error) const;
+  QByteArray render(const SweepDefinition& sweep, int variant) const;
+
+
+private:
+
+  bool isRateOf_(const QString& paramName, int reaction) const;
+
+  QList<QPair<QString, QString>> symbols_;
+  KeywordTable paramTable_;
+  QList<QPair<QString, QString>> params_;
+  QByteArray sharedSections_;
+  std::vector<MdlReaction> reactions_;
+  QByteArray reactionSection_;
+};
+
+
+QString sweepFileName(const QString& prefix, int variant, int numVariants);
+
+bool writeSweepIndex(const QString& dirName, const QString& prefix,
+  const SweepDefinition& sweep, QString& error);
+
+QFuture<QString> writeSweep(std::shared_ptr<const ModelSnapshot> snapshot,
+  const SweepDefinition& sweep, const QString& dirName, const QString& prefix);
+
+#endif
@@ -0,0 +1,201 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <QComboBox>
+#include <QDateTime>
+#include <QDir>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPlainTextEdit>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+#include "sweepDialog.hpp"
+
+namespace {
+
+const QString exampleSweep(
+  "# one parameter per line, values are given as\n"
+  "#   NAME = v1, v2, v3\n"
+  "#   NAME = start:stop:count\n"
+  "#   NAME = log start:stop:count\n"
+  "# symbols are swept by name, reaction rates via rate:<name> or\n"
+  "# rate:#<number>\n"
+  "TIME_STEP = 1e-6, 2e-6\n"
+  "ITERATIONS = 1000:5000:5\n");
+
+}
+
+
+// constructor
+SweepDialog::SweepDialog(const MolModel* molModel,
+  const ParamModel* paramModel, const NotificationsModel* noteModel,
+  const WarningsModel* warnModel, const ReactTreeModel* reactModel,
+  QWidget* parent) : QDialog(parent), molModel_(molModel),
+  paramModel_(paramModel), noteModel_(noteModel), warnModel_(warnModel),
+  reactModel_(reactModel) {
+
+  setWindowTitle(tr("Parameter Sweep"));
+
+  definitionEdit_ = new QPlainTextEdit(exampleSweep, this);
+  modeBox_ = new QComboBox(this);
+  modeBox_->addItem(tr("cartesian product"));
+  modeBox_->addItem(tr("zipped"));
+  dirEntry_ = new QLineEdit(QDir::homePath(), this);
+  auto browseButton = new QPushButton(tr("Browse..."), this);
+  auto dirLayout = new QHBoxLayout;
+  dirLayout->addWidget(dirEntry_);
+  dirLayout->addWidget(browseButton);
+  prefixEntry_ = new QLineEdit("sweep", this);
+  countLabel_ = new QLabel(this);
+
+  auto form = new QFormLayout;
+  form->addRow(tr("combine values"), modeBox_);
+  form->addRow(tr("output directory"), dirLayout);
+  form->addRow(tr("file prefix"), prefixEntry_);
+  form->addRow(tr("variants"), countLabel_);
+
+  progressBar_ = new QProgressBar(this);
+  generateButton_ = new QPushButton(tr("Generate"), this);
+  cancelButton_ = new QPushButton(tr("Cancel"), this);
+  cancelButton_->setEnabled(false);
+  auto buttons = new QHBoxLayout;
+  buttons->addWidget(progressBar_);
+  buttons->addWidget(generateButton_);
+  buttons->addWidget(cancelButton_);
+
+  statusLabel_ = new QLabel(this);
+  auto layout = new QVBoxLayout(this);
+  layout->addWidget(definitionEdit_);
+  layout->addLayout(form);
+  layout->addLayout(buttons);
+  layout->addWidget(statusLabel_);
+  resize(600, 450);
+
+  connect(definitionEdit_, SIGNAL(textChanged()), this, SLOT(updateCount()));
+  connect(modeBox_, SIGNAL(currentIndexChanged(int)), this,
+    SLOT(updateCount()));
+  connect(browseButton, SIGNAL(clicked()), this, SLOT(browse()));
+  connect(generateButton_, SIGNAL(clicked()), this, SLOT(generate()));
+  connect(cancelButton_, SIGNAL(clicked()), &watcher_, SLOT(cancel()));
+  connect(&watcher_, SIGNAL(progressValueChanged(int)), this,
+    SLOT(progress(int)));
+  connect(&watcher_, SIGNAL(finished()), this, SLOT(generateFinished()));
+  updateCount();
+}
+
+
+// destructor cancels and waits for outstanding file writes
+SweepDialog::~SweepDialog() {
+  watcher_.cancel();
+  watcher_.waitForFinished();
+}
+
+
+// parse_ parses the sweep definition entered by the user
+bool SweepDialog::parse_(SweepDefinition& sweep, QString& error) const {
+  SweepMode mode = (modeBox_->currentIndex() == 0) ? SweepMode::Cartesian
+    : SweepMode::Zipped;
+  return parseSweepDefinition(definitionEdit_->toPlainText(), mode, sweep,
+    error);
+}
+
+
+// updateCount shows the number of variants of the current definition
+void SweepDialog::updateCount() {
+  SweepDefinition sweep;
+  QString error;
+  if (parse_(sweep, error)) {
+    countLabel_->setText(QString::number(sweep.numVariants()));
+  } else {
+    countLabel_->setText(error);
+  }
+}
+
+
+// browse lets the user pick the output directory
+void SweepDialog::browse() {
+  QString dir = QFileDialog::getExistingDirectory(this,
+    tr("Sweep Output Directory"), dirEntry_->text());
+  if (!dir.isEmpty()) {
+    dirEntry_->setText(dir);
+  }
+}
+
+
+// generate takes a snapshot of the current model and starts writing all
+// sweep variants in the background
+void SweepDialog::generate() {
+  if (watcher_.isRunning()) {
+    return;
+  }
+  SweepDefinition sweep;
+  QString error;
+  if (!parse_(sweep, error)) {
+    statusLabel_->setText(error);
+    return;
+  }
+  auto snapshot = std::make_shared<const ModelSnapshot>(molModel_,
+    paramModel_, noteModel_, warnModel_, reactModel_);
+  if (!snapshot->validate(sweep, error)) {
+    statusLabel_->setText(error);
+    return;
+  }
+  QString dir = dirEntry_->text();
+  if (!QDir().mkpath(dir)) {
+    statusLabel_->setText(tr("could not create %1").arg(dir));
+    return;
+  }
+  if (!writeSweepIndex(dir, prefixEntry_->text(), sweep, error)) {
+    statusLabel_->setText(error);
+    return;
+  }
+
+  startTime_ = QDateTime::currentMSecsSinceEpoch();
+  watcher_.setFuture(writeSweep(snapshot, sweep, dir, prefixEntry_->text()));
+  progressBar_->setRange(0, sweep.numVariants());
+  progressBar_->setValue(0);
+  generateButton_->setEnabled(false);
+  cancelButton_->setEnabled(true);
+  statusLabel_->setText(tr("writing %1 files ...").arg(sweep.numVariants()));
+}
+
+
+// progress updates the progress bar
+void SweepDialog::progress(int done) {
+  progressBar_->setValue(done);
+}
+
+
+// generateFinished reports the number of written files and the first error
+// if any
+void SweepDialog::generateFinished() {
+  generateButton_->setEnabled(true);
+  cancelButton_->setEnabled(false);
+  double seconds = (QDateTime::currentMSecsSinceEpoch() - startTime_) / 1000.0;
+  int numWritten = 0;
+  QString error;
+  for (const auto& result : watcher_.future().results()) {
+    if (result.isEmpty()) {
+      ++numWritten;
+    } else if (error.isEmpty()) {
+      error = result;
+    }
+  }
+  QString status = tr("wrote %1 files in %2 s").arg(numWritten)
+    .arg(seconds, 0, 'g', 3);
+  if (watcher_.isCanceled()) {
+    status += tr(" (canceled)");
+  }
+  if (!error.isEmpty()) {
+    status += tr(", first error: %1").arg(error);
+  }
+  statusLabel_->setText(status);
+}
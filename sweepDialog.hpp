@@ -0,0 +1,70 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef SWEEP_DIALOG_HPP
+#define SWEEP_DIALOG_HPP
+
+#include <QDialog>
+#include <QFutureWatcher>
+
+#include "sweep.hpp"
+
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QPlainTextEdit;
+class QProgressBar;
+class QPushButton;
+
+
+// SweepDialog lets the user define a parameter sweep and writes one MDL file
+// per sweep variant
+class SweepDialog : public QDialog {
+
+  Q_OBJECT
+
+public:
+
+  SweepDialog(const MolModel* molModel, const ParamModel* paramModel,
+    const NotificationsModel* noteModel, const WarningsModel* warnModel,
+    const ReactTreeModel* reactModel, QWidget* parent = 0);
+  ~SweepDialog();
+
+
+private slots:
+
+  void updateCount();
+  void browse();
+  void generate();
+  void progress(int done);
+  void generateFinished();
+
+
+private:
+
+  bool parse_(SweepDefinition& sweep, QString& error) const;
+
+  const MolModel* molModel_;
+  const ParamModel* paramModel_;
+  const NotificationsModel* noteModel_;
+  const WarningsModel* warnModel_;
+  const ReactTreeModel* reactModel_;
+
+  QPlainTextEdit* definitionEdit_;
+  QComboBox* modeBox_;
+  QLineEdit* dirEntry_;
+  QLineEdit* prefixEntry_;
+  QLabel* countLabel_;
+  QProgressBar* progressBar_;
+  QPushButton* generateButton_;
+  QPushButton* cancelButton_;
+  QLabel* statusLabel_;
+
+  QFutureWatcher<QString> watcher_;
+  qint64 startTime_ = 0;
+};
+
+#endif
@@ -0,0 +1,277 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <QColor>
+#include <QRegExp>
+
+#include "symbolModel.hpp"
+#include "trace.hpp"
+
+
+// constructor
+SymbolModel::SymbolModel(QObject* parent) : QAbstractTableModel(parent) {}
+
+
+// rowCount returns the number of defined symbols
+int SymbolModel::rowCount(const QModelIndex& parent) const {
+  return parent.isValid() ? 0 : rows_.size();
+}
+
+
+// columnCount returns the number of columns in the model
+int SymbolModel::columnCount(const QModelIndex& parent) const {
+  return parent.isValid() ? 0 : headerLabels_.size();
+}
+
+
+// headerData prints the table headers
+QVariant SymbolModel::headerData(int section, Qt::Orientation orientation,
+  int role) const {
+  if (role != Qt::DisplayRole) {
+    return QVariant();
+  }
+  if (orientation == Qt::Horizontal) {
+    return headerLabels_[section];
+  }
+  return section + 1;
+}
+
+
+// data returns the name, expression or value of a symbol. Invalid symbols
+// show their error in the value column.
+QVariant SymbolModel::data(const QModelIndex& index, int role) const {
+  if (!index.isValid() || index.row() >= int(rows_.size())) {
+    return QVariant();
+  }
+  int node = rows_[index.row()];
+  if (role == Qt::DisplayRole || role == Qt::EditRole) {
+    switch (index.column()) {
+      case SymCol::Name:
+        return QString::fromStdString(engine_.name(node));
+      case SymCol::Expression:
+        return QString::fromStdString(engine_.text(node));
+      case SymCol::Value:
+        if (engine_.isValid(node)) {
+          return engine_.value(node);
+        }
+        return error(node);
+    }
+  } else if (role == Qt::ForegroundRole && !engine_.isValid(node)) {
+    return QColor(Qt::red);
+  }
+  return QVariant();
+}
+
+
+// flags makes name and expression editable
+Qt::ItemFlags SymbolModel::flags(const QModelIndex& index) const {
+  Qt::ItemFlags flags = QAbstractTableModel::flags(index);
+  if (index.isValid() && index.column() != SymCol::Value) {
+    flags |= Qt::ItemIsSelectable | Qt::ItemIsEditable | Qt::ItemIsEnabled;
+  }
+  return flags;
+}
+
+
+// setData renames a symbol or changes its expression. Renaming a symbol
+// invalidates all expressions still referring to the old name.
+bool SymbolModel::setData(const QModelIndex& index, const QVariant& value,
+  int role) {
+  TRACE_SCOPE("SymbolModel::setData", "model");
+  if (!index.isValid() || role != Qt::EditRole
+      || index.row() >= int(rows_.size())) {
+    return false;
+  }
+  int node = rows_[index.row()];
+  std::string error;
+  std::vector<int> changed;
+  if (index.column() == SymCol::Name) {
+    QString name = value.toString();
+    if (name == QString::fromStdString(engine_.name(node))) {
+      return true;
+    }
+    if (!isValidName_(name)) {
+      return false;
+    }
+    std::string text = engine_.text(node);
+    int newNode = engine_.symbol(name.toStdString());
+    if (!engine_.setExpression(newNode, text, error, changed)) {
+      return false;
+    }
+    engine_.undefine(node, changed);
+    rows_[index.row()] = newNode;
+  } else if (index.column() == SymCol::Expression) {
+    if (!engine_.setExpression(node, value.toString().toStdString(), error,
+        changed)) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  emit dataChanged(this->index(index.row(), SymCol::Name),
+    this->index(index.row(), SymCol::Value));
+  notify_(changed);
+  return true;
+}
+
+
+// removeRows removes symbol definitions. Expressions referring to removed
+// symbols become invalid.
+bool SymbolModel::removeRows(int row, int count, const QModelIndex& parent) {
+  if (parent.isValid() || row < 0 || row + count > int(rows_.size())) {
+    return false;
+  }
+  std::vector<int> changed;
+  beginRemoveRows(parent, row, row + count - 1);
+  for (int i = row; i < row + count; ++i) {
+    engine_.undefine(rows_[i], changed);
+  }
+  rows_.erase(rows_.begin() + row, rows_.begin() + row + count);
+  endRemoveRows();
+  notify_(changed);
+  return true;
+}
+
+
+// addSymbol defines a new symbol. This function returns false if the name
+// is invalid or already defined or if the expression can not be compiled.
+bool SymbolModel::addSymbol(const QString& name, const QString& expression,
+  QString* error) {
+  if (!isValidName_(name)) {
+    if (error != nullptr) {
+      *error = tr("invalid or duplicate symbol name %1").arg(name);
+    }
+    return false;
+  }
+  int node = engine_.symbol(name.toStdString());
+  std::string err;
+  std::vector<int> changed;
+  if (!engine_.setExpression(node, expression.toStdString(), err, changed)) {
+    if (error != nullptr) {
+      *error = QString::fromStdString(err);
+    }
+    return false;
+  }
+  beginInsertRows(QModelIndex(), rows_.size(), rows_.size());
+  rows_.push_back(node);
+  endInsertRows();
+  notify_(changed);
+  return true;
+}
+
+
+// unusedName returns prefix followed by the smallest number which does not
+// yet name a defined symbol
+QString SymbolModel::unusedName(const QString& prefix) const {
+  for (int i = 1; ; ++i) {
+    QString name = prefix + QString::number(i);
+    int node = engine_.findSymbol(name.toStdString());
+    if (node < 0 || !engine_.isDefined(node)) {
+      return name;
+    }
+  }
+}
+
+
+// definitions returns name and expression of all symbols ordered such that
+// each symbol is defined after the symbols it refers to
+QList<QPair<QString, QString>> SymbolModel::definitions() const {
+  QList<QPair<QString, QString>> defs;
+  for (auto node : engine_.definedSymbols()) {
+    defs << qMakePair(QString::fromStdString(engine_.name(node)),
+      QString::fromStdString(engine_.text(node)));
+  }
+  return defs;
+}
+
+
+// isValidName_ checks that name is an identifier which does not name a
+// defined symbol yet
+bool SymbolModel::isValidName_(const QString& name) const {
+  if (!QRegExp("[A-Za-z_][A-Za-z0-9_]*").exactMatch(name)) {
+    return false;
+  }
+  int node = engine_.findSymbol(name.toStdString());
+  return node < 0 || !engine_.isDefined(node);
+}
+
+
+// notify_ refreshes the value column of changed symbols and tells field
+// owners about changed fields
+void SymbolModel::notify_(const std::vector<int>& changed) {
+  QList<int> fields;
+  for (auto node : changed) {
+    if (engine_.name(node).empty()) {
+      fields << node;
+    }
+  }
+  for (size_t row = 0; row < rows_.size(); ++row) {
+    for (auto node : changed) {
+      if (rows_[row] == node) {
+        QModelIndex i = index(row, SymCol::Value);
+        emit dataChanged(i, i);
+      }
+    }
+  }
+  if (!fields.isEmpty()) {
+    emit valuesChanged(fields);
+  }
+}
+
+
+// addField creates a new field for the expression of a diffusion constant
+// or rate. Fields whose expression can not be compiled are invalid.
+int SymbolModel::addField(const QString& expression) {
+  int field = engine_.addField();
+  std::string error;
+  std::vector<int> changed;
+  engine_.setExpression(field, expression.toStdString(), error, changed);
+  return field;
+}
+
+
+// setField compiles and assigns a new expression to field. Expressions with
+// syntax errors are rejected, expressions referring to undefined symbols are
+// accepted but invalid until the symbols are defined.
+bool SymbolModel::setField(int field, const QString& expression,
+  QString& error) {
+  std::string err;
+  std::vector<int> changed;
+  if (!engine_.setExpression(field, expression.toStdString(), err, changed)) {
+    error = QString::fromStdString(err);
+    return false;
+  }
+  return true;
+}
+
+
+// removeField releases a field which is no longer used
+void SymbolModel::removeField(int field) {
+  engine_.removeField(field);
+}
+
+
+// value returns the current value of a symbol or field
+double SymbolModel::value(int node) const {
+  return engine_.value(node);
+}
+
+
+// isValid returns true if the symbol or field evaluates to a number
+bool SymbolModel::isValid(int node) const {
+  return engine_.isValid(node);
+}
+
+
+// error describes why a symbol or field is invalid
+QString SymbolModel::error(int node) const {
+  if (!engine_.isDefined(node)) {
+    return engine_.name(node).empty() ? tr("invalid expression")
+      : tr("undefined symbol %1").arg(QString::fromStdString(
+      engine_.name(node)));
+  }
+  return QString::fromStdString(engine_.error(node));
+}
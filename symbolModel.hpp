@@ -0,0 +1,78 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef SYMBOL_MODEL_HPP
+#define SYMBOL_MODEL_HPP
+
+#include <vector>
+
+#include <QAbstractTableModel>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+#include "expression.hpp"
+
+// SymCol names the columns of the SymbolModel
+namespace SymCol {
+  enum col {Name, Expression, Value};
+}
+
+
+// SymbolModel is the table of user defined symbols (e.g. kf = 1e6) which
+// can be used in the expressions of diffusion constants and reaction rates.
+// Besides the symbols it owns the expressions of these fields so that
+// changing a symbol only re-evaluates the fields depending on it.
+class SymbolModel : public QAbstractTableModel {
+
+  Q_OBJECT
+
+public:
+
+  SymbolModel(QObject* parent = 0);
+
+  int rowCount(const QModelIndex& parent = QModelIndex()) const;
+  int columnCount(const QModelIndex& parent = QModelIndex()) const;
+  QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+  QVariant headerData(int section, Qt::Orientation orientation, int role)
+    const;
+  Qt::ItemFlags flags(const QModelIndex& index) const;
+
+  bool setData(const QModelIndex& index, const QVariant& value,
+    int role = Qt::EditRole);
+  bool removeRows(int row, int count,
+    const QModelIndex& parent = QModelIndex());
+  bool addSymbol(const QString& name, const QString& expression,
+    QString* error = nullptr);
+  QString unusedName(const QString& prefix) const;
+  QList<QPair<QString, QString>> definitions() const;
+
+  // fields
+  int addField(const QString& expression);
+  bool setField(int field, const QString& expression, QString& error);
+  void removeField(int field);
+  double value(int node) const;
+  bool isValid(int node) const;
+  QString error(int node) const;
+
+
+signals:
+
+  void valuesChanged(const QList<int>& nodes);
+
+
+private:
+
+  bool isValidName_(const QString& name) const;
+  void notify_(const std::vector<int>& changed);
+
+  ExpressionEngine engine_;
+  std::vector<int> rows_;
+
+  std::vector<QString> headerLabels_ = {"symbol", "expression", "value"};
+};
+
+#endif
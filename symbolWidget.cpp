@@ -0,0 +1,47 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <set>
+
+#include "symbolWidget.hpp"
+#include "trace.hpp"
+
+
+// constructor. The widgets of the tab are only created by initModel once
+// the tab is first shown.
+SymbolWidget::SymbolWidget(QWidget* parent, Qt::WindowFlags flags) :
+  QWidget(parent, flags) {}
+
+
+// initModel creates the widgets of the tab and initializes the widget's
+// underlying symbol model
+void SymbolWidget::initModel(SymbolModel* model) {
+  TRACE_SCOPE("SymbolWidget::initModel", "ui");
+  setupUi(this);
+  connect(addSymbolButton, SIGNAL(clicked()), this, SLOT(addSymbol()));
+  connect(deleteSymbolButton, SIGNAL(clicked()), this, SLOT(deleteSymbols()));
+  model_ = model;
+  symbolTableView->setModel(model_);
+}
+
+
+// addSymbol adds a new symbol with a unique default name
+void SymbolWidget::addSymbol() {
+  model_->addSymbol(model_->unusedName("p"), "0.0");
+}
+
+
+// deleteSymbols deletes all currently selected symbols. Rows are removed
+// from the bottom up so the remaining row numbers stay valid.
+void SymbolWidget::deleteSymbols() {
+  std::set<int> rows;
+  for (auto& i : symbolTableView->selectionModel()->selectedIndexes()) {
+    rows.insert(i.row());
+  }
+  for (auto it = rows.rbegin(); it != rows.rend(); ++it) {
+    model_->removeRows(*it, 1);
+  }
+}
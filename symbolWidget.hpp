@@ -0,0 +1,35 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef SYMBOL_WIDGET_HPP
+#define SYMBOL_WIDGET_HPP
+
+#include <QWidget>
+
+#include "symbolModel.hpp"
+#include "ui_symbolWidget.h"
+
+
+// SymbolWidget is the main widget for editing user defined symbols
+class SymbolWidget : public QWidget, Ui::SymbolWidget {
+
+  Q_OBJECT
+
+public:
+  SymbolWidget(QWidget* parent = 0, Qt::WindowFlags flags = 0);
+
+  void initModel(SymbolModel* model);
+
+private:
+
+  SymbolModel* model_;
+
+private slots:
+  void addSymbol();
+  void deleteSymbols();
+};
+
+#endif
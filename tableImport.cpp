@@ -0,0 +1,370 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <string>
+
+#include <QMessageBox>
+#include <QSet>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+
+#include "expression.hpp"
+#include "reactionNetwork.hpp"
+#include "tableImport.hpp"
+#include "trace.hpp"
+
+namespace {
+
+// number of lines read from the input before they are parsed
+const int blockSize = 65536;
+
+// minimum number of lines parsed per chunk
+const int minChunkSize = 1024;
+
+// Line is a non-empty input line together with its line number
+struct Line {
+  int number;
+  QString text;
+};
+
+// Chunk is a contiguous range of lines of a block
+struct Chunk {
+  int begin;
+  int end;
+};
+
+// ChunkResult holds the rows parsed from a single Chunk and the line
+// numbers they came from
+template<typename Spec>
+struct ChunkResult {
+  std::vector<Spec> specs;
+  std::vector<int> lines;
+  QStringList errors;
+};
+
+
+// splitFields splits a line of delimited text into trimmed fields. The
+// delimiter is a tab if the line contains one and a comma otherwise so that
+// both spreadsheet clipboard contents and CSV files are accepted. Fields may
+// be enclosed in double quotes; quotes inside quoted fields are doubled.
+QStringList splitFields(const QString& line) {
+  QChar delim = line.contains('\t') ? QChar('\t') : QChar(',');
+  QStringList fields;
+  QString field;
+  bool quoted = false;
+  for (int i = 0; i < line.size(); ++i) {
+    QChar c = line[i];
+    if (quoted) {
+      if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+        field += c;
+        ++i;
+      } else if (c == '"') {
+        quoted = false;
+      } else {
+        field += c;
+      }
+    } else if (c == '"') {
+      quoted = true;
+    } else if (c == delim) {
+      fields << field.trimmed();
+      field.clear();
+    } else {
+      field += c;
+    }
+  }
+  fields << field.trimmed();
+  return fields;
+}
+
+
+// isIdentifier checks that name is a valid MDL identifier
+bool isIdentifier(const QString& name) {
+  if (name.isEmpty() || !name[0].isLetter() || name[0].unicode() > 127) {
+    return false;
+  }
+  for (auto c : name) {
+    if (c.unicode() > 127 || !(c.isLetterOrNumber() || c == '_')) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+// checkExpression checks the syntax of an expression. Symbols are resolved
+// when the row is inserted, undefined ones make the value invalid just like
+// when editing a cell.
+bool checkExpression(const QString& text, QString& error) {
+  Expression expr;
+  std::string err;
+  if (!expr.compile(text.toStdString(), [](const std::string&) { return 0; },
+    err)) {
+    error = QString::fromStdString(err);
+    return false;
+  }
+  return true;
+}
+
+
+// addError records an error for the given line
+void addError(ImportStatus& status, int line, const QString& error) {
+  if (status.numErrors++ < ImportStatus::maxErrors) {
+    status.errors << QString("line %1: %2").arg(line).arg(error);
+  }
+}
+
+
+// readBlocks reads all lines of in and hands them to processBlock in blocks
+// of at most blockSize lines. Empty lines and lines starting with '#' are
+// ignored, as is a header line whose first field equals header.
+void readBlocks(QTextStream& in, const QString& header,
+  std::function<void(const QVector<Line>&)> processBlock) {
+  QVector<Line> lines;
+  lines.reserve(blockSize);
+  int number = 0;
+  bool first = true;
+  while (!in.atEnd()) {
+    lines.clear();
+    while (lines.size() < blockSize && !in.atEnd()) {
+      QString text = in.readLine();
+      ++number;
+      QString trimmed = text.trimmed();
+      if (trimmed.isEmpty() || trimmed.startsWith('#')) {
+        continue;
+      }
+      if (first) {
+        first = false;
+        QString firstField = splitFields(trimmed)[0];
+        if (firstField.compare(header, Qt::CaseInsensitive) == 0) {
+          continue;
+        }
+      }
+      lines.push_back(Line{number, text});
+    }
+    if (!lines.isEmpty()) {
+      processBlock(lines);
+    }
+  }
+}
+
+
+// parseBlock parses the lines of a block in parallel chunks. parseRow
+// converts the fields of a line into a Spec and returns false with an error
+// message for invalid rows. parseRow must only read shared state. The chunk
+// results are in line order.
+template<typename Spec>
+QList<ChunkResult<Spec>> parseBlock(const QVector<Line>& lines,
+  std::function<bool(const QStringList&, Spec&, QString&)> parseRow) {
+  QList<Chunk> chunks;
+  int numChunks = 4 * std::max(1, QThread::idealThreadCount());
+  int chunkSize = std::max(minChunkSize, lines.size() / numChunks);
+  for (int b = 0; b < lines.size(); b += chunkSize) {
+    chunks << Chunk{b, std::min(lines.size(), b + chunkSize)};
+  }
+
+  std::function<ChunkResult<Spec>(const Chunk&)> parse =
+    [&lines, &parseRow](const Chunk& chunk) {
+      ChunkResult<Spec> res;
+      res.specs.reserve(chunk.end - chunk.begin);
+      res.lines.reserve(chunk.end - chunk.begin);
+      QString error;
+      for (int i = chunk.begin; i < chunk.end; ++i) {
+        Spec spec;
+        if (parseRow(splitFields(lines[i].text), spec, error)) {
+          res.specs.push_back(std::move(spec));
+          res.lines.push_back(lines[i].number);
+        } else {
+          res.errors << QString("line %1: %2").arg(lines[i].number)
+            .arg(error);
+        }
+      }
+      return res;
+    };
+  return QtConcurrent::blockingMapped<QList<ChunkResult<Spec>>>(chunks, parse);
+}
+
+
+// mergeErrors adds the errors of a chunk to status
+template<typename Spec>
+void mergeErrors(const ChunkResult<Spec>& chunk, ImportStatus& status) {
+  for (const auto& e : chunk.errors) {
+    if (status.numErrors++ < ImportStatus::maxErrors) {
+      status.errors << e;
+    }
+  }
+}
+
+
+// parseMolecule parses a row of a molecule table
+bool parseMolecule(const QStringList& fields, MolSpec& spec, QString& error) {
+  if (fields.size() < 2 || fields.size() > 3) {
+    error = QObject::tr("expected name, D and optional type but found %1 "
+      "columns").arg(fields.size());
+    return false;
+  }
+  spec.name = fields[0];
+  if (!isIdentifier(spec.name)) {
+    error = QObject::tr("invalid molecule name '%1'").arg(spec.name);
+    return false;
+  }
+  spec.D = fields[1];
+  QString exprError;
+  if (!checkExpression(spec.D, exprError)) {
+    error = QObject::tr("invalid D '%1': %2").arg(spec.D).arg(exprError);
+    return false;
+  }
+  QString type = (fields.size() == 3) ? fields[2].toUpper() : QString();
+  if (type.isEmpty() || type == "3D" || type == "VOL") {
+    spec.type = MolType::VOL;
+  } else if (type == "2D" || type == "SURF") {
+    spec.type = MolType::SURF;
+  } else {
+    error = QObject::tr("invalid molecule type '%1'").arg(fields[2]);
+    return false;
+  }
+  return true;
+}
+
+
+// parseMolecules resolves a '+' separated list of molecule names via the
+// name index of the molecule model. NULL is accepted as the only entry if
+// allowNull is set and yields a single null handle.
+bool parseMolecules(const QString& field, const MolModel* molModel,
+  bool allowNull, std::vector<MolHandle>& mols, QString& error) {
+  mols.clear();
+  if (allowNull && field.compare("NULL", Qt::CaseInsensitive) == 0) {
+    mols.push_back(MolHandle());
+    return true;
+  }
+  for (const auto& name : field.split('+')) {
+    const Molecule* mol = molModel->getMolecule(name.trimmed());
+    if (mol == nullptr) {
+      error = QObject::tr("unknown molecule '%1'").arg(name.trimmed());
+      return false;
+    }
+    mols.push_back(mol->handle);
+  }
+  return true;
+}
+
+
+// parseReaction parses a row of a reaction table
+bool parseReaction(const QStringList& fields, const MolModel* molModel,
+  ReactionSpec& spec, QString& error) {
+  if (fields.size() < 3 || fields.size() > 4) {
+    error = QObject::tr("expected reactants, products, rate and optional "
+      "name but found %1 columns").arg(fields.size());
+    return false;
+  }
+  if (!parseMolecules(fields[0], molModel, false, spec.reactants, error) ||
+    !parseMolecules(fields[1], molModel, true, spec.products, error)) {
+    return false;
+  }
+  if (spec.reactants.size() > size_t(ReactionNetwork::maxReactants)) {
+    error = QObject::tr("more than %1 reactants")
+      .arg(ReactionNetwork::maxReactants);
+    return false;
+  }
+  QString exprError;
+  if (!checkExpression(fields[2], exprError)) {
+    error = QObject::tr("invalid rate '%1': %2").arg(fields[2])
+      .arg(exprError);
+    return false;
+  }
+  spec.rate = fields[2].toStdString();
+  if (fields.size() == 4) {
+    spec.name = fields[3].toStdString();
+  }
+  return true;
+}
+
+}
+
+
+// importMolecules reads a molecule table from in. The input is read in
+// blocks whose lines are parsed and checked in parallel; names clashing with
+// existing molecules or earlier rows are rejected afterwards in line order.
+// The returned molecules can be inserted via MolModel::addMols.
+MolImport importMolecules(QTextStream& in, const MolModel* molModel) {
+  TRACE_SCOPE("importMolecules", "io");
+  MolImport result;
+  QSet<QString> names;
+  std::function<bool(const QStringList&, MolSpec&, QString&)> parseRow =
+    parseMolecule;
+  readBlocks(in, "name", [&](const QVector<Line>& lines) {
+    result.numRows += lines.size();
+    for (auto& chunk : parseBlock<MolSpec>(lines, parseRow)) {
+      mergeErrors(chunk, result);
+      for (size_t i = 0; i < chunk.specs.size(); ++i) {
+        MolSpec& spec = chunk.specs[i];
+        if (molModel->haveMol(spec.name) || names.contains(spec.name)) {
+          addError(result, chunk.lines[i],
+            QObject::tr("molecule '%1' already exists").arg(spec.name));
+          continue;
+        }
+        names.insert(spec.name);
+        result.mols.push_back(std::move(spec));
+      }
+    }
+  });
+  return result;
+}
+
+
+// importReactions reads a reaction table from in. The input is read in
+// blocks whose lines are parsed in parallel; reactants and products are
+// resolved via the name index of the molecule model. The returned
+// reactions can be inserted via ReactTreeModel::addReactions.
+ReactionImport importReactions(QTextStream& in, const MolModel* molModel) {
+  TRACE_SCOPE("importReactions", "io");
+  ReactionImport result;
+  std::function<bool(const QStringList&, ReactionSpec&, QString&)> parseRow =
+    [molModel](const QStringList& fields, ReactionSpec& spec, QString& error) {
+      return parseReaction(fields, molModel, spec, error);
+    };
+  readBlocks(in, "reactants", [&](const QVector<Line>& lines) {
+    result.numRows += lines.size();
+    for (auto& chunk : parseBlock<ReactionSpec>(lines, parseRow)) {
+      mergeErrors(chunk, result);
+      std::move(chunk.specs.begin(), chunk.specs.end(),
+        std::back_inserter(result.reactions));
+    }
+  });
+  return result;
+}
+
+
+// showImportReport tells the user how many items of an import were added
+// and lists the rows which were skipped. Valid rows which were not added
+// duplicate existing items.
+void showImportReport(QWidget* parent, const QString& title,
+  const QString& items, int numAdded, const ImportStatus& status) {
+  QString msg = QObject::tr("Added %1 of %2 %3.").arg(numAdded)
+    .arg(status.numRows).arg(items);
+  int numDuplicates = status.numRows - status.numErrors - numAdded;
+  if (numDuplicates > 0) {
+    msg += " " + QObject::tr("%1 rows were skipped as duplicates.")
+      .arg(numDuplicates);
+  }
+  if (status.numErrors == 0) {
+    QMessageBox::information(parent, title, msg);
+    return;
+  }
+  QString details = status.errors.join("\n");
+  if (status.numErrors > status.errors.size()) {
+    details += QObject::tr("\n... and %1 more")
+      .arg(status.numErrors - status.errors.size());
+  }
+  QMessageBox box(QMessageBox::Warning, title, msg + " " +
+    QObject::tr("%1 invalid rows were skipped.").arg(status.numErrors),
+    QMessageBox::Close, parent);
+  box.setDetailedText(details);
+  box.exec();
+}
@@ -0,0 +1,55 @@
+// Copyright 2015 Markus Dittrich. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+//
+// mcellGUI is a simulation GUI for MCell (www.mcell.org)
+
+#ifndef TABLE_IMPORT_HPP
+#define TABLE_IMPORT_HPP
+
+#include <vector>
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+#include "molModel.hpp"
+#include "reactionModel.hpp"
+
+class QWidget;
+
+
+// ImportStatus summarizes the rows of a table import. Invalid rows are
+// skipped and reported in errors as "line N: problem"; only the first
+// maxErrors of them are kept.
+struct ImportStatus {
+  static const int maxErrors = 200;
+
+  int numRows = 0;
+  int numErrors = 0;
+  QStringList errors;
+};
+
+
+// MolImport holds the molecules read from a table with the columns
+// name, D and optionally type (3D/VOL or 2D/SURF, default 3D)
+struct MolImport : ImportStatus {
+  std::vector<MolSpec> mols;
+};
+
+
+// ReactionImport holds the reactions read from a table with the columns
+// reactants, products, rate and optionally name. Reactants and products are
+// separated by '+', NULL denotes the absence of products.
+struct ReactionImport : ImportStatus {
+  std::vector<ReactionSpec> reactions;
+};
+
+
+MolImport importMolecules(QTextStream& in, const MolModel* molModel);
+ReactionImport importReactions(QTextStream& in, const MolModel* molModel);
+
+void showImportReport(QWidget* parent, const QString& title,
+  const QString& items, int numAdded, const ImportStatus& status);
+
+#endif